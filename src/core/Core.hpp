@@ -6,6 +6,7 @@
 #include <string>
 #include <string_view>
 #include <deque>
+#include <list>
 #include <vector>
 #include <set>
 #include <array>
@@ -26,4 +27,5 @@
 #include "core/Quaternion.hpp"
 #include "core/Vector2.hpp"
 #include "core/Vector3.hpp"
-#include "core/Log.hpp"
\ No newline at end of file
+#include "core/Log.hpp"
+#include "core/Profiler.hpp"
\ No newline at end of file
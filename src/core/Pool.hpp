@@ -51,6 +51,12 @@ public:
         for (auto& value: m_Free) fn(value);
     }
 
+    template<typename Fn>
+    void ForEachActive(Fn&& fn)
+    {
+        for (auto& value: m_Active) fn(value);
+    }
+
 private:
     std::vector<T> m_Active;
     std::vector<T> m_Free;
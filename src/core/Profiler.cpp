@@ -0,0 +1,185 @@
+#include "Profiler.hpp"
+
+#include "core/Utility.hpp"
+
+namespace lucent
+{
+
+static std::atomic<uint64> s_NextProfilerId{ 0 };
+
+Profiler::Profiler()
+    : m_Id(s_NextProfilerId.fetch_add(1, std::memory_order_relaxed))
+    , m_Epoch(std::chrono::steady_clock::now())
+{
+}
+
+void Profiler::Record(const char* name, uint64 start, uint64 end)
+{
+    auto& buffer = GetThreadBuffer();
+
+    auto head = buffer.head.load(std::memory_order_relaxed);
+    buffer.events[head % kEventsPerThread] = ProfileEvent{ name, start, end };
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::MarkFrame()
+{
+    auto now = Now();
+
+    std::lock_guard lock(m_Mutex);
+    m_FrameStarts[m_NumFrameMarkers % m_FrameStarts.size()] = now;
+    ++m_NumFrameMarkers;
+}
+
+void Profiler::SetThreadName(std::string name)
+{
+    auto& buffer = GetThreadBuffer();
+
+    std::lock_guard lock(m_Mutex);
+    buffer.name = std::move(name);
+}
+
+std::vector<ProfileFrame> Profiler::GetFrames(uint32 maxFrames) const
+{
+    std::lock_guard lock(m_Mutex);
+
+    // Each marker ends the frame started by the one before it
+    auto numCompleted = m_NumFrameMarkers > 0 ? m_NumFrameMarkers - 1 : 0;
+    auto numFrames = Min<uint64>(numCompleted, Min(maxFrames, kMaxFrames));
+
+    std::vector<ProfileFrame> frames;
+    frames.reserve(numFrames);
+    for (auto i = numCompleted - numFrames; i < numCompleted; ++i)
+    {
+        frames.push_back(ProfileFrame{
+            .index = i,
+            .start = m_FrameStarts[i % m_FrameStarts.size()],
+            .end = m_FrameStarts[(i + 1) % m_FrameStarts.size()]
+        });
+    }
+    return frames;
+}
+
+std::vector<ProfileEvent> Profiler::GetEvents(uint64 start, uint64 end) const
+{
+    std::vector<ProfileEvent> events;
+    std::vector<ProfileEvent> copied;
+
+    std::lock_guard lock(m_Mutex);
+    for (auto& buffer: m_Threads)
+    {
+        copied.clear();
+        CopyEvents(*buffer, copied);
+        std::copy_if(copied.begin(), copied.end(), std::back_inserter(events), [&](const ProfileEvent& event)
+        { return event.end >= start && event.start <= end; });
+    }
+    return events;
+}
+
+std::string Profiler::DumpChromeTrace(uint32 numFrames) const
+{
+    auto frames = GetFrames(numFrames);
+
+    // Without frame markers, export everything still in the rings
+    uint64 start = frames.empty() ? 0 : frames.front().start;
+    uint64 end = frames.empty() ? Now() : frames.back().end;
+
+    // Trace timestamps are in microseconds
+    auto us = [](uint64 ns) { return static_cast<double>(ns) * 1e-3; };
+
+    std::string json = "{\"traceEvents\":[";
+    auto separator = "\n";
+    auto append = [&](const std::string& event)
+    {
+        json += separator;
+        json += event;
+        separator = ",\n";
+    };
+
+    for (auto& frame: frames)
+    {
+        append(fmt::format("{{\"name\":\"Frame {}\",\"cat\":\"frame\",\"ph\":\"i\",\"s\":\"g\",\"ts\":{:.3f},"
+            "\"pid\":1,\"tid\":0}}", frame.index, us(frame.start)));
+    }
+
+    std::vector<ProfileEvent> events;
+
+    std::lock_guard lock(m_Mutex);
+    for (auto& buffer: m_Threads)
+    {
+        append(fmt::format("{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},"
+            "\"args\":{{\"name\":\"{}\"}}}}", buffer->index, EscapeJson(buffer->name)));
+
+        events.clear();
+        CopyEvents(*buffer, events);
+        for (auto& event: events)
+        {
+            if (event.end < start || event.start > end)
+                continue;
+
+            append(fmt::format("{{\"name\":\"{}\",\"cat\":\"cpu\",\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f},"
+                "\"pid\":1,\"tid\":{}}}", EscapeJson(event.name), us(event.start), us(event.end - event.start),
+                buffer->index));
+        }
+    }
+
+    json += "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return json;
+}
+
+Profiler::ThreadBuffer& Profiler::GetThreadBuffer()
+{
+    // Cached for the profiler used last by this thread, which is almost always the global one
+    static thread_local uint64 t_ProfilerId = ~0ull;
+    static thread_local ThreadBuffer* t_Buffer = nullptr;
+
+    if (t_ProfilerId != m_Id)
+    {
+        t_Buffer = &FindThreadBuffer();
+        t_ProfilerId = m_Id;
+    }
+    return *t_Buffer;
+}
+
+Profiler::ThreadBuffer& Profiler::FindThreadBuffer()
+{
+    auto thread = std::this_thread::get_id();
+
+    std::lock_guard lock(m_Mutex);
+    for (auto& buffer: m_Threads)
+    {
+        if (buffer->thread == thread)
+            return *buffer;
+    }
+
+    auto index = static_cast<uint32>(m_Threads.size());
+    auto& buffer = m_Threads.emplace_back(std::make_unique<ThreadBuffer>());
+    buffer->thread = thread;
+    buffer->index = index;
+    buffer->name = fmt::format("Thread {}", index);
+    buffer->events = std::make_unique<ProfileEvent[]>(kEventsPerThread);
+    return *buffer;
+}
+
+void Profiler::CopyEvents(const ThreadBuffer& buffer, std::vector<ProfileEvent>& events)
+{
+    auto end = buffer.head.load(std::memory_order_acquire);
+    auto begin = end > kEventsPerThread ? end - kEventsPerThread : 0;
+
+    auto offset = events.size();
+    for (auto i = begin; i < end; ++i)
+        events.push_back(buffer.events[i % kEventsPerThread]);
+
+    // The owning thread keeps recording, so may have overwritten the oldest events while they were copied, or be
+    // part way through writing the slot after the newest
+    auto head = buffer.head.load(std::memory_order_acquire) + 1;
+    auto firstIntact = head > kEventsPerThread ? head - kEventsPerThread : 0;
+    if (firstIntact > begin)
+    {
+        auto numOverwritten = Min(firstIntact - begin, end - begin);
+        events.erase(events.begin() + static_cast<ptrdiff_t>(offset),
+            events.begin() + static_cast<ptrdiff_t>(offset + numOverwritten));
+    }
+}
+
+}
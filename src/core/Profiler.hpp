@@ -0,0 +1,143 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#define LC_PROFILE_CONCAT_IMPL(a, b) a##b
+#define LC_PROFILE_CONCAT(a, b) LC_PROFILE_CONCAT_IMPL(a, b)
+
+#ifndef LC_DISABLE_PROFILING
+#define LC_PROFILE_ZONE(name) ::lucent::ProfileZone LC_PROFILE_CONCAT(lcProfileZone, __LINE__)(name)
+#define LC_PROFILE_FRAME() ::lucent::Profiler::Instance().MarkFrame()
+#define LC_PROFILE_THREAD(name) ::lucent::Profiler::Instance().SetThreadName(name)
+#else
+#define LC_PROFILE_ZONE(name) (void)0
+#define LC_PROFILE_FRAME() (void)0
+#define LC_PROFILE_THREAD(name) (void)0
+#endif
+
+namespace lucent
+{
+
+//! Zone of CPU time recorded by a thread, in nanoseconds since the profiler was created
+struct ProfileEvent
+{
+    const char* name;
+    uint64 start;
+    uint64 end;
+};
+
+//! Time between two frame markers, in nanoseconds since the profiler was created
+struct ProfileFrame
+{
+    uint64 index;
+    uint64 start;
+    uint64 end;
+};
+
+//! Records scoped zones of CPU time into a ring of recent events per thread
+//! Each thread only writes to its own ring, so recording a zone takes no locks once the thread has recorded its first.
+//! Zone names must outlive the profiler, e.g. string literals. Exports skip events overwritten while being copied.
+class Profiler
+{
+public:
+    static constexpr uint32 kEventsPerThread = 1u << 16;
+    static constexpr uint32 kMaxFrames = 128;
+
+    Profiler();
+
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    static Profiler& Instance()
+    {
+        static Profiler s_Profiler;
+        return s_Profiler;
+    }
+
+    //! Zones which start while disabled aren't recorded
+    void SetEnabled(bool enabled) { m_Enabled.store(enabled, std::memory_order_relaxed); }
+    bool IsEnabled() const { return m_Enabled.load(std::memory_order_relaxed); }
+
+    //! Nanoseconds since the profiler was created
+    uint64 Now() const
+    {
+        auto elapsed = std::chrono::steady_clock::now() - m_Epoch;
+        return static_cast<uint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+
+    void Record(const char* name, uint64 start, uint64 end);
+
+    //! Ends the current frame and starts the next, called once per frame from the same thread
+    void MarkFrame();
+
+    //! Names the calling thread in exported traces
+    void SetThreadName(std::string name);
+
+    //! Most recent completed frames, oldest first
+    std::vector<ProfileFrame> GetFrames(uint32 maxFrames = kMaxFrames) const;
+
+    //! Events of all threads overlapping the given time range, in order of each thread's events then thread
+    std::vector<ProfileEvent> GetEvents(uint64 start, uint64 end) const;
+
+    //! Trace event JSON of the most recent completed frames, viewable in chrome://tracing or Perfetto
+    std::string DumpChromeTrace(uint32 numFrames = kMaxFrames) const;
+
+private:
+    struct ThreadBuffer
+    {
+        std::thread::id thread;
+        uint32 index;
+        std::string name;
+
+        // Written only by the owning thread, head counts every event ever written
+        std::unique_ptr<ProfileEvent[]> events;
+        std::atomic<uint64> head{ 0 };
+    };
+
+    ThreadBuffer& GetThreadBuffer();
+    ThreadBuffer& FindThreadBuffer();
+
+    // Copies the events which weren't overwritten during the copy, oldest first
+    static void CopyEvents(const ThreadBuffer& buffer, std::vector<ProfileEvent>& events);
+
+private:
+    // Unique for the lifetime of the process, identifying the profiler cached by each thread
+    uint64 m_Id;
+    std::chrono::steady_clock::time_point m_Epoch;
+    std::atomic<bool> m_Enabled{ true };
+
+    // Guards registration of threads and their names, and the frame ring
+    mutable std::mutex m_Mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> m_Threads;
+
+    std::array<uint64, kMaxFrames + 1> m_FrameStarts{};
+    uint64 m_NumFrameMarkers = 0;
+};
+
+//! Records the time between its construction and destruction as a zone of the global profiler
+class ProfileZone
+{
+public:
+    explicit ProfileZone(const char* name)
+        : m_Name(Profiler::Instance().IsEnabled() ? name : nullptr)
+        , m_Start(m_Name ? Profiler::Instance().Now() : 0)
+    {}
+
+    ~ProfileZone()
+    {
+        if (m_Name)
+            Profiler::Instance().Record(m_Name, m_Start, Profiler::Instance().Now());
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    const char* m_Name;
+    uint64 m_Start;
+};
+
+}
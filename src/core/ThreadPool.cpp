@@ -0,0 +1,60 @@
+#include "core/ThreadPool.hpp"
+
+namespace lucent
+{
+
+ThreadPool::ThreadPool(uint32 numThreads)
+{
+    LC_ASSERT(numThreads > 0);
+
+    m_Threads.reserve(numThreads);
+    for (uint32 i = 0; i < numThreads; ++i)
+    {
+        m_Threads.emplace_back([this, i]()
+        {
+            LC_PROFILE_THREAD(fmt::format("Worker {}", i));
+            Run();
+        });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(m_Mutex);
+        m_Stopping = true;
+    }
+    m_JobReady.notify_all();
+
+    for (auto& thread: m_Threads)
+        thread.join();
+}
+
+uint32 ThreadPool::DefaultThreadCount()
+{
+    // Leave the calling thread free to record and submit work
+    auto hardwareThreads = std::thread::hardware_concurrency();
+    return hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+}
+
+void ThreadPool::Run()
+{
+    while (true)
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock lock(m_Mutex);
+            m_JobReady.wait(lock, [this]() { return m_Stopping || !m_Jobs.empty(); });
+
+            // Drain remaining jobs before exiting so no future is left unsatisfied
+            if (m_Jobs.empty())
+                return;
+
+            job = std::move(m_Jobs.front());
+            m_Jobs.pop_front();
+        }
+        job();
+    }
+}
+
+}
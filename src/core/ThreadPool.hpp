@@ -0,0 +1,55 @@
+#pragma once
+
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <thread>
+
+namespace lucent
+{
+
+//! Fixed set of worker threads executing submitted jobs in FIFO order
+class ThreadPool
+{
+public:
+    explicit ThreadPool(uint32 numThreads = DefaultThreadCount());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    //! Queues a job for execution, returning a future for its result
+    template<typename F>
+    auto Submit(F&& job) -> std::future<std::invoke_result_t<F>>;
+
+    uint32 GetNumThreads() const { return static_cast<uint32>(m_Threads.size()); }
+
+    static uint32 DefaultThreadCount();
+
+private:
+    void Run();
+
+private:
+    std::vector<std::thread> m_Threads;
+    std::deque<std::function<void()>> m_Jobs;
+    std::mutex m_Mutex;
+    std::condition_variable m_JobReady;
+    bool m_Stopping = false;
+};
+
+template<typename F>
+auto ThreadPool::Submit(F&& job) -> std::future<std::invoke_result_t<F>>
+{
+    // std::function requires a copyable target, so share ownership of the task
+    using Result = std::invoke_result_t<F>;
+    auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(job));
+    auto future = task->get_future();
+    {
+        std::lock_guard lock(m_Mutex);
+        m_Jobs.emplace_back([task]() { (*task)(); });
+    }
+    m_JobReady.notify_one();
+    return future;
+}
+
+}
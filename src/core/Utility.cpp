@@ -2,6 +2,9 @@
 
 #include <iostream>
 #include <fstream>
+#include <filesystem>
+#include <cstdlib>
+#include <atomic>
 
 namespace lucent
 {
@@ -28,4 +31,79 @@ std::string ReadFile(const std::string& path, std::ios::openmode mode, bool* suc
     return buf;
 }
 
+bool WriteFile(const std::string& path, std::string_view data, std::ios::openmode mode)
+{
+    auto parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty())
+    {
+        std::error_code error;
+        std::filesystem::create_directories(parent, error);
+        if (error)
+            return false;
+    }
+
+    std::ofstream file(path, mode | std::ios::trunc);
+    if (!file.is_open())
+        return false;
+
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    return file.good();
+}
+
+bool WriteFileAtomic(const std::string& path, std::string_view data, std::ios::openmode mode)
+{
+    // Unique per call so concurrent writers of the same path don't share a temporary
+    static std::atomic<uint64> s_Counter = 0;
+    auto tempPath = fmt::format("{}.{}.tmp", path, s_Counter.fetch_add(1));
+
+    if (!WriteFile(tempPath, data, mode))
+    {
+        std::error_code error;
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    if (error)
+    {
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+    return true;
+}
+
+std::string EscapeJson(std::string_view text)
+{
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (char c: text)
+    {
+        if (c == '"' || c == '\\')
+            escaped += '\\';
+
+        if (static_cast<unsigned char>(c) < 0x20)
+            escaped += fmt::format("\\u{:04x}", static_cast<int>(c));
+        else
+            escaped += c;
+    }
+    return escaped;
+}
+
+const std::string& GetCacheDirectory()
+{
+    static const std::string directory = []()
+    {
+        auto env = std::getenv("LC_CACHE_ROOT");
+        std::string path = env ? env : "cache";
+
+        // Ensure path ends with separator
+        if (!path.empty() && !path.ends_with('/'))
+            path += '/';
+
+        return path;
+    }();
+    return directory;
+}
+
 }
@@ -7,4 +7,17 @@ namespace lucent
 
 std::string ReadFile(const std::string& path, std::ios::openmode mode = std::ios::in, bool* success = nullptr);
 
-}
\ No newline at end of file
+//! Writes data to the given path, creating any missing parent directories
+bool WriteFile(const std::string& path, std::string_view data, std::ios::openmode mode = std::ios::out);
+
+//! Writes data to a temporary file beside the given path and renames it into place, so readers
+//! never observe a partially written file
+bool WriteFileAtomic(const std::string& path, std::string_view data, std::ios::openmode mode = std::ios::out);
+
+//! Escapes quotes, backslashes and control characters for use inside a JSON string
+std::string EscapeJson(std::string_view text);
+
+//! Directory used to persist data between runs (LC_CACHE_ROOT, or "cache" in the working directory)
+const std::string& GetCacheDirectory();
+
+}
@@ -1,5 +1,6 @@
 #include "DebugConsole.hpp"
 
+#include "core/Utility.hpp"
 #include "rendering/Engine.hpp"
 
 using namespace std::literals;
@@ -157,6 +158,137 @@ void DebugConsole::Update(const InputState& input, float dt)
             if (text == "r")
                 m_Device->ReloadPipelines();
 
+            if (text == "graph")
+            {
+                auto& graph = m_Engine.GetSceneRenderer()->GetFrameGraph();
+                auto path = GetCacheDirectory() + "framegraph.dot";
+                if (WriteFile(path, graph.DumpGraphviz()))
+                    LC_INFO("Frame graph written to {}", path);
+
+                LC_INFO("{}", graph.Dump());
+            }
+
+            if (text.starts_with("present "))
+            {
+                static const std::unordered_map<std::string, PresentMode> kModes = {
+                    { "fifo", PresentMode::kFifo },
+                    { "relaxed", PresentMode::kFifoRelaxed },
+                    { "mailbox", PresentMode::kMailbox },
+                    { "immediate", PresentMode::kImmediate }
+                };
+
+                auto it = kModes.find(text.substr(8));
+                if (it != kModes.end())
+                {
+                    auto settings = m_Device->GetSwapchainSettings();
+                    settings.presentMode = it->second;
+                    m_Device->SetSwapchainSettings(settings);
+                }
+                else
+                {
+                    LC_WARN("Present modes: fifo, relaxed, mailbox, immediate");
+                }
+            }
+
+            if (text.starts_with("swapchain "))
+            {
+                auto settings = m_Device->GetSwapchainSettings();
+                settings.imageCount = static_cast<uint32>(std::strtoul(text.c_str() + 10, nullptr, 10));
+                m_Device->SetSwapchainSettings(settings);
+            }
+
+            if (text == "gpu" || text == "gpu dump")
+            {
+                auto& profiler = m_Engine.GetSceneRenderer()->GetGpuProfiler();
+                LC_INFO("GPU frame: {:.2f} ms", profiler.GetAverageFrameMs());
+                for (auto& pass: profiler.GetPassStats())
+                {
+                    LC_INFO("{:>{}}{}: {:.3f} min, {:.3f} avg, {:.3f} max ms", "", pass.depth * 2, pass.label,
+                        pass.minMs, pass.avgMs, pass.maxMs);
+                }
+
+                if (text == "gpu dump")
+                {
+                    auto csvPath = GetCacheDirectory() + "gpu_timings.csv";
+                    auto tracePath = GetCacheDirectory() + "gpu_trace.json";
+                    if (WriteFile(csvPath, profiler.DumpCsv()) && WriteFile(tracePath, profiler.DumpChromeTrace()))
+                        LC_INFO("GPU timings written to {} and {}", csvPath, tracePath);
+                }
+            }
+
+            if (text == "pipelinestats")
+            {
+                auto& settings = m_Engine.GetSceneRenderer()->GetSettings();
+                settings.pipelineStatistics = !settings.pipelineStatistics;
+                LC_INFO("Pipeline statistics {}", settings.pipelineStatistics ? "enabled" : "disabled");
+            }
+
+            if (text == "precision")
+            {
+                auto& settings = m_Engine.GetSceneRenderer()->GetSettings();
+                settings.fullPrecision = !settings.fullPrecision;
+                m_Engine.RebuildSceneRenderer();
+                LC_INFO("Render targets use {} precision", settings.fullPrecision ? "full" : "half");
+            }
+
+            if (text == "gbuffer")
+            {
+                auto& settings = m_Engine.GetSceneRenderer()->GetSettings();
+                settings.compactGBuffer = !settings.compactGBuffer;
+                m_Engine.RebuildSceneRenderer();
+                LC_INFO("GBuffer layout {}", settings.compactGBuffer ? "compact" : "full");
+            }
+
+            if (text == "profile")
+            {
+                auto path = GetCacheDirectory() + "cpu_trace.json";
+                if (WriteFile(path, Profiler::Instance().DumpChromeTrace()))
+                    LC_INFO("CPU trace written to {}", path);
+            }
+
+            if (text == "stats")
+            {
+                auto& timings = m_Engine.GetSceneRenderer()->GetAverageFrameTimings();
+                LC_INFO("Frame CPU ms: {:.2f} total, {:.2f} fence wait, {:.2f} acquire, {:.2f} record, {:.2f} submit, "
+                    "{:.2f} present", timings.total, timings.fenceWait, timings.acquire, timings.record, timings.submit,
+                    timings.present);
+
+                auto& stats = m_Engine.GetSceneRenderer()->GetFrameStats();
+                auto& commands = stats.commands;
+                LC_INFO("Commands: {} draws, {} dispatches, {} barriers ({} image, {} buffer), {:.1f} KB uniforms",
+                    commands.draws, commands.dispatches, commands.pipelineBarriers, commands.imageBarriers,
+                    commands.bufferBarriers, commands.uniformBytes / 1024.0);
+                LC_INFO("Descriptor sets: {} lookups, {} allocated, {} descriptors written, {} cached",
+                    commands.descriptorSetLookups, commands.descriptorSetAllocations, commands.descriptorWrites,
+                    commands.cachedDescriptorSets);
+
+                for (auto& pass: stats.passes)
+                {
+                    if (pass.statisticsSkipped)
+                        LC_INFO("{}: not counted, the device can't count passes recorded in parallel", pass.label);
+
+                    if (!pass.hasStatistics)
+                        continue;
+
+                    auto& pipeline = pass.statistics;
+                    LC_INFO("{}: {} primitives, {} clipped to {}, {} vertex, {} fragment, {} compute invocations",
+                        pass.label, pipeline.inputPrimitives, pipeline.clippingInvocations,
+                        pipeline.clippingPrimitives, pipeline.vertexShaderInvocations,
+                        pipeline.fragmentShaderInvocations, pipeline.computeShaderInvocations);
+                }
+
+                auto& culling = m_Engine.GetSceneRenderer()->GetCullingStats();
+                LC_INFO("Culling: {} instances tested, {} outside frustum, {} occluded, {} drawn early, {} drawn late",
+                    culling.tested, culling.frustumCulled, culling.occlusionCulled, culling.drawnEarly,
+                    culling.drawnLate);
+
+                auto streaming = m_Engine.GetTextureStreamer()->GetStats();
+                LC_INFO("Texture streaming: {} textures, {} loading, {} failed, {:.1f} / {:.1f} MB resident",
+                    streaming.numTextures, streaming.numLoading, streaming.numFailed,
+                    streaming.residentBytes / (1024.0 * 1024.0),
+                    streaming.budget / (1024.0 * 1024.0));
+            }
+
             SetActive(false);
         }
 
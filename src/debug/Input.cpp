@@ -8,6 +8,9 @@ namespace lucent
 Input::Input(GLFWwindow* window)
     : m_Window(window)
 {
+    if (!window)
+        return;
+
     glfwSetWindowUserPointer(window, this);
 
     glfwSetKeyCallback(window, KeyCallback);
@@ -70,6 +73,9 @@ void Input::CharCallback(GLFWwindow* window, uint32 codepoint)
 
 void Input::SetCursorVisible(bool visible)
 {
+    if (!m_Window)
+        return;
+
     glfwSetInputMode(m_Window, GLFW_CURSOR, visible ? GLFW_CURSOR_NORMAL : GLFW_CURSOR_DISABLED);
 }
 
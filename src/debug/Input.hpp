@@ -50,6 +50,7 @@ struct InputState
 class Input
 {
 public:
+    //! Without a window, such as on a headless device, the state never changes
     explicit Input(GLFWwindow* window);
 
     const InputState& GetState()
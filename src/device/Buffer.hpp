@@ -7,21 +7,33 @@ enum class BufferType
 {
     kVertex,
     kIndex,
+    kStaticVertex, // Device-local vertex buffer, written only through Upload and Clear
+    kStaticIndex, // Device-local index buffer, written only through Upload and Clear
     kUniform,
     kUniformDynamic,
     kStorage,
-    kStaging
+    kDeviceStorage, // Device-local storage buffer, written only by shaders
+    kIndirect, // Device-local storage buffer which can also be the source of indirect draw commands
+    kStaging,
+    kReadback // Host-cached buffer written by copies, for reading results back from the device
 };
 
 class Buffer
 {
 public:
+    //! Writes directly to host-visible buffers, static buffers are copied to with the next device submission
+    //! Buffers written only by shaders (kDeviceStorage, kIndirect) can't be written or mapped by the host.
     virtual void Upload(const void* data, size_t size, size_t offset) = 0;
     virtual void Clear(size_t size, size_t offset) = 0;
 
     virtual void* Map() = 0;
     virtual void Unmap() = 0;
 
+    //! Makes host writes to mapped memory visible to the device
+    virtual void Flush(size_t size, size_t offset) = 0;
+    //! Makes device writes visible to reads through mapped memory, once the commands writing them have completed
+    virtual void Invalidate(size_t size, size_t offset) = 0;
+
     virtual BufferType GetType() = 0;
 };
 
@@ -3,6 +3,17 @@
 namespace lucent
 {
 
+void Context::RecordParallel(const Framebuffer* renderPass, uint32 tasksPerPass, const RecordTask& record)
+{
+    RecordParallel(std::vector<const Framebuffer*>{ renderPass }, tasksPerPass, record);
+}
+
+uint32 Context::GetNumRecordingTasks(size_t numDraws, uint32 minDrawsPerTask)
+{
+    auto numTasks = static_cast<uint32>(numDraws / Max(minDrawsPerTask, 1u));
+    return Max(Min(numTasks, GetNumRecordingThreads()), 1u);
+}
+
 void Context::BindBuffer(DescriptorID id, const Buffer* buffer)
 {
     BindBuffer(BoundPipeline()->Lookup(id), buffer);
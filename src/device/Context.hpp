@@ -6,6 +6,92 @@
 namespace lucent
 {
 
+//! Resources about to be accessed by a sequence of commands, used to record all required barriers up front
+struct ResourceTransitions
+{
+    //! Textures whose existing contents are not needed, for example because their memory is aliased
+    std::vector<const Texture*> discards;
+    //! Textures which will be sampled
+    std::vector<const Texture*> reads;
+    //! Textures which will be written by attachments, copies or shaders
+    std::vector<const Texture*> writes;
+
+    std::vector<const Buffer*> bufferReads;
+    std::vector<const Buffer*> bufferWrites;
+};
+
+//! Counters for the commands recorded since the last call to Begin
+struct ContextStats
+{
+    //! Draw commands, where each indirect draw command counts once, and a draw whose count is read from a buffer
+    //! counts once however many commands the device executes
+    uint32 draws = 0;
+    uint32 dispatches = 0;
+
+    //! Descriptor sets needed by draws and dispatches, which are allocated unless found in the cache
+    uint32 descriptorSetLookups = 0;
+    uint32 descriptorSetAllocations = 0;
+    uint32 descriptorWrites = 0;
+    //! Descriptor sets kept alive between frames
+    uint32 cachedDescriptorSets = 0;
+
+    //! Bytes of scratch uniform blocks written for draws and dispatches
+    uint64 uniformBytes = 0;
+
+    uint32 pipelineBarriers = 0;
+    uint32 imageBarriers = 0;
+    uint32 bufferBarriers = 0;
+
+    ContextStats& operator+=(const ContextStats& rhs)
+    {
+        draws += rhs.draws;
+        dispatches += rhs.dispatches;
+        descriptorSetLookups += rhs.descriptorSetLookups;
+        descriptorSetAllocations += rhs.descriptorSetAllocations;
+        descriptorWrites += rhs.descriptorWrites;
+        cachedDescriptorSets += rhs.cachedDescriptorSets;
+        uniformBytes += rhs.uniformBytes;
+        pipelineBarriers += rhs.pipelineBarriers;
+        imageBarriers += rhs.imageBarriers;
+        bufferBarriers += rhs.bufferBarriers;
+        return *this;
+    }
+};
+
+//! Work done by the device's fixed function stages and shaders over a region of commands
+struct PipelineStatistics
+{
+    uint64 inputPrimitives = 0;
+    uint64 vertexShaderInvocations = 0;
+    //! Primitives processed by the clipping stage, and those which were output by it
+    uint64 clippingInvocations = 0;
+    uint64 clippingPrimitives = 0;
+    uint64 fragmentShaderInvocations = 0;
+    uint64 computeShaderInvocations = 0;
+};
+
+//! Device time spent executing a labelled region of commands
+struct RegionTiming
+{
+    const char* label;
+    //! Number of regions enclosing this one
+    uint32 depth;
+    //! Time the region started on the device's clock, whose origin is unspecified
+    double startMs;
+    float durationMs;
+
+    //! Only collected for top level regions, while enabled and supported by the device
+    bool hasStatistics = false;
+    PipelineStatistics statistics;
+    //! Set when the region recorded commands in parallel, which the device can't count without inherited queries
+    bool statisticsSkipped = false;
+};
+
+//! Records the commands of one task within a render pass, called from a worker thread
+//! The context passed in is already inside the pass's render pass and must not begin or end render passes, dispatch
+//! compute work or record transitions.
+using RecordTask = std::function<void(Context& ctx, uint32 pass, uint32 task)>;
+
 //! Abstracts an underlying command buffer, allowing you to bind resources and execute rendering commands
 class Context
 {
@@ -16,6 +102,18 @@ public:
     virtual void BeginRenderPass(const Framebuffer* framebuffer) = 0;
     virtual void EndRenderPass() = 0;
 
+    //! Records tasksPerPass tasks for each of the given render passes concurrently, each into its own command buffer,
+    //! then executes them in order of pass then task. Resources sampled by the tasks must already be transitioned.
+    virtual void RecordParallel(const std::vector<const Framebuffer*>& renderPasses, uint32 tasksPerPass,
+        const RecordTask& record) = 0;
+    void RecordParallel(const Framebuffer* renderPass, uint32 tasksPerPass, const RecordTask& record);
+
+    //! Number of tasks which can usefully be recorded at the same time
+    virtual uint32 GetNumRecordingThreads() = 0;
+
+    //! Number of tasks to split a list of draws between, keeping at least minDrawsPerTask draws in each task
+    uint32 GetNumRecordingTasks(size_t numDraws, uint32 minDrawsPerTask);
+
     virtual void Clear(Color color = Color::Black(), float depth = 1.0f) = 0;
     virtual void Viewport(uint32 width, uint32 height) = 0;
 
@@ -42,7 +140,18 @@ public:
     void Uniform(DescriptorID id, uint32 arrayIndex, const T& value);
     virtual void Uniform(Descriptor* descriptor, uint32 arrayIndex, const uint8* data, size_t size) = 0;
 
-    virtual void Draw(uint32 indexCount) = 0;
+    //! Draws indexCount indices starting at firstIndex, with vertexOffset added to each index read
+    virtual void Draw(uint32 indexCount, uint32 firstIndex = 0, int32 vertexOffset = 0) = 0;
+    virtual void DrawInstanced(uint32 indexCount, uint32 instanceCount, uint32 firstInstance = 0,
+        uint32 firstIndex = 0, int32 vertexOffset = 0) = 0;
+
+    //! Draws using indexed draw commands read from a buffer, which must be declared as read by the pass
+    //! Commands are tightly packed VkDrawIndexedIndirectCommand structures starting at offset bytes into the buffer.
+    virtual void DrawIndirect(const Buffer* commands, uint32 offset, uint32 drawCount) = 0;
+    //! Draws the number of commands read from a uint32 at countOffset bytes into a buffer, up to maxDrawCount
+    //! Requires Device::SupportsIndirectDrawCount(), and the count buffer must also be declared as read by the pass.
+    virtual void DrawIndirectCount(const Buffer* commands, uint32 offset, const Buffer* count, uint32 countOffset,
+        uint32 maxDrawCount) = 0;
 
     virtual void Dispatch(uint32 x, uint32 y, uint32 z) = 0;
 
@@ -67,8 +176,29 @@ public:
 
     virtual void GenerateMips(Texture* texture) = 0;
 
+    //! Records the layout transitions and memory dependencies needed before the given resources are used as a
+    //! single batched barrier. Discarded textures must be transitioned before the first use of a texture whose memory
+    //! may have been aliased by another texture.
+    virtual void Transition(const ResourceTransitions& transitions) = 0;
+
     virtual const Pipeline* BoundPipeline() = 0;
 
+    //! Marks a region of commands shown by debugging tools, which is also timed by the device where supported
+    //! Regions may nest but must not contain the start or end of a render pass recorded in parallel. Labels must stay
+    //! valid until the region's timing has been read.
+    virtual void BeginRegion(const char* label) = 0;
+    virtual void EndRegion() = 0;
+
+    //! Timings of the regions recorded in the last frame of this context, valid once Begin has waited for it
+    virtual const std::vector<RegionTiming>& GetRegionTimings() = 0;
+
+    //! Collects pipeline statistics for top level regions begun from now on, if the device supports them
+    //! Statistics add a query around each region, so are disabled by default.
+    virtual void EnablePipelineStatistics(bool enable) = 0;
+
+    //! Counters for the last recorded frame, valid once End has been called
+    virtual const ContextStats& GetStats() = 0;
+
     virtual Device* GetDevice() = 0;
 };
 
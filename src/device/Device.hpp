@@ -5,6 +5,8 @@
 #include "device/Framebuffer.hpp"
 #include "device/Pipeline.hpp"
 #include "device/Buffer.hpp"
+#include "device/GeometryArena.hpp"
+#include "device/TransientMemory.hpp"
 
 #include "debug/Input.hpp"
 
@@ -13,6 +15,32 @@ namespace lucent
 
 class Context;
 
+//! How presented images are queued for display, trading latency against throughput and tearing
+enum class PresentMode
+{
+    kFifo, // Waits for vertical blank, queueing frames up to the swapchain depth
+    kFifoRelaxed, // As kFifo, but a frame which missed its vertical blank is shown immediately and may tear
+    kMailbox, // Waits for vertical blank, replacing a queued frame with a newer one instead of blocking
+    kImmediate // Shows frames as soon as they are presented, may tear
+};
+
+struct SwapchainSettings
+{
+    //! Falls back to kFifo, which is always supported, if the surface doesn't support the mode
+    PresentMode presentMode = PresentMode::kFifo;
+
+    //! Images in the swapchain, clamped to the surface's limits, or one more than its minimum if 0
+    uint32 imageCount = 0;
+};
+
+//! Inclusive range of passes during which a transient texture's contents must be preserved
+struct TextureLifetime
+{
+    Texture* texture;
+    uint32 firstPass;
+    uint32 lastPass;
+};
+
 //! Graphics device interface to manage GPU resources
 class Device
 {
@@ -22,10 +50,40 @@ public:
 
     virtual Texture* CreateTexture(const TextureSettings& textureSettings) = 0;
     virtual void DestroyTexture(Texture* texture) = 0;
+    //! Replaces the image of a read-only texture with one of a new size, its contents are undefined until uploaded
+    //! Commands in flight keep using the old image, and a texture in the global array moves to a new index.
+    virtual void ResizeTexture(Texture* texture, uint32 width, uint32 height) = 0;
+
+    //! Creates a texture without memory, it must not be used until AllocateTransientTextures binds it
+    virtual Texture* CreateTransientTexture(const TextureSettings& textureSettings) = 0;
+    //! Binds memory to transient textures, textures with disjoint lifetimes may share the same memory
+    virtual TransientMemoryStats AllocateTransientTextures(const std::vector<TextureLifetime>& lifetimes) = 0;
+
+    //! True if textures can be added to a global array which shaders sample by index
+    virtual bool SupportsBindlessTextures() = 0;
+    //! True if indirect draws can start from a first instance other than zero, which DrawIndirect commands require
+    virtual bool SupportsIndirectDrawing() = 0;
+    //! True if DrawIndirectCount can read the number of draws from a buffer
+    virtual bool SupportsIndirectDrawCount() = 0;
+    //! True if compute shaders can write textures of the format as storage images
+    virtual bool SupportsStorageFormat(TextureFormat format) = 0;
+
+    //! Adds a texture to the global texture array if not already present, returning its index in the array
+    virtual uint32 AddBindlessTexture(Texture* texture) = 0;
+    //! Changes whenever a texture moves to a new index in the global array, so stored indices must be fetched again
+    virtual uint64 GetBindlessGeneration() = 0;
+
+    //! Vertex and index buffers which static meshes are suballocated from
+    virtual GeometryArena* GetGeometryArena() = 0;
 
     virtual Pipeline* CreatePipeline(const PipelineSettings& pipelineSettings) = 0;
+    //! Starts building a pipeline on worker threads, it must not be used until WaitForPipelines returns
+    virtual Pipeline* CreatePipelineAsync(const PipelineSettings& pipelineSettings) = 0;
+    virtual void WaitForPipelines() = 0;
     virtual void DestroyPipeline(Pipeline* pipeline) = 0;
     virtual void ReloadPipelines() = 0;
+    //! Destroys pipelines which are no longer referenced, otherwise kept for renderer rebuilds to reuse
+    virtual void ReleaseUnusedPipelines() = 0;
 
     virtual Framebuffer* CreateFramebuffer(const FramebufferSettings& framebufferSettings) = 0;
     virtual void DestroyFramebuffer(Framebuffer* framebuffer) = 0;
@@ -35,12 +93,24 @@ public:
 
     virtual void Submit(Context* context) = 0;
 
+    //! Calls release once the commands submitted so far, and those of the next submission, have completed
+    //! Resources which commands in flight may still use are destroyed this way, instead of waiting for the device to
+    //! idle.
+    virtual void DeferRelease(std::function<void()> release) = 0;
+
+    //! True if the device has no surface to present to, so frames are only rendered offscreen
+    virtual bool IsHeadless() = 0;
+
     virtual Texture* AcquireSwapchainImage() = 0;
     virtual bool Present() = 0;
 
     virtual void WaitIdle() = 0;
     virtual void RebuildSwapchain() = 0;
 
+    //! Rebuilds the swapchain with new settings, waiting for the device to idle first
+    virtual void SetSwapchainSettings(const SwapchainSettings& settings) = 0;
+    virtual const SwapchainSettings& GetSwapchainSettings() = 0;
+
     virtual ~Device() = default;
 };
 
@@ -0,0 +1,150 @@
+#include "GeometryArena.hpp"
+
+#include "device/Context.hpp"
+#include "device/Device.hpp"
+
+namespace lucent
+{
+
+RangeAllocator::RangeAllocator(uint32 capacity)
+    : m_Capacity(capacity)
+{
+    if (capacity > 0)
+        m_FreeRanges.emplace(0, capacity);
+}
+
+uint32 RangeAllocator::Allocate(uint32 size)
+{
+    if (size == 0)
+        return 0;
+
+    auto it = std::find_if(m_FreeRanges.begin(), m_FreeRanges.end(), [=](auto& range)
+    { return range.second >= size; });
+
+    if (it == m_FreeRanges.end())
+        return kInvalidOffset;
+
+    auto[offset, rangeSize] = *it;
+    m_FreeRanges.erase(it);
+    if (rangeSize > size)
+        m_FreeRanges.emplace(offset + size, rangeSize - size);
+
+    m_NumAllocated += size;
+    return offset;
+}
+
+void RangeAllocator::Free(uint32 offset, uint32 size)
+{
+    if (size == 0)
+        return;
+
+    LC_ASSERT(offset + size <= m_Capacity && size <= m_NumAllocated);
+    m_NumAllocated -= size;
+
+    auto next = m_FreeRanges.lower_bound(offset);
+    LC_ASSERT(next == m_FreeRanges.end() || offset + size <= next->first);
+
+    // Merge with the free range ending where this one starts
+    if (next != m_FreeRanges.begin())
+    {
+        auto prev = std::prev(next);
+        LC_ASSERT(prev->first + prev->second <= offset);
+
+        if (prev->first + prev->second == offset)
+        {
+            offset = prev->first;
+            size += prev->second;
+            m_FreeRanges.erase(prev);
+        }
+    }
+
+    // Merge with the free range starting where this one ends
+    if (next != m_FreeRanges.end() && next->first == offset + size)
+    {
+        size += next->second;
+        m_FreeRanges.erase(next);
+    }
+
+    m_FreeRanges.emplace(offset, size);
+}
+
+uint32 RangeAllocator::GetCapacity() const
+{
+    return m_Capacity;
+}
+
+uint32 RangeAllocator::GetNumAllocated() const
+{
+    return m_NumAllocated;
+}
+
+uint32 RangeAllocator::GetNumFreeRanges() const
+{
+    return static_cast<uint32>(m_FreeRanges.size());
+}
+
+GeometryArena::GeometryArena(Device* device, uint32 vertexBufferSize, uint32 maxIndices)
+    : m_Device(device)
+    , m_VertexBuffer(device->CreateBuffer(BufferType::kStaticVertex, vertexBufferSize))
+    , m_IndexBuffer(device->CreateBuffer(BufferType::kStaticIndex, maxIndices * sizeof(uint32)))
+    , m_VertexBytes(vertexBufferSize)
+    , m_Indices(maxIndices)
+{
+}
+
+GeometryArena::~GeometryArena()
+{
+    LC_ASSERT(m_VertexBytes.GetNumAllocated() == 0 && m_Indices.GetNumAllocated() == 0);
+
+    m_Device->DestroyBuffer(m_VertexBuffer);
+    m_Device->DestroyBuffer(m_IndexBuffer);
+}
+
+std::optional<GeometryAllocation> GeometryArena::Allocate(const void* vertices, uint32 numVertices, uint32 vertexSize,
+    const uint32* indices, uint32 numIndices)
+{
+    if (m_VertexSize == 0)
+        m_VertexSize = vertexSize;
+    LC_ASSERT(vertexSize == m_VertexSize);
+
+    auto vertexOffset = m_VertexBytes.Allocate(numVertices * vertexSize);
+    auto firstIndex = m_Indices.Allocate(numIndices);
+
+    if (vertexOffset == RangeAllocator::kInvalidOffset || firstIndex == RangeAllocator::kInvalidOffset)
+    {
+        LC_ERROR("Geometry arena can't fit {} vertices and {} indices, {} of {} indices are in use",
+            numVertices, numIndices, m_Indices.GetNumAllocated(), m_Indices.GetCapacity());
+
+        // Release whichever range did fit
+        if (vertexOffset != RangeAllocator::kInvalidOffset)
+            m_VertexBytes.Free(vertexOffset, numVertices * vertexSize);
+        if (firstIndex != RangeAllocator::kInvalidOffset)
+            m_Indices.Free(firstIndex, numIndices);
+
+        return std::nullopt;
+    }
+
+    m_VertexBuffer->Upload(vertices, numVertices * vertexSize, vertexOffset);
+    m_IndexBuffer->Upload(indices, numIndices * sizeof(uint32), firstIndex * sizeof(uint32));
+
+    return GeometryAllocation{
+        .firstVertex = vertexOffset / vertexSize,
+        .numVertices = numVertices,
+        .firstIndex = firstIndex,
+        .numIndices = numIndices
+    };
+}
+
+void GeometryArena::Free(const GeometryAllocation& allocation)
+{
+    m_VertexBytes.Free(allocation.firstVertex * m_VertexSize, allocation.numVertices * m_VertexSize);
+    m_Indices.Free(allocation.firstIndex, allocation.numIndices);
+}
+
+void GeometryArena::Bind(Context& ctx) const
+{
+    ctx.BindBuffer(m_VertexBuffer);
+    ctx.BindBuffer(m_IndexBuffer);
+}
+
+}
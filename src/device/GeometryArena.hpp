@@ -0,0 +1,78 @@
+#pragma once
+
+#include "device/Buffer.hpp"
+
+namespace lucent
+{
+
+class Context;
+class Device;
+
+//! Suballocates ranges of elements from a fixed capacity, taking the lowest free range large enough for each request
+//! Freed ranges are merged with their free neighbours, so releasing everything leaves a single range again.
+class RangeAllocator
+{
+public:
+    static constexpr uint32 kInvalidOffset = ~0u;
+
+    explicit RangeAllocator(uint32 capacity);
+
+    //! Returns the offset of the first element of the range, or kInvalidOffset if no free range is large enough
+    uint32 Allocate(uint32 size);
+    void Free(uint32 offset, uint32 size);
+
+    uint32 GetCapacity() const;
+    uint32 GetNumAllocated() const;
+    uint32 GetNumFreeRanges() const;
+
+private:
+    // First element to number of elements of each free range
+    std::map<uint32, uint32> m_FreeRanges;
+    uint32 m_Capacity;
+    uint32 m_NumAllocated = 0;
+};
+
+//! Ranges of the arena's vertex and index buffers belonging to one mesh
+struct GeometryAllocation
+{
+    uint32 firstVertex = 0;
+    uint32 numVertices = 0;
+    uint32 firstIndex = 0;
+    uint32 numIndices = 0;
+};
+
+//! Vertex and index buffers shared by every static mesh
+//! Meshes are drawn by their offsets into the shared buffers, so draws of different meshes need no buffer binds in
+//! between and can be combined into a single indirect draw.
+class GeometryArena
+{
+public:
+    GeometryArena(Device* device, uint32 vertexBufferSize, uint32 maxIndices);
+    ~GeometryArena();
+
+    GeometryArena(const GeometryArena&) = delete;
+    GeometryArena& operator=(const GeometryArena&) = delete;
+
+    //! Allocates and fills the ranges of a mesh, indices are relative to its first vertex
+    //! Every mesh must use the same vertex size, so vertex offsets stay a whole number of vertices. Returns nothing if
+    //! either range doesn't fit, in which case nothing is allocated.
+    std::optional<GeometryAllocation> Allocate(const void* vertices, uint32 numVertices, uint32 vertexSize,
+        const uint32* indices, uint32 numIndices);
+
+    //! Releases the ranges of a mesh, which must no longer be used by any commands in flight
+    void Free(const GeometryAllocation& allocation);
+
+    //! Binds the shared vertex and index buffers
+    void Bind(Context& ctx) const;
+
+private:
+    Device* m_Device;
+    Buffer* m_VertexBuffer;
+    Buffer* m_IndexBuffer;
+
+    uint32 m_VertexSize = 0;
+    RangeAllocator m_VertexBytes;
+    RangeAllocator m_Indices;
+};
+
+}
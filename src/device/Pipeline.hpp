@@ -21,6 +21,8 @@ struct PipelineSettings
     bool depthTestEnable = true;
     bool depthWriteEnable = true;
     bool depthClampEnable = false;
+    //! Adds fragment colors to the framebuffer's contents instead of replacing or alpha blending with them
+    bool additiveBlendEnable = false;
 };
 
 class Pipeline
@@ -14,7 +14,16 @@ enum class TextureFormat
 
     kRGB10A2,
 
+    kR16U,
+    kRG16U,
+    kRGBA16U,
+
     // Floating point
+    kR16F,
+    kRG16F,
+    kRGBA16F,
+    kR11G11B10F,
+
     kR32F,
     kRG32F,
     kRGB32F,
@@ -25,6 +34,43 @@ enum class TextureFormat
     kDepth32F
 };
 
+//! Bytes used by one texel of a format, as laid out when copied to or from a buffer
+inline uint32 GetTexelSize(TextureFormat format)
+{
+    switch (format)
+    {
+    case TextureFormat::kR8:
+        return 1;
+    case TextureFormat::kRG8:
+    case TextureFormat::kR16U:
+    case TextureFormat::kR16F:
+    case TextureFormat::kDepth16U:
+        return 2;
+    case TextureFormat::kRGB8:
+        return 3;
+    case TextureFormat::kRGBA8:
+    case TextureFormat::kRGBA8_sRGB:
+    case TextureFormat::kRGB10A2:
+    case TextureFormat::kRG16U:
+    case TextureFormat::kRG16F:
+    case TextureFormat::kR11G11B10F:
+    case TextureFormat::kR32F:
+    case TextureFormat::kDepth32F:
+        return 4;
+    case TextureFormat::kRGBA16U:
+    case TextureFormat::kRGBA16F:
+    case TextureFormat::kRG32F:
+        return 8;
+    case TextureFormat::kRGB32F:
+        return 12;
+    case TextureFormat::kRGBA32F:
+        return 16;
+    default:
+        LC_ASSERT(0 && "Invalid texture format");
+        return 0;
+    }
+}
+
 enum class TextureShape
 {
     k2D,
@@ -0,0 +1,104 @@
+#include "TransientMemory.hpp"
+
+namespace lucent
+{
+
+static uint64 AlignUp(uint64 offset, uint64 alignment)
+{
+    return alignment > 1 ? (offset + alignment - 1) / alignment * alignment : offset;
+}
+
+static bool LifetimesOverlap(const TransientResource& a, const TransientResource& b)
+{
+    return a.firstPass <= b.lastPass && b.firstPass <= a.lastPass;
+}
+
+TransientMemoryPlan PlanTransientMemory(const std::vector<TransientResource>& resources)
+{
+    TransientMemoryPlan plan;
+    plan.placements.resize(resources.size());
+
+    // Placing the largest resources first leaves smaller ones to fill the gaps between them
+    std::vector<uint32> order(resources.size());
+    for (uint32 i = 0; i < order.size(); ++i)
+        order[i] = i;
+
+    std::stable_sort(order.begin(), order.end(), [&](uint32 a, uint32 b)
+    {
+        return resources[a].size > resources[b].size;
+    });
+
+    // Resources already placed in each block
+    std::vector<std::vector<uint32>> blockResources;
+
+    struct Interval
+    {
+        uint64 begin;
+        uint64 end;
+    };
+    std::vector<Interval> occupied;
+
+    for (auto index: order)
+    {
+        auto& resource = resources[index];
+        plan.stats.requestedBytes += resource.size;
+        ++plan.stats.numResources;
+
+        bool placed = false;
+        for (uint32 blockIndex = 0; blockIndex < plan.blocks.size() && !placed; ++blockIndex)
+        {
+            auto& block = plan.blocks[blockIndex];
+            if (!(block.memoryTypeBits & resource.memoryTypeBits))
+                continue;
+
+            // Gather address ranges used by resources which are alive at the same time
+            occupied.clear();
+            for (auto other: blockResources[blockIndex])
+            {
+                if (LifetimesOverlap(resource, resources[other]))
+                {
+                    auto begin = plan.placements[other].offset;
+                    occupied.push_back({ begin, begin + resources[other].size });
+                }
+            }
+            std::sort(occupied.begin(), occupied.end(), [](auto& a, auto& b)
+            { return a.begin < b.begin; });
+
+            // Find the first gap large enough to hold the resource
+            uint64 offset = 0;
+            for (auto& interval: occupied)
+            {
+                if (AlignUp(offset, resource.alignment) + resource.size <= interval.begin)
+                    break;
+
+                offset = Max(offset, interval.end);
+            }
+            offset = AlignUp(offset, resource.alignment);
+
+            if (offset + resource.size <= block.size)
+            {
+                block.alignment = Max(block.alignment, resource.alignment);
+                block.memoryTypeBits &= resource.memoryTypeBits;
+
+                plan.placements[index] = { blockIndex, offset };
+                blockResources[blockIndex].push_back(index);
+                placed = true;
+            }
+        }
+
+        if (!placed)
+        {
+            plan.placements[index] = { static_cast<uint32>(plan.blocks.size()), 0 };
+            plan.blocks.push_back({ resource.size, resource.alignment, resource.memoryTypeBits });
+            blockResources.push_back({ index });
+        }
+    }
+
+    for (auto& block: plan.blocks)
+        plan.stats.allocatedBytes += block.size;
+    plan.stats.numBlocks = plan.blocks.size();
+
+    return plan;
+}
+
+}
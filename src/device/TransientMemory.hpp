@@ -0,0 +1,54 @@
+#pragma once
+
+namespace lucent
+{
+
+//! Memory requirements and lifetime of a resource which may share memory with others
+struct TransientResource
+{
+    uint64 size;
+    uint64 alignment;
+    uint32 memoryTypeBits;
+
+    // Inclusive range of pass indices during which the resource contents must be preserved
+    uint32 firstPass;
+    uint32 lastPass;
+};
+
+//! A single memory allocation shared by one or more transient resources
+struct TransientBlock
+{
+    uint64 size;
+    uint64 alignment;
+    uint32 memoryTypeBits;
+};
+
+struct TransientPlacement
+{
+    uint32 block;
+    uint64 offset;
+};
+
+//! Summary of how much memory aliasing saved
+struct TransientMemoryStats
+{
+    uint32 numResources = 0;
+    uint32 numBlocks = 0;
+    uint64 requestedBytes = 0;
+    uint64 allocatedBytes = 0;
+};
+
+//! Assignment of transient resources to blocks, placements are indexed in the same order as the resources
+struct TransientMemoryPlan
+{
+    std::vector<TransientBlock> blocks;
+    std::vector<TransientPlacement> placements;
+    TransientMemoryStats stats;
+};
+
+//! Packs resources into as few bytes as possible, allowing resources with disjoint lifetimes to overlap in memory
+//! Resources are placed largest first into the lowest offset of an existing block where they do not overlap any
+//! resource that is alive at the same time, otherwise a new block is created sized to fit them.
+TransientMemoryPlan PlanTransientMemory(const std::vector<TransientResource>& resources);
+
+}
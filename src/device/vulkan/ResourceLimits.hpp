@@ -6,7 +6,8 @@ namespace lucent
 {
 
 // From shaderc default resource
-inline TBuiltInResource builtInResource = {
+// Read-only so it can be shared by shaders compiling on multiple threads
+inline const TBuiltInResource builtInResource = {
     /*.maxLights = */ 8,         // From OpenGL 3.0 table 6.46.
     /*.maxClipPlanes = */ 6,     // From OpenGL 3.0 table 6.46.
     /*.maxTextureUnits = */ 2,   // From OpenGL 3.0 table 6.50.
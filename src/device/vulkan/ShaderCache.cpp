@@ -9,6 +9,9 @@
 #include "device/vulkan/VulkanDevice.hpp"
 #include "ResourceLimits.hpp"
 
+#include <chrono>
+#include <cstring>
+
 namespace lucent
 {
 
@@ -254,54 +257,130 @@ private:
 };
 
 // Shader cache
+constexpr auto kIncludeDirective = "#include";
+constexpr int kMaxIncludeDepth = 32;
+
+// Disk cache format, bump the version whenever the serialized layout changes
+constexpr uint32 kBinaryMagic = 0x4353434c; // "LCSC"
+constexpr uint32 kBinaryVersion = 3;
+
 ShaderCache::ShaderCache(VulkanDevice* device)
     : m_Device(device)
     , m_Resolver(new DefaultResolver())
+    , m_CachePath(GetCacheDirectory() + "shaders/")
 {}
 
 VulkanShader* ShaderCache::Compile(const PipelineSettings& settings)
 {
-    ShaderInfoLog log{};
-    auto result = Compile(settings, log);
-    if (!result)
+    return Finish(Build(settings));
+}
+
+VulkanShader* ShaderCache::Compile(const PipelineSettings& settings, ShaderInfoLog& log)
+{
+    auto result = Build(settings);
+    log = result.log;
+
+    return result.success ? Finish(std::move(result)) : nullptr;
+}
+
+std::future<ShaderCache::CompileResult> ShaderCache::CompileAsync(const PipelineSettings& settings,
+    ThreadPool& workers)
+{
+    return workers.Submit([this, settings]()
+    {
+        return Build(settings);
+    });
+}
+
+ShaderCache::CompileResult ShaderCache::Build(const PipelineSettings& settings)
+{
+    LC_PROFILE_ZONE("ShaderCache::Build");
+
+    CompileResult result{ .settings = settings };
+
+    auto source = m_Resolver->Resolve(settings.shaderName);
+    if (!source.found)
+    {
+        result.log.Error("Unable to resolve shader with name:");
+        result.log.Error(settings.shaderName);
+        return result;
+    }
+
+    result.hash = HashSource(source.source, HashBytes<uint64>(kBinaryVersion));
+    for (auto define: settings.shaderDefines)
+        result.hash ^= Hash<uint64>(define);
+
+    {
+        std::lock_guard lock(m_ShadersMutex);
+        if (m_Shaders.contains(result.hash))
+        {
+            result.success = result.resident = true;
+            return result;
+        }
+    }
+
+    if (LoadBinary(result.hash, result.binary))
     {
-        LC_ERROR("Error compiling shader {}:\n{}", settings.shaderName, log.error);
+        result.success = result.cached = true;
+        return result;
     }
+
+    auto start = std::chrono::steady_clock::now();
+    result.success = CompileBinary(result.binary, source.qualifiedName, source.source,
+        settings.shaderDefines, result.log);
+    result.compileMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
     return result;
 }
 
-VulkanShader* ShaderCache::Compile(const PipelineSettings& settings, ShaderInfoLog& log)
+VulkanShader* ShaderCache::Finish(CompileResult result)
 {
-    auto result = m_Resolver->Resolve(settings.shaderName);
-    if (!result.found)
+    if (!result.success)
     {
-        log.Error("Unable to resolve shader with name:");
-        log.Error(settings.shaderName);
+        LC_ERROR("Error compiling shader {}:\n{}", result.settings.shaderName, result.log.error);
         return nullptr;
     }
 
-    auto hash = Hash<uint64>(result.source);
-    for (auto define: settings.shaderDefines)
-        hash ^= Hash<uint64>(define);
+    std::unique_lock lock(m_ShadersMutex);
+    if (auto it = m_Shaders.find(result.hash); it != m_Shaders.end())
+    {
+        return it->second.get();
+    }
+    lock.unlock();
+
+    // The shader was released while this result was in flight, so build it again
+    if (result.resident)
+        return Finish(Build(result.settings));
 
-    if (m_Shaders.contains(hash))
+    if (result.cached)
     {
-        return m_Shaders[hash].get();
+        ++m_Stats.hits;
+    }
+    else
+    {
+        ++m_Stats.misses;
+        m_Stats.compileMs += result.compileMs;
+        LC_DEBUG("Compiled shader {} in {:.1f}ms", result.settings.shaderName, result.compileMs);
+
+        StoreBinary(result.hash, result.binary);
     }
 
-    auto& shader = (m_Shaders[hash] = std::make_unique<VulkanShader>(VulkanShader{}));
-    if (!PopulateShaderModules(*shader, result.qualifiedName, result.source, settings.shaderDefines, log))
+    auto shader = std::make_unique<VulkanShader>(VulkanShader{});
+    if (!PopulateShaderModules(*shader, result.binary, result.log))
     {
-        m_Shaders.erase(hash);
+        LC_ERROR("Error creating shader {}:\n{}", result.settings.shaderName, result.log.error);
+        FreeResources(shader.get());
         return nullptr;
     }
-    shader->hash = hash;
+    shader->hash = result.hash;
 
-    return shader.get();
+    lock.lock();
+    return (m_Shaders[result.hash] = std::move(shader)).get();
 }
 
 void ShaderCache::Release(VulkanShader* shader)
 {
+    std::lock_guard lock(m_ShadersMutex);
     LC_ASSERT(m_Shaders.contains(shader->hash));
 
     if (--shader->uses <= 0)
@@ -311,15 +390,45 @@ void ShaderCache::Release(VulkanShader* shader)
     }
 }
 
+uint64 ShaderCache::HashSource(const std::string& source, uint64 hash, int depth)
+{
+    hash = Hash<uint64>(source, hash);
+    if (depth >= kMaxIncludeDepth)
+        return hash;
+
+    // Fold in the contents of every included file so that editing an include invalidates the cache
+    auto directiveLength = std::string_view(kIncludeDirective).size();
+    size_t pos = 0;
+    while ((pos = source.find(kIncludeDirective, pos)) != std::string::npos)
+    {
+        pos += directiveLength;
+
+        auto lineEnd = source.find('\n', pos);
+        auto nameStart = source.find('"', pos);
+        auto nameEnd = nameStart == std::string::npos ? nameStart : source.find('"', nameStart + 1);
+
+        if (nameEnd == std::string::npos || nameEnd > lineEnd)
+            continue;
+
+        auto include = m_Resolver->Resolve(source.substr(nameStart + 1, nameEnd - nameStart - 1));
+        if (include.found)
+            hash = HashSource(include.source, hash, depth + 1);
+
+        pos = nameEnd;
+    }
+    return hash;
+}
+
 const char* kDefaultPreamble =
     "#extension GL_ARB_separate_shader_objects : enable\n"
     "#extension GL_GOOGLE_include_directive : enable\n";
 
 static bool ScanLinkerSymbols(const TIntermNode& root,
-    ShaderCache::PipelineLayout& layout,
-    VulkanShader& shader,
+    ShaderCache::Binary& binary,
     ShaderInfoLog& log)
 {
+    auto& layout = binary.layout;
+
     auto addDescriptor = [&](glslang::TIntermSymbol& symbol)
     {
         auto& type = symbol.getType();
@@ -338,6 +447,25 @@ static bool ScanLinkerSymbols(const TIntermNode& root,
         if (!layout.sets[set])
             layout.sets[set] = ShaderCache::SetLayout{};
 
+        // The only descriptor array allowed is the global texture array, which is bound by the device
+        if (type.isArray())
+        {
+            if (set != VulkanShader::kBindlessSet || binding != 0 ||
+                type.getBasicType() != glslang::EbtSampler || type.getSampler().isImage())
+            {
+                log.Error("Error while scanning: descriptor arrays are only supported for the bindless texture array");
+                return false;
+            }
+            layout.sets[set]->bindings[binding] = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            layout.sets[set]->bindless = true;
+            return true;
+        }
+
+        // A buffer is only read if every stage declaring it does so readonly
+        static_assert(VulkanShader::kMaxBindingsPerSet <= 16);
+        if (TypeToDescriptorType(type) == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER && !qualifier.isReadOnly())
+            layout.sets[set]->writableBuffers |= 1u << binding;
+
         // If binding not already present from a previous stage, create it
         if (!layout.sets[set]->bindings[binding])
         {
@@ -353,12 +481,12 @@ static bool ScanLinkerSymbols(const TIntermNode& root,
                 .binding = binding,
                 .size = size
             };
-            shader.descriptors.emplace_back(entry);
+            binary.descriptors.emplace_back(entry);
 
             // Add all block members as separate descriptors
             if (isBlock)
             {
-                shader.blocks.emplace_back(entry);
+                binary.blocks.emplace_back(entry);
                 int childSize = 0;
                 int offset = 0;
                 for (auto& loc: *type.getStruct())
@@ -366,7 +494,7 @@ static bool ScanLinkerSymbols(const TIntermNode& root,
                     auto& child = *loc.type;
                     glslang::TIntermediate::updateOffset(type, child, offset, childSize);
 
-                    shader.descriptors.emplace_back(Descriptor{
+                    binary.descriptors.emplace_back(Descriptor{
                         .hash = Hash<uint32>(child.getFieldName()),
                         .set = set,
                         .binding = binding,
@@ -400,7 +528,7 @@ static bool ScanLinkerSymbols(const TIntermNode& root,
     return true;
 }
 
-bool ShaderCache::PopulateShaderModules(VulkanShader& shader,
+bool ShaderCache::CompileBinary(Binary& binary,
     const std::string& name,
     const std::string& source,
     const std::vector<std::string_view>& defines,
@@ -413,7 +541,7 @@ bool ShaderCache::PopulateShaderModules(VulkanShader& shader,
     const auto targetLang = glslang::EshTargetSpv;
     const auto targetLangVersion = glslang::EShTargetSpv_1_2;
 
-    shader = {};
+    binary = {};
     std::vector<std::unique_ptr<glslang::TShader>> shaders;
     glslang::TProgram program;
 
@@ -461,7 +589,7 @@ bool ShaderCache::PopulateShaderModules(VulkanShader& shader,
         }
 
         program.addShader(&glsl);
-        shader.stages.emplace_back(VulkanShader::Stage{ .stageBit = bit });
+        binary.stages.emplace_back(Binary::Stage{ .stageBit = bit });
         return true;
     };
 
@@ -511,35 +639,18 @@ bool ShaderCache::PopulateShaderModules(VulkanShader& shader,
         return false;
     }
 
-    PipelineLayout layout;
-
-    // Create SPIRV shader modules for each stage
-    for (int i = 0; i < shader.stages.size(); ++i)
+    // Generate SPIRV and reflect descriptors for each stage
+    for (int i = 0; i < binary.stages.size(); ++i)
     {
-        m_SpirvBuffer.clear();
-
         auto& inter = *shaders[i]->getIntermediate();
-        glslang::GlslangToSpv(inter, m_SpirvBuffer);
-
-        auto moduleInfo = VkShaderModuleCreateInfo{
-            .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-            .codeSize = m_SpirvBuffer.size() * sizeof(uint32),
-            .pCode = m_SpirvBuffer.data()
-        };
-
-        auto result = vkCreateShaderModule(m_Device->GetHandle(), &moduleInfo, nullptr, &shader.stages[i].module);
-        if (result != VK_SUCCESS)
-        {
-            log.Error("Failed to create Vulkan shader module");
-            return false;
-        }
+        glslang::GlslangToSpv(inter, binary.stages[i].spirv);
 
-        if (!ScanLinkerSymbols(*inter.getTreeRoot(), layout, shader, log))
+        if (!ScanLinkerSymbols(*inter.getTreeRoot(), binary, log))
             return false;
     }
 
     // Sort descriptors in hash order for binary search
-    auto& descriptors = shader.descriptors;
+    auto& descriptors = binary.descriptors;
     std::sort(descriptors.begin(), descriptors.end(), [](auto& a, auto& b)
     {
         return a.hash < b.hash;
@@ -558,7 +669,217 @@ bool ShaderCache::PopulateShaderModules(VulkanShader& shader,
         prevHash = hash;
     }
 
-    return PopulateShaderLayout(shader, layout, log);
+    return true;
+}
+
+bool ShaderCache::PopulateShaderModules(VulkanShader& shader, const Binary& binary, ShaderInfoLog& log)
+{
+    shader = {};
+
+    // Create SPIRV shader modules for each stage
+    for (auto& stage: binary.stages)
+    {
+        auto moduleInfo = VkShaderModuleCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+            .codeSize = stage.spirv.size() * sizeof(uint32),
+            .pCode = stage.spirv.data()
+        };
+
+        VkShaderModule module;
+        auto result = vkCreateShaderModule(m_Device->GetHandle(), &moduleInfo, nullptr, &module);
+        if (result != VK_SUCCESS)
+        {
+            log.Error("Failed to create Vulkan shader module");
+            return false;
+        }
+        shader.stages.emplace_back(VulkanShader::Stage{ .stageBit = stage.stageBit, .module = module });
+    }
+
+    shader.descriptors = binary.descriptors;
+    shader.blocks = binary.blocks;
+
+    return PopulateShaderLayout(shader, binary.layout, log);
+}
+
+// Disk cache serialization
+class BinaryWriter
+{
+public:
+    template<typename T>
+    void Write(const T& value)
+    {
+        Write(&value, sizeof(T));
+    }
+
+    void Write(const void* data, size_t size)
+    {
+        buffer.append(static_cast<const char*>(data), size);
+    }
+
+public:
+    std::string buffer;
+};
+
+class BinaryReader
+{
+public:
+    explicit BinaryReader(std::string_view data)
+        : m_Data(data)
+    {}
+
+    template<typename T>
+    bool Read(T& value)
+    {
+        return Read(&value, sizeof(T));
+    }
+
+    bool Read(void* data, size_t size)
+    {
+        if (size > Remaining())
+            return false;
+
+        std::memcpy(data, m_Data.data() + m_Offset, size);
+        m_Offset += size;
+        return true;
+    }
+
+    size_t Remaining() const
+    {
+        return m_Data.size() - m_Offset;
+    }
+
+private:
+    std::string_view m_Data;
+    size_t m_Offset = 0;
+};
+
+std::string ShaderCache::GetBinaryPath(uint64 hash) const
+{
+    return fmt::format("{}{:016x}.spv", m_CachePath, hash);
+}
+
+bool ShaderCache::LoadBinary(uint64 hash, Binary& binary) const
+{
+    bool found = false;
+    auto data = ReadFile(GetBinaryPath(hash), std::ios::in | std::ios::binary, &found);
+    if (!found)
+        return false;
+
+    binary = {};
+    BinaryReader reader(data);
+
+    uint32 magic, version;
+    uint64 storedHash;
+    if (!reader.Read(magic) || !reader.Read(version) || !reader.Read(storedHash) ||
+        magic != kBinaryMagic || version != kBinaryVersion || storedHash != hash)
+        return false;
+
+    uint32 numStages;
+    if (!reader.Read(numStages) || numStages > VulkanShader::kMaxStages)
+        return false;
+
+    for (uint32 i = 0; i < numStages; ++i)
+    {
+        auto& stage = binary.stages.emplace_back();
+
+        uint32 numWords;
+        if (!reader.Read(stage.stageBit) || !reader.Read(numWords))
+            return false;
+
+        // Reject counts a truncated or corrupt entry can't back before allocating for them
+        if (numWords > reader.Remaining() / sizeof(uint32))
+            return false;
+
+        stage.spirv.resize(numWords);
+        if (!reader.Read(stage.spirv.data(), numWords * sizeof(uint32)))
+            return false;
+    }
+
+    for (auto& set: binary.layout.sets)
+    {
+        uint8 present;
+        if (!reader.Read(present))
+            return false;
+
+        if (!present)
+            continue;
+
+        set = SetLayout{};
+        if (!reader.Read(set->bindless) || !reader.Read(set->writableBuffers))
+            return false;
+
+        for (auto& binding: set->bindings)
+        {
+            VkDescriptorType type;
+            if (!reader.Read(type))
+                return false;
+
+            if (type != VK_DESCRIPTOR_TYPE_MAX_ENUM)
+                binding = type;
+        }
+    }
+
+    auto readDescriptors = [&](auto& descriptors)
+    {
+        uint32 count;
+        if (!reader.Read(count) || count > descriptors.max_size())
+            return false;
+
+        for (uint32 i = 0; i < count; ++i)
+        {
+            Descriptor descriptor;
+            if (!reader.Read(descriptor))
+                return false;
+            descriptors.push_back(descriptor);
+        }
+        return true;
+    };
+
+    return readDescriptors(binary.descriptors) && readDescriptors(binary.blocks);
+}
+
+void ShaderCache::StoreBinary(uint64 hash, const Binary& binary) const
+{
+    BinaryWriter writer;
+    writer.Write(kBinaryMagic);
+    writer.Write(kBinaryVersion);
+    writer.Write(hash);
+
+    writer.Write(static_cast<uint32>(binary.stages.size()));
+    for (auto& stage: binary.stages)
+    {
+        writer.Write(stage.stageBit);
+        writer.Write(static_cast<uint32>(stage.spirv.size()));
+        writer.Write(stage.spirv.data(), stage.spirv.size() * sizeof(uint32));
+    }
+
+    for (auto& set: binary.layout.sets)
+    {
+        writer.Write(static_cast<uint8>(set.has_value()));
+        if (!set)
+            continue;
+
+        writer.Write(set->bindless);
+        writer.Write(set->writableBuffers);
+        for (auto& binding: set->bindings)
+        {
+            writer.Write(binding.value_or(VK_DESCRIPTOR_TYPE_MAX_ENUM));
+        }
+    }
+
+    auto writeDescriptors = [&](auto& descriptors)
+    {
+        writer.Write(static_cast<uint32>(descriptors.size()));
+        writer.Write(descriptors.data(), descriptors.size() * sizeof(Descriptor));
+    };
+    writeDescriptors(binary.descriptors);
+    writeDescriptors(binary.blocks);
+
+    auto path = GetBinaryPath(hash);
+    if (!WriteFileAtomic(path, writer.buffer, std::ios::out | std::ios::binary))
+    {
+        LC_WARN("Failed to write shader cache entry {}", path);
+    }
 }
 
 bool ShaderCache::PopulateShaderLayout(VulkanShader& shader, const PipelineLayout& layout, ShaderInfoLog& log)
@@ -568,7 +889,22 @@ bool ShaderCache::PopulateShaderLayout(VulkanShader& shader, const PipelineLayou
     {
         auto& set = layout.sets[i];
         if (!set) break;
+
+        if (set->bindless)
+        {
+            auto bindlessLayout = m_Device->GetBindlessLayout();
+            if (!bindlessLayout)
+            {
+                log.Error("Shader uses bindless textures, which are not supported by the device");
+                return false;
+            }
+            shader.setLayouts.push_back(bindlessLayout);
+            shader.writableBuffers.push_back(0);
+            shader.bindless = true;
+            continue;
+        }
         shader.setLayouts.push_back(FindSetLayout(set.value()));
+        shader.writableBuffers.push_back(set->writableBuffers);
     }
 
     // Find or create pipeline layout
@@ -594,6 +930,9 @@ bool ShaderCache::PopulateShaderLayout(VulkanShader& shader, const PipelineLayou
 
 void ShaderCache::Clear()
 {
+    LC_INFO("Shader cache: {} hits, {} misses, {:.1f}ms spent compiling",
+        m_Stats.hits, m_Stats.misses, m_Stats.compileMs);
+
     for (auto&[hash, shader]: m_Shaders)
     {
         FreeResources(shader.get());
@@ -668,7 +1007,7 @@ size_t ShaderCache::LayoutHash::operator()(const SetLayout& set) const
         if (set.bindings[i])
             hash = HashBytes(set.bindings[i].value(), hash);
     }
-    return hash;
+    return HashBytes(set.bindless, hash);
 }
 
 size_t ShaderCache::LayoutHash::operator()(const SetList& sets) const
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "core/ThreadPool.hpp"
 #include "device/Pipeline.hpp"
 #include "VulkanShader.hpp"
 
@@ -18,11 +19,28 @@ public:
 
     VulkanShader* Compile(const PipelineSettings& pipeline, ShaderInfoLog& log);
 
+    struct CompileResult;
+
+    //! Compiles a shader on a worker thread; the result must be passed to Finish on the owning thread
+    std::future<CompileResult> CompileAsync(const PipelineSettings& pipeline, ThreadPool& workers);
+
+    //! Creates the shader modules and layouts for a compile result, or returns an existing shader
+    VulkanShader* Finish(CompileResult result);
+
     void Release(VulkanShader* shader);
 
     // Release all resources from the cache
     void Clear();
 
+    struct Stats
+    {
+        uint32 hits;
+        uint32 misses;
+        double compileMs;
+    };
+
+    const Stats& GetStats() const { return m_Stats; }
+
 public:
     template<typename T, int N>
     using SlotList = std::array<std::optional<T>, N>;
@@ -33,9 +51,14 @@ public:
     {
         bool operator==(const SetLayout other) const
         {
-            return bindings == other.bindings;
+            return bindings == other.bindings && bindless == other.bindless;
         }
         SlotList<VkDescriptorType, VulkanShader::kMaxBindingsPerSet> bindings;
+        // Uses the device's global texture array layout in place of its own
+        bool bindless = false;
+        // Mask of storage buffer bindings which a stage doesn't declare readonly. Only used to track hazards, so it
+        // isn't part of the Vulkan layout and is left out of comparisons.
+        uint16 writableBuffers = 0;
     };
 
     struct PipelineLayout
@@ -49,13 +72,51 @@ public:
         size_t operator()(const SetList& sets) const;
     };
 
+    //! Compiled SPIR-V and reflection data for a shader, as persisted in the disk cache
+    struct Binary
+    {
+        struct Stage
+        {
+            VkShaderStageFlagBits stageBit;
+            std::vector<uint32> spirv;
+        };
+
+        std::vector<Stage> stages;
+        PipelineLayout layout;
+        Array <Descriptor, VulkanShader::kMaxDescriptors> descriptors;
+        Array <Descriptor, VulkanShader::kMaxDescriptorBlocks> blocks;
+    };
+
+    struct CompileResult
+    {
+        PipelineSettings settings;
+        uint64 hash;
+        Binary binary;
+        ShaderInfoLog log;
+        double compileMs;
+        bool success;
+        bool cached;   // Loaded from the disk cache
+        bool resident; // Already present in memory, binary is left empty
+    };
+
 private:
-    bool PopulateShaderModules(VulkanShader& shader,
+    // Safe to call from any thread
+    CompileResult Build(const PipelineSettings& pipeline);
+
+    uint64 HashSource(const std::string& source, uint64 hash, int depth = 0);
+
+    bool CompileBinary(Binary& binary,
         const std::string& name,
         const std::string& source,
         const std::vector<std::string_view>& defines,
         ShaderInfoLog& log);
 
+    bool LoadBinary(uint64 hash, Binary& binary) const;
+    void StoreBinary(uint64 hash, const Binary& binary) const;
+    std::string GetBinaryPath(uint64 hash) const;
+
+    bool PopulateShaderModules(VulkanShader& shader, const Binary& binary, ShaderInfoLog& log);
+
     bool PopulateShaderLayout(VulkanShader& shader, const PipelineLayout& layout, ShaderInfoLog& log);
 
     void FreeResources(VulkanShader* shader);
@@ -64,9 +125,11 @@ private:
 
 private:
     VulkanDevice* m_Device;
-    std::vector<uint32> m_SpirvBuffer;
     std::unique_ptr<ShaderResolver> m_Resolver;
+    std::string m_CachePath;
+    Stats m_Stats{};
     std::unordered_map<uint64, std::unique_ptr<VulkanShader>> m_Shaders;
+    std::mutex m_ShadersMutex;
 
     std::unordered_map<SetLayout, VkDescriptorSetLayout, LayoutHash> m_SetLayouts;
     std::unordered_map<SetList, VkPipelineLayout, LayoutHash> m_PipelineLayouts;
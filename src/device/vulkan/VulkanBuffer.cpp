@@ -1,8 +1,20 @@
 #include "VulkanBuffer.hpp"
 
+#include "device/vulkan/VulkanUploader.hpp"
+
 namespace lucent
 {
 
+static bool IsStatic(BufferType type)
+{
+    return type == BufferType::kStaticVertex || type == BufferType::kStaticIndex;
+}
+
+static bool IsShaderWritten(BufferType type)
+{
+    return type == BufferType::kDeviceStorage || type == BufferType::kIndirect;
+}
+
 static VkBufferUsageFlags BufferTypeToFlags(BufferType type)
 {
     VkBufferUsageFlags flags = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
@@ -10,11 +22,13 @@ static VkBufferUsageFlags BufferTypeToFlags(BufferType type)
     switch (type)
     {
     case BufferType::kVertex:
+    case BufferType::kStaticVertex:
     {
         flags |= VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
         break;
     }
     case BufferType::kIndex:
+    case BufferType::kStaticIndex:
     {
         flags |= VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
         break;
@@ -30,11 +44,21 @@ static VkBufferUsageFlags BufferTypeToFlags(BufferType type)
         flags |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
         break;
     }
+    case BufferType::kReadback:
+    {
+        break;
+    }
     case BufferType::kStorage:
+    case BufferType::kDeviceStorage:
     {
         flags |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
         break;
     }
+    case BufferType::kIndirect:
+    {
+        flags |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+        break;
+    }
 
     }
     return flags;
@@ -48,8 +72,16 @@ VulkanBuffer::VulkanBuffer(VulkanDevice* dev, BufferType bufType, size_t bufSize
     , capacity(bufSize)
     , mappedPointer(nullptr)
 {
+    // Static buffers are only read by the device, so live in its local memory and are written through staging. Buffers
+    // written by shaders are never accessed by the host, so their atomics and reads stay in local memory too.
+    auto memoryUsage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+    if (IsStatic(type) || IsShaderWritten(type))
+        memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY;
+    else if (type == BufferType::kReadback)
+        memoryUsage = VMA_MEMORY_USAGE_GPU_TO_CPU;
+
     auto allocInfo = VmaAllocationCreateInfo{
-        .usage = VMA_MEMORY_USAGE_CPU_TO_GPU
+        .usage = memoryUsage
     };
 
     auto bufferInfo = VkBufferCreateInfo{
@@ -72,6 +104,14 @@ VulkanBuffer::~VulkanBuffer()
 void VulkanBuffer::Upload(const void* data, size_t size, size_t offset)
 {
     LC_ASSERT(offset + size <= capacity);
+    LC_ASSERT(!IsShaderWritten(type));
+
+    if (IsStatic(type))
+    {
+        device->GetUploader().Upload(this, data, size, offset);
+        return;
+    }
+
     auto allocator = device->GetAllocator();
 
     uint8* ptr;
@@ -85,6 +125,15 @@ void VulkanBuffer::Upload(const void* data, size_t size, size_t offset)
 void VulkanBuffer::Clear(size_t size, size_t offset)
 {
     LC_ASSERT(offset + size <= capacity);
+    LC_ASSERT(!IsShaderWritten(type));
+
+    if (IsStatic(type))
+    {
+        std::vector<uint8> zeros(size);
+        device->GetUploader().Upload(this, zeros.data(), size, offset);
+        return;
+    }
+
     auto allocator = device->GetAllocator();
 
     uint8* ptr;
@@ -97,6 +146,7 @@ void VulkanBuffer::Clear(size_t size, size_t offset)
 
 void* VulkanBuffer::Map()
 {
+    LC_ASSERT(!IsStatic(type) && !IsShaderWritten(type));
     if (!mappedPointer)
     {
         LC_CHECK(vmaMapMemory(device->GetAllocator(), allocation, &mappedPointer));
@@ -110,6 +160,18 @@ void VulkanBuffer::Unmap()
     mappedPointer = nullptr;
 }
 
+void VulkanBuffer::Flush(size_t size, size_t offset)
+{
+    LC_ASSERT(offset + size <= capacity);
+    vmaFlushAllocation(device->GetAllocator(), allocation, offset, size);
+}
+
+void VulkanBuffer::Invalidate(size_t size, size_t offset)
+{
+    LC_ASSERT(offset + size <= capacity);
+    vmaInvalidateAllocation(device->GetAllocator(), allocation, offset, size);
+}
+
 BufferType VulkanBuffer::GetType()
 {
     return type;
@@ -17,6 +17,8 @@ public:
     void Clear(size_t size, size_t offset) override;
     void* Map() override;
     void Unmap() override;
+    void Flush(size_t size, size_t offset) override;
+    void Invalidate(size_t size, size_t offset) override;
     BufferType GetType() override;
 
 public:
@@ -26,6 +28,9 @@ public:
     BufferType type;
     size_t capacity;
     void* mappedPointer;
+
+    // Updated as commands using the buffer are recorded
+    mutable VulkanSyncState sync;
 };
 
 }
@@ -23,6 +23,19 @@ class VulkanTexture;
 class VulkanBuffer;
 class VulkanContext;
 class VulkanSwapchain;
+class VulkanUploader;
+
+//! Synchronization state of a texture or buffer after its most recently recorded use
+//! Shared by all contexts, which relies on command buffers being submitted in the order they are recorded
+struct VulkanSyncState
+{
+    VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkPipelineStageFlags writeStages = 0; // Stages of the last write or barrier, which later accesses must wait on
+    VkAccessFlags writeAccess = 0; // Accesses of the last write which have not been made available
+    VkPipelineStageFlags readStages = 0; // Stages which have read since the last write or barrier
+    VkPipelineStageFlags visibleStages = 0; // Stages the last write has been made visible to
+    VkAccessFlags visibleAccess = 0; // Accesses the last write has been made visible to
+};
 
 // Convenience downcasting
 static VulkanPipeline* Get(Pipeline* pipeline) { return reinterpret_cast<VulkanPipeline*>(pipeline); }
@@ -20,8 +20,33 @@ static VkPipelineBindPoint GetBindPoint(PipelineType type)
     }
 }
 
-VulkanContext::VulkanContext(VulkanDevice& device)
+// Accesses which must be made available before a later access may safely use the same memory
+static constexpr VkAccessFlags kWriteAccess =
+    VK_ACCESS_SHADER_WRITE_BIT |
+    VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+    VK_ACCESS_TRANSFER_WRITE_BIT |
+    VK_ACCESS_HOST_WRITE_BIT |
+    VK_ACCESS_MEMORY_WRITE_BIT;
+
+// Stages at which render targets and buffers are accessed by shaders
+static constexpr VkPipelineStageFlags kShaderStages =
+    VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+    VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+// Statistics collected by pipeline statistics queries, whose results are written in order of the flag bits
+static constexpr VkQueryPipelineStatisticFlags kPipelineStatistics =
+    VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+
+VulkanContext::VulkanContext(VulkanDevice& device, VkCommandBufferLevel level)
     : m_Device(device)
+    , m_Level(level)
     , m_DescriptorPools([this]
     { return AllocateDescriptorPool(); })
     , m_ScratchUniformBuffers([this]
@@ -45,16 +70,38 @@ VulkanContext::VulkanContext(VulkanDevice& device)
     auto bufferAllocInfo = VkCommandBufferAllocateInfo{
         .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
         .commandPool = m_CommandPool,
-        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .level = level,
         .commandBufferCount = 1
     };
     LC_CHECK(vkAllocateCommandBuffers(device.m_Handle, &bufferAllocInfo, &m_CommandBuffer));
+
+    if (level == VK_COMMAND_BUFFER_LEVEL_PRIMARY && device.m_TimestampsSupported)
+    {
+        auto queryPoolInfo = VkQueryPoolCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+            .queryType = VK_QUERY_TYPE_TIMESTAMP,
+            .queryCount = kMaxTimestamps
+        };
+        LC_CHECK(vkCreateQueryPool(device.m_Handle, &queryPoolInfo, nullptr, &m_TimestampPool));
+    }
+
+    if (level == VK_COMMAND_BUFFER_LEVEL_PRIMARY && device.m_PipelineStatisticsSupported)
+    {
+        auto queryPoolInfo = VkQueryPoolCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+            .queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS,
+            .queryCount = kMaxStatisticsQueries,
+            .pipelineStatistics = kPipelineStatistics
+        };
+        LC_CHECK(vkCreateQueryPool(device.m_Handle, &queryPoolInfo, nullptr, &m_StatisticsPool));
+    }
 }
 
 VulkanContext::~VulkanContext()
 {
+    // Descriptor sets referencing scratch buffers are only cached by this context, so no other needs invalidating
     m_ScratchUniformBuffers.ForEach([this](Buffer* buffer)
-    { m_Device.DestroyBuffer(buffer); });
+    { m_Device.ReleaseBuffer(buffer); });
     m_DescriptorPools.ForEach([this](auto pool)
     { vkDestroyDescriptorPool(m_Device.GetHandle(), pool, nullptr); });
 
@@ -62,53 +109,103 @@ VulkanContext::~VulkanContext()
     vkDestroyCommandPool(m_Device.m_Handle, m_CommandPool, nullptr);
 
     vkDestroyFence(m_Device.m_Handle, m_ReadyFence, nullptr);
+    vkDestroyQueryPool(m_Device.m_Handle, m_TimestampPool, nullptr);
+    vkDestroyQueryPool(m_Device.m_Handle, m_StatisticsPool, nullptr);
 }
 
 void VulkanContext::Begin()
 {
+    LC_ASSERT(m_Level == VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
     vkWaitForFences(m_Device.m_Handle, 1, &m_ReadyFence, VK_TRUE, UINT64_MAX);
     vkResetFences(m_Device.m_Handle, 1, &m_ReadyFence);
 
-    vkResetCommandPool(m_Device.m_Handle, m_CommandPool, 0);
-
-    m_DescriptorPools.ForEach([this](auto pool)
-    {
-        vkResetDescriptorPool(m_Device.GetHandle(), pool, 0);
-    });
-    m_DescriptorSets.clear();
+    ReadRegionTimings();
 
-    ResetUniformBuffers();
+    // Secondary command buffers recorded last time this context was used are also complete
+    ResetRecordingState();
+    m_NumSecondariesUsed = 0;
 
     auto beginInfo = VkCommandBufferBeginInfo{
         .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
         .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
     };
     LC_CHECK(vkBeginCommandBuffer(m_CommandBuffer, &beginInfo));
+
+    if (m_TimestampPool)
+        vkCmdResetQueryPool(m_CommandBuffer, m_TimestampPool, 0, kMaxTimestamps);
+    if (m_StatisticsPool)
+        vkCmdResetQueryPool(m_CommandBuffer, m_StatisticsPool, 0, kMaxStatisticsQueries);
 }
 
 void VulkanContext::End()
 {
+    LC_ASSERT(m_OpenRegions.empty());
+
+    FlushBarriers();
+    FlushUniformBuffers();
+
+    // Results read back by the host, such as GPU counters, are available once the frame's fence is signaled
+    if (m_Level == VK_COMMAND_BUFFER_LEVEL_PRIMARY)
+    {
+        auto hostBarrier = VkMemoryBarrier{
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_HOST_READ_BIT
+        };
+        vkCmdPipelineBarrier(m_CommandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+            1, &hostBarrier, 0, nullptr, 0, nullptr);
+    }
     LC_CHECK(vkEndCommandBuffer(m_CommandBuffer));
+
+    m_Stats.cachedDescriptorSets += m_DescriptorSets.size();
+}
+
+void VulkanContext::ResetRecordingState()
+{
+    vkResetCommandPool(m_Device.m_Handle, m_CommandPool, 0);
+
+    // Commands from the previous use of this context are complete, so cached sets may now be freed or rewritten
+    FreeStaleDescriptorSets();
+    ++m_FrameIndex;
+    m_Stats = {};
+
+    ResetUniformBuffers();
+
+    m_BoundPipeline = nullptr;
+    m_BoundFramebuffer = nullptr;
+    m_BoundSets = {};
+    for (auto& resources: m_BoundResources)
+        resources = {};
+    m_PassAccesses.clear();
 }
 
 void VulkanContext::BeginRenderPass(const Framebuffer* framebuffer)
 {
-    auto& fbuffer = *Get(framebuffer);
+    BeginRenderPass(*Get(framebuffer), VK_SUBPASS_CONTENTS_INLINE);
+}
+
+void VulkanContext::BeginRenderPass(const VulkanFramebuffer& fbuffer, VkSubpassContents contents)
+{
+    LC_ASSERT(m_Level == VK_COMMAND_BUFFER_LEVEL_PRIMARY);
     m_BoundFramebuffer = &fbuffer;
     auto& settings = fbuffer.GetSettings();
 
-    // Transition attachments
+    // Transition attachments, which stay in their attachment layouts until another access needs them to change
     for (auto color: settings.colorTextures)
     {
-        TransitionLayout(color, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-            VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+        AccessTexture(Get(color), VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+            VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, true);
     }
     if (settings.depthTexture)
     {
-        TransitionLayout(settings.depthTexture,
+        AccessTexture(Get(settings.depthTexture),
             VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
-            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, true);
     }
+    FlushBarriers();
 
     Viewport(fbuffer.extent.width, fbuffer.extent.height);
 
@@ -121,30 +218,131 @@ void VulkanContext::BeginRenderPass(const Framebuffer* framebuffer)
             .extent = fbuffer.extent
         }
     };
-    vkCmdBeginRenderPass(m_CommandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBeginRenderPass(m_CommandBuffer, &renderPassBeginInfo, contents);
 }
 
 void VulkanContext::EndRenderPass()
 {
-    auto framebuffer = m_BoundFramebuffer;
-    auto& settings = framebuffer->GetSettings();
-
     vkCmdEndRenderPass(m_CommandBuffer);
+    m_BoundFramebuffer = nullptr;
+}
 
-    // Transition attachments
-    for (auto color: settings.colorTextures)
+void VulkanContext::RecordParallel(const std::vector<const Framebuffer*>& renderPasses, uint32 tasksPerPass,
+    const RecordTask& record)
+{
+    LC_ASSERT(m_Level == VK_COMMAND_BUFFER_LEVEL_PRIMARY && !m_BoundFramebuffer);
+    tasksPerPass = Max(tasksPerPass, 1u);
+
+    // Acquire contexts up front so workers never modify the list of secondaries
+    std::vector<VulkanContext*> secondaries;
+    for (uint32 i = 0; i < renderPasses.size() * tasksPerPass; ++i)
+        secondaries.push_back(&NextSecondary());
+
+    // Without inherited queries, secondaries must not execute within a statistics query, so the query of the region
+    // is ended early and the region reports no statistics
+    VkQueryPipelineStatisticFlags inheritedStatistics = 0;
+    if (m_StatisticsQueryActive && m_Device.m_InheritedQueriesSupported)
     {
-        RestoreLayout(color, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-            VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+        inheritedStatistics = kPipelineStatistics;
     }
-    if (settings.depthTexture)
+    else if (m_StatisticsQueryActive)
     {
-        RestoreLayout(settings.depthTexture,
-            VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
-            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+        auto it = std::find_if(m_OpenRegions.begin(), m_OpenRegions.end(), [this](uint32 index)
+        { return m_Regions[index].statisticsQuery != ~0u; });
+        LC_ASSERT(it != m_OpenRegions.end());
+
+        auto& region = m_Regions[*it];
+        FlushBarriers();
+        vkCmdEndQuery(m_CommandBuffer, m_StatisticsPool, region.statisticsQuery);
+        region.statisticsSkipped = true;
+        m_StatisticsQueryActive = false;
+    }
+
+    std::vector<std::future<void>> recorded;
+    for (uint32 pass = 0; pass < renderPasses.size(); ++pass)
+    {
+        auto framebuffer = Get(renderPasses[pass]);
+        for (uint32 task = 0; task < tasksPerPass; ++task)
+        {
+            auto secondary = secondaries[pass * tasksPerPass + task];
+            recorded.push_back(m_Device.GetWorkers().Submit([=, &record]
+            {
+                secondary->BeginSecondary(*framebuffer, inheritedStatistics);
+                record(*secondary, pass, task);
+                secondary->End();
+            }));
+        }
+    }
+    for (auto& future: recorded)
+        future.get();
+
+    // Execute in submission order, so the first task of each pass runs first
+    std::vector<VkCommandBuffer> commandBuffers(tasksPerPass);
+    for (uint32 pass = 0; pass < renderPasses.size(); ++pass)
+    {
+        BeginRenderPass(*Get(renderPasses[pass]), VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+        for (uint32 task = 0; task < tasksPerPass; ++task)
+        {
+            auto secondary = secondaries[pass * tasksPerPass + task];
+            commandBuffers[task] = secondary->m_CommandBuffer;
+
+            m_Stats += secondary->m_Stats;
+
+            for (auto& access: secondary->m_PassAccesses)
+                ApplyPassAccess(access);
+        }
+        vkCmdExecuteCommands(m_CommandBuffer, commandBuffers.size(), commandBuffers.data());
+
+        EndRenderPass();
     }
 }
 
+uint32 VulkanContext::GetNumRecordingThreads()
+{
+    return m_Device.GetWorkers().GetNumThreads();
+}
+
+const ContextStats& VulkanContext::GetStats()
+{
+    return m_Stats;
+}
+
+VulkanContext& VulkanContext::NextSecondary()
+{
+    if (m_NumSecondariesUsed == m_Secondaries.size())
+        m_Secondaries.push_back(std::make_unique<VulkanContext>(m_Device, VK_COMMAND_BUFFER_LEVEL_SECONDARY));
+
+    return *m_Secondaries[m_NumSecondariesUsed++];
+}
+
+void VulkanContext::BeginSecondary(const VulkanFramebuffer& framebuffer,
+    VkQueryPipelineStatisticFlags inheritedStatistics)
+{
+    LC_ASSERT(m_Level == VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+
+    ResetRecordingState();
+    m_BoundFramebuffer = &framebuffer;
+
+    auto inheritanceInfo = VkCommandBufferInheritanceInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+        .renderPass = framebuffer.renderPass,
+        .subpass = 0,
+        .framebuffer = framebuffer.handle,
+        .pipelineStatistics = inheritedStatistics
+    };
+
+    auto beginInfo = VkCommandBufferBeginInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+        .pInheritanceInfo = &inheritanceInfo
+    };
+    LC_CHECK(vkBeginCommandBuffer(m_CommandBuffer, &beginInfo));
+
+    // Dynamic state is not inherited from the primary command buffer
+    Viewport(framebuffer.extent.width, framebuffer.extent.height);
+}
+
 void VulkanContext::Clear(Color color, float depth)
 {
     LC_ASSERT(m_BoundFramebuffer);
@@ -186,12 +384,33 @@ void VulkanContext::Viewport(uint32 width, uint32 height)
         .minDepth = 0.0f, .maxDepth = 1.0f
     };
     vkCmdSetViewport(m_CommandBuffer, 0, 1, &viewport);
+
+    auto scissor = VkRect2D{
+        .offset = {},
+        .extent = { width, height }
+    };
+    vkCmdSetScissor(m_CommandBuffer, 0, 1, &scissor);
 }
 
 void VulkanContext::BindPipeline(const Pipeline* pipeline)
 {
     m_BoundPipeline = Get(pipeline);
+    LC_ASSERT(m_BoundPipeline->handle && "Pipeline failed to build, its shader didn't compile");
     vkCmdBindPipeline(m_CommandBuffer, GetBindPoint(m_BoundPipeline->GetType()), m_BoundPipeline->handle);
+
+    // The global texture array is never modified by the context, so is bound once with the pipeline
+    auto& shader = *m_BoundPipeline->shader;
+    if (shader.bindless)
+    {
+        vkCmdBindDescriptorSets(m_CommandBuffer,
+            GetBindPoint(m_BoundPipeline->GetType()),
+            shader.pipelineLayout,
+            VulkanShader::kBindlessSet,
+            1,
+            &m_Device.m_BindlessSet,
+            0,
+            nullptr);
+    }
 }
 
 void VulkanContext::BindBuffer(const Buffer* buffer)
@@ -200,12 +419,14 @@ void VulkanContext::BindBuffer(const Buffer* buffer)
     switch (buff.type)
     {
     case BufferType::kVertex:
+    case BufferType::kStaticVertex:
     {
         VkDeviceSize offset = 0;
         vkCmdBindVertexBuffers(m_CommandBuffer, 0, 1, &buff.handle, &offset);
         break;
     }
     case BufferType::kIndex:
+    case BufferType::kStaticIndex:
     {
         vkCmdBindIndexBuffer(m_CommandBuffer, buff.handle, 0, VK_INDEX_TYPE_UINT32);
         break;
@@ -219,30 +440,81 @@ void VulkanContext::BindBuffer(const Buffer* buffer)
     }
 }
 
-void VulkanContext::Draw(uint32 indexCount)
+void VulkanContext::Draw(uint32 indexCount, uint32 firstIndex, int32 vertexOffset)
+{
+    DrawInstanced(indexCount, 1, 0, firstIndex, vertexOffset);
+}
+
+void VulkanContext::DrawInstanced(uint32 indexCount, uint32 instanceCount, uint32 firstInstance, uint32 firstIndex,
+    int32 vertexOffset)
+{
+    BindDescriptorSets();
+    AccessBoundResources(VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+    vkCmdDrawIndexed(m_CommandBuffer, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+    ++m_Stats.draws;
+    ResetScratchAllocations();
+}
+
+void VulkanContext::DrawIndirect(const Buffer* commands, uint32 offset, uint32 drawCount)
+{
+    auto buffer = Get(commands);
+    LC_ASSERT(buffer->type == BufferType::kIndirect);
+
+    BindDescriptorSets();
+    AccessBoundResources(VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+    // Commands are read inside the render pass, so later writes to them must wait for the draws
+    RecordPassAccess(PassAccess{ .buffer = buffer, .stage = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, .write = false });
+
+    // Without multi-draw support each command needs its own draw
+    if (m_Device.m_MultiDrawIndirectSupported)
+    {
+        vkCmdDrawIndexedIndirect(m_CommandBuffer, buffer->handle, offset, drawCount,
+            sizeof(VkDrawIndexedIndirectCommand));
+    }
+    else
+    {
+        constexpr auto stride = sizeof(VkDrawIndexedIndirectCommand);
+        for (uint32 i = 0; i < drawCount; ++i)
+            vkCmdDrawIndexedIndirect(m_CommandBuffer, buffer->handle, offset + i * stride, 1, stride);
+    }
+    m_Stats.draws += drawCount;
+    ResetScratchAllocations();
+}
+
+void VulkanContext::DrawIndirectCount(const Buffer* commands, uint32 offset, const Buffer* count, uint32 countOffset,
+    uint32 maxDrawCount)
 {
+    auto buffer = Get(commands);
+    auto countBuffer = Get(count);
+    LC_ASSERT(m_Device.m_IndirectDrawCountSupported);
+    LC_ASSERT(buffer->type == BufferType::kIndirect && countBuffer->type == BufferType::kIndirect);
+
     BindDescriptorSets();
-    vkCmdDrawIndexed(m_CommandBuffer, indexCount, 1, 0, 0, 0);
+    AccessBoundResources(VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+    RecordPassAccess(PassAccess{ .buffer = buffer, .stage = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, .write = false });
+    RecordPassAccess(PassAccess{ .buffer = countBuffer, .stage = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, .write = false });
+
+    vkCmdDrawIndexedIndirectCount(m_CommandBuffer, buffer->handle, offset, countBuffer->handle, countOffset,
+        maxDrawCount, sizeof(VkDrawIndexedIndirectCommand));
+
+    // The number of draws is only known on the device, so the call counts as a single command
+    ++m_Stats.draws;
     ResetScratchAllocations();
 }
 
 void VulkanContext::Dispatch(uint32 x, uint32 y, uint32 z)
 {
+    // Only resources written by earlier commands and read by this dispatch need a barrier
     BindDescriptorSets();
+    AccessBoundResources(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    FlushBarriers();
+
     vkCmdDispatch(m_CommandBuffer, x, y, z);
+    ++m_Stats.dispatches;
     ResetScratchAllocations();
-
-    // TODO: More granular compute sync
-    auto barrier = VkMemoryBarrier{
-        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
-        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
-        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT
-    };
-    vkCmdPipelineBarrier(m_CommandBuffer,
-        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-        VK_DEPENDENCY_BY_REGION_BIT,
-        1, &barrier, 0, nullptr, 0, nullptr);
 }
 
 void VulkanContext::CopyTexture(
@@ -253,6 +525,10 @@ void VulkanContext::CopyTexture(
     auto src = Get(source);
     auto dst = Get(dest);
 
+    BeginSubresourceAccess(src);
+    BeginSubresourceAccess(dst);
+    FlushBarriers();
+
     TransitionLayout(src, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT,
         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, srcLayer, srcLevel);
     TransitionLayout(dst, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
@@ -282,6 +558,9 @@ void VulkanContext::CopyTexture(
         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, srcLayer, srcLevel);
     RestoreLayout(dst, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, dstLayer, dstLevel);
+
+    EndSubresourceAccess(src);
+    EndSubresourceAccess(dst);
 }
 
 void VulkanContext::CopyTexture(
@@ -292,6 +571,10 @@ void VulkanContext::CopyTexture(
     auto src = Get(source);
     auto dst = Get(dest);
 
+    BeginSubresourceAccess(src);
+    AccessBuffer(dst, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, true);
+    FlushBarriers();
+
     TransitionLayout(src, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT,
         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, srcLayer, srcLevel);
 
@@ -312,6 +595,8 @@ void VulkanContext::CopyTexture(
 
     RestoreLayout(src, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT,
         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, srcLayer, srcLevel);
+
+    EndSubresourceAccess(src);
 }
 
 void VulkanContext::CopyTexture(
@@ -322,6 +607,10 @@ void VulkanContext::CopyTexture(
     auto src = Get(source);
     auto dst = Get(dest);
 
+    AccessBuffer(src, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, false);
+    BeginSubresourceAccess(dst);
+    FlushBarriers();
+
     TransitionLayout(dst, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, dstLayer, dstLevel);
 
@@ -342,6 +631,8 @@ void VulkanContext::CopyTexture(
 
     RestoreLayout(dst, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, dstLayer, dstLevel);
+
+    EndSubresourceAccess(dst);
 }
 
 void VulkanContext::BlitTexture(
@@ -357,6 +648,10 @@ void VulkanContext::BlitTexture(
     auto dstWidth = Max((int32)dst->GetSettings().width >> dstLevel, 1);
     auto dstHeight = Max((int32)dst->GetSettings().height >> dstLevel, 1);
 
+    BeginSubresourceAccess(src);
+    BeginSubresourceAccess(dst);
+    FlushBarriers();
+
     TransitionLayout(src, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT,
         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, srcLayer, srcLevel);
     TransitionLayout(dst, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
@@ -385,6 +680,9 @@ void VulkanContext::BlitTexture(
         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, srcLayer, srcLevel);
     RestoreLayout(dst, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, dstLayer, dstLevel);
+
+    EndSubresourceAccess(src);
+    EndSubresourceAccess(dst);
 }
 
 void VulkanContext::GenerateMips(Texture* texture)
@@ -398,10 +696,48 @@ void VulkanContext::GenerateMips(Texture* texture)
     }
 }
 
+void VulkanContext::Transition(const ResourceTransitions& transitions)
+{
+    for (auto texture: transitions.discards)
+        DiscardTexture(Get(texture));
+
+    // Commands within a render pass can't record barriers, so sampled textures are prepared up front
+    for (auto texture: transitions.reads)
+    {
+        auto tex = Get(texture);
+        PrepareTexture(tex, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_ACCESS_SHADER_READ_BIT, tex->GetStartingLayout());
+    }
+
+    // Attachments and copy destinations are transitioned by the commands which write them
+    for (auto texture: transitions.writes)
+    {
+        auto tex = Get(texture);
+        if (tex->GetSettings().usage == TextureUsage::kReadWrite)
+        {
+            PrepareTexture(tex, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL);
+        }
+    }
+
+    for (auto buffer: transitions.bufferReads)
+    {
+        PrepareBuffer(Get(buffer),
+            kShaderStages | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+            VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
+            VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+    }
+    for (auto buffer: transitions.bufferWrites)
+        PrepareBuffer(Get(buffer), kShaderStages, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+    FlushBarriers();
+}
+
 void VulkanContext::BindBuffer(Descriptor* descriptor, const Buffer* generalBuffer)
 {
     auto buffer = Get(generalBuffer);
-    LC_ASSERT(buffer->type == BufferType::kUniform || buffer->type == BufferType::kStorage);
+    LC_ASSERT(buffer->type == BufferType::kUniform || buffer->type == BufferType::kStorage ||
+        buffer->type == BufferType::kDeviceStorage || buffer->type == BufferType::kIndirect);
 
     auto& bound = m_BoundSets[descriptor->set];
     bound.bindings[descriptor->binding] = { (buffer->type == BufferType::kUniform) ?
@@ -444,16 +780,16 @@ void VulkanContext::Uniform(Descriptor* descriptor, const uint8* data, size_t si
 {
     LC_ASSERT(descriptor->size == size);
 
-    auto offset = GetUniformBufferOffset(descriptor->set, descriptor->binding);
-    m_ScratchUniformBuffers.Get()->Upload(data, size, offset + descriptor->offset);
+    auto block = GetUniformBlock(descriptor->set, descriptor->binding);
+    memcpy(block + descriptor->offset, data, size);
 }
 
 void VulkanContext::Uniform(Descriptor* descriptor, uint32 arrayIndex, const uint8* data, size_t size)
 {
     LC_ASSERT(descriptor->size == size);
 
-    auto offset = GetUniformBufferOffset(descriptor->set, descriptor->binding);
-    m_ScratchUniformBuffers.Get()->Upload(data, size, offset + descriptor->offset + arrayIndex * size);
+    auto block = GetUniformBlock(descriptor->set, descriptor->binding);
+    memcpy(block + descriptor->offset + arrayIndex * size, data, size);
 }
 
 void VulkanContext::BindDescriptorSets()
@@ -480,139 +816,242 @@ void VulkanContext::BindDescriptorSets()
                 set.dynamicOffsets.size(),
                 set.dynamicOffsets.data());
 
+            auto& resources = m_BoundResources[setIndex];
+            resources.textures.clear();
+            resources.images.clear();
+            resources.storageBuffers.clear();
+            for (uint32 bindingIndex = 0; bindingIndex < set.bindings.size(); ++bindingIndex)
+            {
+                auto& binding = set.bindings[bindingIndex];
+                if (binding.type == Binding::kTexture)
+                    resources.textures.push_back(binding.texture);
+                else if (binding.type == Binding::kImage)
+                    resources.images.push_back(binding.texture);
+                else if (binding.type == Binding::kStorageBuffer)
+                    resources.storageBuffers.push_back({ binding.buffer, bindingIndex });
+            }
+
             set = {};
         }
     }
 }
 
-size_t VulkanContext::BindingHash::operator()(const VulkanContext::BindingArray& bindings) const
+size_t VulkanContext::DescriptorSetKeyHash::operator()(const DescriptorSetKey& key) const
 {
-    return HashBytes<size_t>(bindings);
+    // Hash fields individually, as padding within bindings is not guaranteed to be zeroed
+    auto hash = HashBytes<size_t>(key.layout);
+    for (auto& binding: key.bindings)
+    {
+        hash = HashBytes(binding.type, hash);
+        hash = HashBytes(binding.data, hash);
+        hash = HashBytes(binding.level, hash);
+    }
+    return hash;
 }
 
 VkDescriptorSet VulkanContext::FindDescriptorSet(const BindingArray& bindings, VkDescriptorSetLayout layout)
 {
-    auto it = m_DescriptorSets.find(bindings);
-    if (it == m_DescriptorSets.end())
-    {
-        // Allocate new set
-        auto allocInfo = VkDescriptorSetAllocateInfo{
-            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
-            .descriptorPool = m_DescriptorPools.Get(),
-            .descriptorSetCount = 1,
-            .pSetLayouts = &layout,
-        };
+    LC_PROFILE_ZONE("VulkanContext::FindDescriptorSet");
+    ++m_Stats.descriptorSetLookups;
 
-        VkDescriptorSet set;
-        auto result = vkAllocateDescriptorSets(m_Device.GetHandle(), &allocInfo, &set);
+    auto key = DescriptorSetKey{ bindings, layout };
 
-        if (result == VK_ERROR_OUT_OF_POOL_MEMORY)
+    auto it = m_DescriptorSets.find(key);
+    if (it != m_DescriptorSets.end())
+    {
+        auto& cached = it->second;
+        if (cached.lastUsedFrame != m_FrameIndex)
         {
-            allocInfo.descriptorPool = m_DescriptorPools.Allocate();
-            result = vkAllocateDescriptorSets(m_Device.GetHandle(), &allocInfo, &set);
+            cached.lastUsedFrame = m_FrameIndex;
+            m_DescriptorSetLru.splice(m_DescriptorSetLru.begin(), m_DescriptorSetLru, cached.lru);
         }
-        LC_CHECK(result);
+        return cached.handle;
+    }
 
-        // Fill set with bindings
-        Array <VkWriteDescriptorSet, VulkanShader::kMaxBindingsPerSet> writes{};
-        Array <VkDescriptorBufferInfo, VulkanShader::kMaxBindingsPerSet> bufferWrites{};
-        Array <VkDescriptorImageInfo, VulkanShader::kMaxBindingsPerSet> imageWrites{};
+    EvictDescriptorSets();
 
-        for (int bindIndex = 0; bindIndex < bindings.size(); ++bindIndex)
-        {
-            auto& binding = bindings[bindIndex];
+    VkDescriptorPool pool;
+    auto set = AllocateDescriptorSet(layout, pool);
+    ++m_Stats.descriptorSetAllocations;
 
-            VkDescriptorImageInfo* imageInfo = nullptr;
-            VkDescriptorBufferInfo* bufferInfo = nullptr;
-            VkDescriptorType descriptorType{};
+    // Fill set with bindings
+    Array <VkWriteDescriptorSet, VulkanShader::kMaxBindingsPerSet> writes{};
+    Array <VkDescriptorBufferInfo, VulkanShader::kMaxBindingsPerSet> bufferWrites{};
+    Array <VkDescriptorImageInfo, VulkanShader::kMaxBindingsPerSet> imageWrites{};
 
-            switch (binding.type)
-            {
-            case Binding::kNone:
-                continue;
+    for (int bindIndex = 0; bindIndex < bindings.size(); ++bindIndex)
+    {
+        auto& binding = bindings[bindIndex];
 
-            case Binding::kUniformBuffer:
-            {
-                bufferInfo = &bufferWrites.emplace_back(VkDescriptorBufferInfo{
-                    .buffer = binding.buffer->handle,
-                    .offset = 0,
-                    .range = VK_WHOLE_SIZE
-                });
-                descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-                break;
-            }
+        VkDescriptorImageInfo* imageInfo = nullptr;
+        VkDescriptorBufferInfo* bufferInfo = nullptr;
+        VkDescriptorType descriptorType{};
 
-            case Binding::kUniformBufferDynamic:
-            {
-                bufferInfo = &bufferWrites.emplace_back(VkDescriptorBufferInfo{
-                    .buffer = binding.buffer->handle,
-                    .offset = 0,
-                    .range = VK_WHOLE_SIZE
-                });
-                descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-                break;
-            }
+        switch (binding.type)
+        {
+        case Binding::kNone:
+            continue;
 
-            case Binding::kStorageBuffer:
-            {
-                bufferInfo = &bufferWrites.emplace_back(VkDescriptorBufferInfo{
-                    .buffer = binding.buffer->handle,
-                    .offset = 0,
-                    .range = VK_WHOLE_SIZE
-                });
-                descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-                break;
-            }
+        case Binding::kUniformBuffer:
+        {
+            bufferInfo = &bufferWrites.emplace_back(VkDescriptorBufferInfo{
+                .buffer = binding.buffer->handle,
+                .offset = 0,
+                .range = VK_WHOLE_SIZE
+            });
+            descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            break;
+        }
 
-            case Binding::kTexture:
-            {
-                auto view = binding.level >= 0 ?
-                    binding.texture->mipViews[binding.level] :
-                    binding.texture->imageView;
-
-                imageInfo = &imageWrites.emplace_back(VkDescriptorImageInfo{
-                    .sampler = binding.texture->sampler,
-                    .imageView = view,
-                    .imageLayout = binding.texture->GetSettings().usage == TextureUsage::kReadWrite ?
-                        VK_IMAGE_LAYOUT_GENERAL :
-                        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-                });
-                descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-                break;
-            }
+        case Binding::kUniformBufferDynamic:
+        {
+            bufferInfo = &bufferWrites.emplace_back(VkDescriptorBufferInfo{
+                .buffer = binding.buffer->handle,
+                .offset = 0,
+                .range = VK_WHOLE_SIZE
+            });
+            descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+            break;
+        }
 
-            case Binding::kImage:
-            {
-                auto view = binding.level >= 0 ?
-                    binding.texture->mipViews[binding.level] :
-                    binding.texture->imageView;
-
-                imageInfo = &imageWrites.emplace_back(VkDescriptorImageInfo{
-                    .sampler = binding.texture->sampler,
-                    .imageView = view,
-                    .imageLayout = VK_IMAGE_LAYOUT_GENERAL
-                });
-                descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-                break;
-            }
-            }
+        case Binding::kStorageBuffer:
+        {
+            bufferInfo = &bufferWrites.emplace_back(VkDescriptorBufferInfo{
+                .buffer = binding.buffer->handle,
+                .offset = 0,
+                .range = VK_WHOLE_SIZE
+            });
+            descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            break;
+        }
+
+        case Binding::kTexture:
+        {
+            auto view = binding.level >= 0 ?
+                binding.texture->mipViews[binding.level] :
+                binding.texture->imageView;
+
+            imageInfo = &imageWrites.emplace_back(VkDescriptorImageInfo{
+                .sampler = binding.texture->sampler,
+                .imageView = view,
+                .imageLayout = binding.texture->GetSettings().usage == TextureUsage::kReadWrite ?
+                    VK_IMAGE_LAYOUT_GENERAL :
+                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+            });
+            descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            break;
+        }
 
-            writes.emplace_back(VkWriteDescriptorSet{
-                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-                .dstSet = set,
-                .dstBinding = static_cast<uint32>(bindIndex),
-                .dstArrayElement = 0,
-                .descriptorCount = 1,
-                .descriptorType = descriptorType,
-                .pImageInfo = imageInfo,
-                .pBufferInfo = bufferInfo
+        case Binding::kImage:
+        {
+            auto view = binding.level >= 0 ?
+                binding.texture->mipViews[binding.level] :
+                binding.texture->imageView;
+
+            imageInfo = &imageWrites.emplace_back(VkDescriptorImageInfo{
+                .sampler = binding.texture->sampler,
+                .imageView = view,
+                .imageLayout = VK_IMAGE_LAYOUT_GENERAL
             });
+            descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            break;
         }
-        vkUpdateDescriptorSets(m_Device.m_Handle, writes.size(), writes.data(), 0, nullptr);
+        }
+
+        writes.emplace_back(VkWriteDescriptorSet{
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = set,
+            .dstBinding = static_cast<uint32>(bindIndex),
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = descriptorType,
+            .pImageInfo = imageInfo,
+            .pBufferInfo = bufferInfo
+        });
+    }
+    vkUpdateDescriptorSets(m_Device.m_Handle, writes.size(), writes.data(), 0, nullptr);
+    m_Stats.descriptorWrites += writes.size();
+
+    m_DescriptorSetLru.push_front(key);
+    m_DescriptorSets.emplace(key, CachedDescriptorSet{
+        .handle = set,
+        .pool = pool,
+        .lastUsedFrame = m_FrameIndex,
+        .lru = m_DescriptorSetLru.begin()
+    });
+
+    return set;
+}
+
+VkDescriptorSet VulkanContext::AllocateDescriptorSet(VkDescriptorSetLayout layout, VkDescriptorPool& pool)
+{
+    auto allocInfo = VkDescriptorSetAllocateInfo{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = m_DescriptorPools.Get(),
+        .descriptorSetCount = 1,
+        .pSetLayouts = &layout,
+    };
+
+    VkDescriptorSet set;
+    auto result = vkAllocateDescriptorSets(m_Device.GetHandle(), &allocInfo, &set);
+
+    if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+    {
+        allocInfo.descriptorPool = m_DescriptorPools.Allocate();
+        result = vkAllocateDescriptorSets(m_Device.GetHandle(), &allocInfo, &set);
+    }
+    LC_CHECK(result);
+
+    pool = allocInfo.descriptorPool;
+    return set;
+}
+
+void VulkanContext::EvictDescriptorSets()
+{
+    // Sets used earlier in this frame may be referenced by recorded commands, so the cache can grow past its limit
+    while (m_DescriptorSets.size() >= kMaxCachedDescriptorSets)
+    {
+        auto it = m_DescriptorSets.find(m_DescriptorSetLru.back());
+        auto& cached = it->second;
+        if (cached.lastUsedFrame == m_FrameIndex)
+            break;
+
+        vkFreeDescriptorSets(m_Device.GetHandle(), cached.pool, 1, &cached.handle);
+        m_DescriptorSetLru.pop_back();
+        m_DescriptorSets.erase(it);
+    }
+}
 
-        it = m_DescriptorSets.insert(it, { bindings, set });
+void VulkanContext::FreeStaleDescriptorSets()
+{
+    for (auto[set, pool]: m_StaleDescriptorSets)
+        vkFreeDescriptorSets(m_Device.GetHandle(), pool, 1, &set);
+
+    m_StaleDescriptorSets.clear();
+}
+
+void VulkanContext::InvalidateDescriptorSets(const void* resource)
+{
+    for (auto it = m_DescriptorSets.begin(); it != m_DescriptorSets.end();)
+    {
+        auto& bindings = it->first.bindings;
+        bool referenced = std::any_of(bindings.begin(), bindings.end(), [&](auto& binding)
+        { return binding.type != Binding::kNone && binding.data == resource; });
+
+        if (referenced)
+        {
+            m_StaleDescriptorSets.emplace_back(it->second.handle, it->second.pool);
+            m_DescriptorSetLru.erase(it->second.lru);
+            it = m_DescriptorSets.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
     }
-    return it->second;
+
+    for (auto& secondary: m_Secondaries)
+        secondary->InvalidateDescriptorSets(resource);
 }
 
 VkDescriptorPool VulkanContext::AllocateDescriptorPool() const
@@ -645,6 +1084,7 @@ VkDescriptorPool VulkanContext::AllocateDescriptorPool() const
 
     auto descPoolInfo = VkDescriptorPoolCreateInfo{
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT,
         .maxSets = 4096,
         .poolSizeCount = LC_ARRAY_SIZE(descPoolSizes),
         .pPoolSizes = descPoolSizes
@@ -656,7 +1096,11 @@ VkDescriptorPool VulkanContext::AllocateDescriptorPool() const
 
 Buffer* VulkanContext::AllocateUniformBuffer()
 {
-    return m_Device.CreateBuffer(BufferType::kUniformDynamic, kScratchBufferSize);
+    // Scratch buffers stay mapped for their whole lifetime so uniforms can be written directly
+    auto buffer = m_Device.CreateBuffer(BufferType::kUniformDynamic, kScratchBufferSize);
+    buffer->Map();
+
+    return buffer;
 }
 
 void VulkanContext::ResetUniformBuffers()
@@ -664,9 +1108,18 @@ void VulkanContext::ResetUniformBuffers()
     m_ScratchAllocations.clear();
     m_ScratchDrawOffset = 0;
     m_ScratchUniformBuffers.Reset();
+    m_ScratchBytesUsed.clear();
+}
+
+void VulkanContext::FlushUniformBuffers()
+{
+    // Only the bytes written this frame, which is free for coherent memory
+    size_t index = 0;
+    m_ScratchUniformBuffers.ForEachActive([&](Buffer* buffer)
+    { Get(buffer)->Flush(m_ScratchBytesUsed[index++], 0); });
 }
 
-uint32 VulkanContext::GetUniformBufferOffset(uint32 set, uint32 binding)
+uint8* VulkanContext::GetUniformBlock(uint32 set, uint32 binding)
 {
     auto matchBinding = [=](auto& arg)
     {
@@ -690,16 +1143,20 @@ uint32 VulkanContext::GetUniformBufferOffset(uint32 set, uint32 binding)
         auto alignment = m_Device.m_DeviceProperties.limits.minUniformBufferOffsetAlignment;
         offset += (alignment - (offset % alignment)) % alignment;
 
-        // Append new buffer if out of space
-        if (offset + block->size > kScratchBufferSize)
+        // Append new buffer if out of space, or if none is in use yet
+        if (m_ScratchBytesUsed.empty() || offset + block->size > kScratchBufferSize)
         {
             offset = m_ScratchDrawOffset = 0;
             m_ScratchUniformBuffers.Allocate();
+            m_ScratchBytesUsed.push_back(0);
         }
+        m_ScratchBytesUsed.back() = offset + block->size;
 
         // Clear new allocation
-        auto uniformBuffer = m_ScratchUniformBuffers.Get();
-        uniformBuffer->Clear(block->size, offset);
+        auto uniformBuffer = Get(m_ScratchUniformBuffers.Get());
+        auto data = static_cast<uint8*>(uniformBuffer->mappedPointer) + offset;
+        memset(data, 0, block->size);
+        m_Stats.uniformBytes += block->size;
 
         // Bind to uniform block
         BindBuffer(set, binding, uniformBuffer, offset);
@@ -708,10 +1165,11 @@ uint32 VulkanContext::GetUniformBufferOffset(uint32 set, uint32 binding)
             .set = set,
             .binding = binding,
             .offset = offset,
-            .size = block->size
+            .size = block->size,
+            .data = data
         });
     }
-    return it->offset;
+    return it->data;
 }
 
 void VulkanContext::ResetScratchAllocations()
@@ -729,8 +1187,134 @@ const Pipeline* VulkanContext::BoundPipeline()
     return m_BoundPipeline;
 }
 
+void VulkanContext::BeginRegion(const char* label)
+{
+    if (m_Device.m_CmdBeginDebugLabel)
+    {
+        auto labelInfo = VkDebugUtilsLabelEXT{
+            .sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT,
+            .pLabelName = label
+        };
+        m_Device.m_CmdBeginDebugLabel(m_CommandBuffer, &labelInfo);
+    }
+
+    m_OpenRegions.push_back(static_cast<uint32>(m_Regions.size()));
+    auto& region = m_Regions.emplace_back(TimedRegion{
+        .label = label,
+        .depth = static_cast<uint32>(m_OpenRegions.size() - 1),
+        .startQuery = ~0u,
+        .endQuery = ~0u,
+        .statisticsQuery = ~0u
+    });
+
+    // Regions which don't fit are still labelled, but not timed
+    if (m_TimestampPool && m_NumTimestamps + 2 <= kMaxTimestamps)
+    {
+        region.startQuery = m_NumTimestamps++;
+        vkCmdWriteTimestamp(m_CommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_TimestampPool, region.startQuery);
+    }
+
+    // Queries of the same type can't be active at once, so statistics of nested regions are part of their parent's
+    if (m_StatisticsEnabled && m_StatisticsPool && !m_StatisticsQueryActive &&
+        m_NumStatisticsQueries < kMaxStatisticsQueries)
+    {
+        region.statisticsQuery = m_NumStatisticsQueries++;
+        vkCmdBeginQuery(m_CommandBuffer, m_StatisticsPool, region.statisticsQuery, 0);
+        m_StatisticsQueryActive = true;
+    }
+}
+
+void VulkanContext::EndRegion()
+{
+    LC_ASSERT(!m_OpenRegions.empty());
+
+    auto& region = m_Regions[m_OpenRegions.back()];
+    m_OpenRegions.pop_back();
+
+    // Barriers batched inside the region belong to its commands
+    FlushBarriers();
+
+    if (region.startQuery != ~0u)
+    {
+        region.endQuery = m_NumTimestamps++;
+        vkCmdWriteTimestamp(m_CommandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_TimestampPool, region.endQuery);
+    }
+
+    if (region.statisticsQuery != ~0u && !region.statisticsSkipped)
+    {
+        vkCmdEndQuery(m_CommandBuffer, m_StatisticsPool, region.statisticsQuery);
+        m_StatisticsQueryActive = false;
+    }
+
+    if (m_Device.m_CmdEndDebugLabel)
+        m_Device.m_CmdEndDebugLabel(m_CommandBuffer);
+}
+
+const std::vector<RegionTiming>& VulkanContext::GetRegionTimings()
+{
+    return m_RegionTimings;
+}
+
+void VulkanContext::EnablePipelineStatistics(bool enable)
+{
+    m_StatisticsEnabled = enable;
+}
+
+void VulkanContext::ReadRegionTimings()
+{
+    m_RegionTimings.clear();
+
+    std::array<uint64, kMaxTimestamps> timestamps{};
+    auto timed = m_NumTimestamps > 0 && vkGetQueryPoolResults(m_Device.m_Handle, m_TimestampPool, 0,
+        m_NumTimestamps, m_NumTimestamps * sizeof(uint64), timestamps.data(), sizeof(uint64),
+        VK_QUERY_RESULT_64_BIT) == VK_SUCCESS;
+
+    // Results are written in the same order as the statistics of the struct
+    static_assert(sizeof(PipelineStatistics) == 6 * sizeof(uint64));
+    std::array<PipelineStatistics, kMaxStatisticsQueries> statistics{};
+    auto counted = m_NumStatisticsQueries > 0 && vkGetQueryPoolResults(m_Device.m_Handle, m_StatisticsPool, 0,
+        m_NumStatisticsQueries, m_NumStatisticsQueries * sizeof(PipelineStatistics), statistics.data(),
+        sizeof(PipelineStatistics), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS;
+
+    // Ticks are converted with the device's tick period, in nanoseconds
+    auto period = static_cast<double>(m_Device.GetLimits().timestampPeriod) * 1e-6;
+    for (auto& region: m_Regions)
+    {
+        auto regionTimed = timed && region.endQuery != ~0u;
+        auto regionCounted = counted && region.statisticsQuery != ~0u && !region.statisticsSkipped;
+        if (!regionTimed && !regionCounted)
+            continue;
+
+        auto& timing = m_RegionTimings.emplace_back(RegionTiming{
+            .label = region.label,
+            .depth = region.depth,
+            .statisticsSkipped = region.statisticsSkipped
+        });
+
+        if (regionTimed)
+        {
+            auto start = timestamps[region.startQuery];
+            auto end = Max(timestamps[region.endQuery], start);
+            timing.startMs = static_cast<double>(start) * period;
+            timing.durationMs = static_cast<float>(static_cast<double>(end - start) * period);
+        }
+
+        if (regionCounted)
+        {
+            timing.hasStatistics = true;
+            timing.statistics = statistics[region.statisticsQuery];
+        }
+    }
+
+    m_Regions.clear();
+    m_OpenRegions.clear();
+    m_NumTimestamps = 0;
+    m_NumStatisticsQueries = 0;
+    m_StatisticsQueryActive = false;
+}
+
 void VulkanContext::TransitionLayout(const Texture* generalTexture, VkPipelineStageFlags stage,
-    VkAccessFlags access, VkImageLayout layout, uint32 layer, uint32 level) const
+    VkAccessFlags access, VkImageLayout layout, uint32 layer, uint32 level)
 {
     auto texture = Get(generalTexture);
 
@@ -759,10 +1343,12 @@ void VulkanContext::TransitionLayout(const Texture* generalTexture, VkPipelineSt
 
     vkCmdPipelineBarrier(m_CommandBuffer, srcStage, stage, VK_DEPENDENCY_BY_REGION_BIT,
         0, nullptr, 0, nullptr, 1, &barrier);
+    ++m_Stats.pipelineBarriers;
+    ++m_Stats.imageBarriers;
 }
 
 void VulkanContext::RestoreLayout(const Texture* texture, VkPipelineStageFlags stage,
-    VkAccessFlags access, VkImageLayout layout, uint32 layer, uint32 level) const
+    VkAccessFlags access, VkImageLayout layout, uint32 layer, uint32 level)
 {
     auto tex = Get(texture);
 
@@ -791,6 +1377,367 @@ void VulkanContext::RestoreLayout(const Texture* texture, VkPipelineStageFlags s
 
     vkCmdPipelineBarrier(m_CommandBuffer, stage, dstStage, VK_DEPENDENCY_BY_REGION_BIT,
         0, nullptr, 0, nullptr, 1, &barrier);
+    ++m_Stats.pipelineBarriers;
+    ++m_Stats.imageBarriers;
+}
+
+bool VulkanContext::UpdateSyncState(VulkanSyncState& sync, VkPipelineStageFlags stage, VkAccessFlags access,
+    VkImageLayout layout, SyncOp op, VkPipelineStageFlags& srcStages, VkAccessFlags& srcAccess)
+{
+    bool layoutChange = sync.layout != layout;
+    bool reads = access & ~kWriteAccess;
+    bool writes = access & kWriteAccess;
+
+    // Reads wait once per stage and access type for the last write to become visible, writes only need to be ordered
+    // after it and after any reads made since
+    bool ordered = sync.writeStages == 0 || (stage & ~sync.visibleStages) == 0;
+    bool visible = ordered && (sync.writeStages == 0 || (access & ~sync.visibleAccess) == 0);
+    bool hazard = reads ? !visible : !ordered;
+    bool writeHazard = writes && (sync.writeAccess || sync.readStages);
+
+    bool barrier = layoutChange || hazard || writeHazard;
+    if (barrier)
+    {
+        // Layout transitions write the image, so they must also wait for earlier reads to finish
+        srcStages = sync.writeStages | ((layoutChange || writes) ? sync.readStages : 0);
+        srcAccess = sync.writeAccess;
+
+        if (layoutChange || writes)
+        {
+            // Every earlier access is complete once the barrier's destination stages begin
+            sync = VulkanSyncState{
+                .layout = layout,
+                .writeStages = stage,
+                .visibleStages = stage,
+                .visibleAccess = access
+            };
+        }
+        else
+        {
+            sync.writeAccess = 0;
+            sync.visibleStages |= stage;
+            sync.visibleAccess |= access;
+        }
+    }
+
+    switch (op)
+    {
+    case SyncOp::kRead:
+        sync.readStages |= stage;
+        break;
+
+    case SyncOp::kWrite:
+        sync = VulkanSyncState{ .layout = layout, .writeStages = stage, .writeAccess = access & kWriteAccess };
+        break;
+
+    case SyncOp::kPrepare:
+        break;
+    }
+    return barrier;
+}
+
+void VulkanContext::AccessTexture(const VulkanTexture* texture, VkPipelineStageFlags stage, VkAccessFlags access,
+    VkImageLayout layout, bool write)
+{
+    AddImageBarrier(texture, stage, access, layout, write ? SyncOp::kWrite : SyncOp::kRead);
+}
+
+void VulkanContext::PrepareTexture(const VulkanTexture* texture, VkPipelineStageFlags stage, VkAccessFlags access,
+    VkImageLayout layout)
+{
+    AddImageBarrier(texture, stage, access, layout, SyncOp::kPrepare);
+}
+
+void VulkanContext::AddImageBarrier(const VulkanTexture* texture, VkPipelineStageFlags stage, VkAccessFlags access,
+    VkImageLayout layout, SyncOp op)
+{
+    auto oldLayout = texture->sync.layout;
+
+    VkPipelineStageFlags srcStages = 0;
+    VkAccessFlags srcAccess = 0;
+    if (!UpdateSyncState(texture->sync, stage, access, layout, op, srcStages, srcAccess))
+        return;
+
+    // A texture may only appear once in a batch, as barriers within a batch are not ordered against each other
+    auto pending = std::find_if(m_ImageBarriers.begin(), m_ImageBarriers.end(), [&](auto& barrier)
+    { return barrier.image == texture->image; });
+    if (pending != m_ImageBarriers.end())
+        FlushBarriers();
+
+    m_BarrierSrcStages |= srcStages ? srcStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    m_BarrierDstStages |= stage;
+    m_ImageBarriers.push_back(VkImageMemoryBarrier{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = srcAccess,
+        .dstAccessMask = access,
+        .oldLayout = oldLayout,
+        .newLayout = layout,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = texture->image,
+        .subresourceRange = {
+            .aspectMask = texture->aspect,
+            .baseMipLevel = 0,
+            .levelCount = VK_REMAINING_MIP_LEVELS,
+            .baseArrayLayer = 0,
+            .layerCount = VK_REMAINING_ARRAY_LAYERS
+        }
+    });
+}
+
+void VulkanContext::AccessBuffer(const VulkanBuffer* buffer, VkPipelineStageFlags stage, VkAccessFlags access,
+    bool write)
+{
+    AddBufferBarrier(buffer, stage, access, write ? SyncOp::kWrite : SyncOp::kRead);
+}
+
+void VulkanContext::PrepareBuffer(const VulkanBuffer* buffer, VkPipelineStageFlags stage, VkAccessFlags access)
+{
+    AddBufferBarrier(buffer, stage, access, SyncOp::kPrepare);
+}
+
+void VulkanContext::AddBufferBarrier(const VulkanBuffer* buffer, VkPipelineStageFlags stage, VkAccessFlags access,
+    SyncOp op)
+{
+    VkPipelineStageFlags srcStages = 0;
+    VkAccessFlags srcAccess = 0;
+    if (!UpdateSyncState(buffer->sync, stage, access, VK_IMAGE_LAYOUT_UNDEFINED, op, srcStages, srcAccess))
+        return;
+
+    auto pending = std::find_if(m_BufferBarriers.begin(), m_BufferBarriers.end(), [&](auto& barrier)
+    { return barrier.buffer == buffer->handle; });
+    if (pending != m_BufferBarriers.end())
+        FlushBarriers();
+
+    m_BarrierSrcStages |= srcStages ? srcStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    m_BarrierDstStages |= stage;
+    m_BufferBarriers.push_back(VkBufferMemoryBarrier{
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .srcAccessMask = srcAccess,
+        .dstAccessMask = access,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer = buffer->handle,
+        .offset = 0,
+        .size = VK_WHOLE_SIZE
+    });
+}
+
+void VulkanContext::AccessBoundResources(VkPipelineStageFlags stage)
+{
+    LC_ASSERT(m_BoundPipeline);
+
+    struct TextureAccess
+    {
+        const VulkanTexture* texture;
+        VkAccessFlags access;
+        VkImageLayout layout;
+    };
+    Array <TextureAccess, VulkanShader::kMaxSets * VulkanShader::kMaxBindingsPerSet> textures;
+    struct BufferAccess
+    {
+        const VulkanBuffer* buffer;
+        bool write;
+    };
+    Array <BufferAccess, VulkanShader::kMaxSets * VulkanShader::kMaxBindingsPerSet> buffers;
+
+    // Merge every binding of a texture so it needs at most one barrier, ignoring sets the pipeline doesn't use
+    auto addTexture = [&](const VulkanTexture* texture, VkAccessFlags access, VkImageLayout layout)
+    {
+        auto it = std::find_if(textures.begin(), textures.end(), [&](auto& entry)
+        { return entry.texture == texture; });
+
+        if (it == textures.end())
+            textures.push_back({ texture, access, layout });
+        else
+            it->access |= access;
+    };
+
+    auto& shader = *m_BoundPipeline->shader;
+    auto numSets = shader.setLayouts.size();
+    for (int setIndex = 0; setIndex < numSets; ++setIndex)
+    {
+        auto& resources = m_BoundResources[setIndex];
+
+        for (auto texture: resources.textures)
+        {
+            addTexture(texture, VK_ACCESS_SHADER_READ_BIT,
+                texture->GetSettings().usage == TextureUsage::kReadWrite ?
+                VK_IMAGE_LAYOUT_GENERAL :
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        }
+        for (auto texture: resources.images)
+            addTexture(texture, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL);
+
+        // Buffers are only written through bindings the shader doesn't declare readonly
+        for (auto& bound: resources.storageBuffers)
+        {
+            bool write = (shader.writableBuffers[setIndex] >> bound.binding) & 1;
+
+            auto it = std::find_if(buffers.begin(), buffers.end(), [&](auto& entry)
+            { return entry.buffer == bound.buffer; });
+
+            if (it == buffers.end())
+                buffers.push_back({ bound.buffer, write });
+            else
+                it->write |= write;
+        }
+    }
+
+    if (m_BoundFramebuffer)
+    {
+        // Barriers can't be recorded inside a render pass, so resources must already have been transitioned for
+        // sampling by the frame graph. Only record the accesses for later commands to synchronize against.
+        for (auto& entry: textures)
+        {
+            RecordPassAccess(PassAccess{
+                .texture = entry.texture,
+                .stage = stage,
+                .write = (entry.access & VK_ACCESS_SHADER_WRITE_BIT) != 0
+            });
+        }
+        for (auto& entry: buffers)
+            RecordPassAccess(PassAccess{ .buffer = entry.buffer, .stage = stage, .write = entry.write });
+
+        return;
+    }
+
+    // Storage images are assumed to be both read and written
+    for (auto& entry: textures)
+        AccessTexture(entry.texture, stage, entry.access, entry.layout, entry.access & VK_ACCESS_SHADER_WRITE_BIT);
+
+    for (auto& entry: buffers)
+    {
+        VkAccessFlags access = VK_ACCESS_SHADER_READ_BIT;
+        if (entry.write)
+            access |= VK_ACCESS_SHADER_WRITE_BIT;
+        AccessBuffer(entry.buffer, stage, access, entry.write);
+    }
+}
+
+void VulkanContext::RecordPassAccess(const PassAccess& access)
+{
+    if (m_Level == VK_COMMAND_BUFFER_LEVEL_SECONDARY)
+        m_PassAccesses.push_back(access);
+    else
+        ApplyPassAccess(access);
+}
+
+void VulkanContext::ApplyPassAccess(const PassAccess& access)
+{
+    if (access.texture)
+    {
+        auto& sync = access.texture->sync;
+        if (access.write)
+        {
+            sync = VulkanSyncState{
+                .layout = sync.layout,
+                .writeStages = access.stage,
+                .writeAccess = VK_ACCESS_SHADER_WRITE_BIT
+            };
+        }
+        else
+        {
+            sync.readStages |= access.stage;
+        }
+    }
+    if (access.buffer)
+    {
+        auto& sync = access.buffer->sync;
+        if (access.write)
+            sync = VulkanSyncState{ .writeStages = access.stage, .writeAccess = VK_ACCESS_SHADER_WRITE_BIT };
+        else
+            sync.readStages |= access.stage;
+    }
+}
+
+void VulkanContext::DiscardTexture(const VulkanTexture* texture)
+{
+    auto pending = std::find_if(m_ImageBarriers.begin(), m_ImageBarriers.end(), [&](auto& barrier)
+    { return barrier.image == texture->image; });
+    if (pending != m_ImageBarriers.end())
+        FlushBarriers();
+
+    VkPipelineStageFlags dstStage{};
+    VkAccessFlags dstAccess{};
+    VkImageLayout dstLayout{};
+    texture->SyncDst(dstStage, dstAccess, dstLayout);
+
+    // Previous work may have written the same memory through an aliased texture, so wait on all of it
+    m_BarrierSrcStages |= VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    m_BarrierDstStages |= dstStage;
+    m_ImageBarriers.push_back(VkImageMemoryBarrier{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT,
+        .dstAccessMask = dstAccess,
+        .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .newLayout = dstLayout,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = texture->image,
+        .subresourceRange = {
+            .aspectMask = texture->aspect,
+            .baseMipLevel = 0,
+            .levelCount = VK_REMAINING_MIP_LEVELS,
+            .baseArrayLayer = 0,
+            .layerCount = VK_REMAINING_ARRAY_LAYERS
+        }
+    });
+
+    texture->sync = VulkanSyncState{
+        .layout = dstLayout,
+        .writeStages = dstStage,
+        .visibleStages = dstStage,
+        .visibleAccess = dstAccess
+    };
+}
+
+void VulkanContext::FlushBarriers()
+{
+    if (m_ImageBarriers.empty() && m_BufferBarriers.empty())
+        return;
+
+    vkCmdPipelineBarrier(m_CommandBuffer, m_BarrierSrcStages, m_BarrierDstStages, 0,
+        0, nullptr,
+        m_BufferBarriers.size(), m_BufferBarriers.data(),
+        m_ImageBarriers.size(), m_ImageBarriers.data());
+
+    ++m_Stats.pipelineBarriers;
+    m_Stats.imageBarriers += m_ImageBarriers.size();
+    m_Stats.bufferBarriers += m_BufferBarriers.size();
+
+    m_BarrierSrcStages = 0;
+    m_BarrierDstStages = 0;
+    m_ImageBarriers.clear();
+    m_BufferBarriers.clear();
+}
+
+void VulkanContext::BeginSubresourceAccess(const VulkanTexture* texture)
+{
+    VkPipelineStageFlags stage{};
+    VkAccessFlags access{};
+    VkImageLayout layout{};
+    texture->SyncSrc(stage, access, layout);
+
+    // TransitionLayout synchronizes with all uses of the starting layout, so only other layouts need a barrier
+    if (texture->sync.layout != layout)
+        PrepareTexture(texture, stage, access, layout);
+}
+
+void VulkanContext::EndSubresourceAccess(const VulkanTexture* texture)
+{
+    VkPipelineStageFlags stage{};
+    VkAccessFlags access{};
+    VkImageLayout layout{};
+    texture->SyncDst(stage, access, layout);
+
+    // RestoreLayout has made the copy visible to every use of the starting layout
+    texture->sync = VulkanSyncState{
+        .layout = texture->GetStartingLayout(),
+        .writeStages = stage,
+        .visibleStages = stage,
+        .visibleAccess = access
+    };
 }
 
 Device* VulkanContext::GetDevice()
@@ -11,7 +11,7 @@ namespace lucent
 class VulkanContext : public Context
 {
 public:
-    explicit VulkanContext(VulkanDevice& device);
+    explicit VulkanContext(VulkanDevice& device, VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
     ~VulkanContext();
 
     VulkanContext(const Context&) = delete;
@@ -23,6 +23,13 @@ public:
     void BeginRenderPass(const Framebuffer* framebuffer) override;
     void EndRenderPass() override;
 
+    using Context::RecordParallel;
+    void RecordParallel(const std::vector<const Framebuffer*>& renderPasses, uint32 tasksPerPass,
+        const RecordTask& record) override;
+    uint32 GetNumRecordingThreads() override;
+
+    const ContextStats& GetStats() override;
+
     void Clear(Color color, float depth) override;
     void Viewport(uint32 width, uint32 height) override;
 
@@ -37,7 +44,12 @@ public:
     void Uniform(Descriptor* descriptor, const uint8* data, size_t size) override;
     void Uniform(Descriptor* descriptor, uint32 arrayIndex, const uint8* data, size_t size) override;
 
-    void Draw(uint32 indexCount) override;
+    void Draw(uint32 indexCount, uint32 firstIndex, int32 vertexOffset) override;
+    void DrawInstanced(uint32 indexCount, uint32 instanceCount, uint32 firstInstance, uint32 firstIndex,
+        int32 vertexOffset) override;
+    void DrawIndirect(const Buffer* commands, uint32 offset, uint32 drawCount) override;
+    void DrawIndirectCount(const Buffer* commands, uint32 offset, const Buffer* count, uint32 countOffset,
+        uint32 maxDrawCount) override;
 
     void Dispatch(uint32 x, uint32 y, uint32 z) override;
 
@@ -62,8 +74,15 @@ public:
 
     void GenerateMips(Texture* texture) override;
 
+    void Transition(const ResourceTransitions& transitions) override;
+
     const Pipeline* BoundPipeline() override;
 
+    void BeginRegion(const char* label) override;
+    void EndRegion() override;
+    const std::vector<RegionTiming>& GetRegionTimings() override;
+    void EnablePipelineStatistics(bool enable) override;
+
     Device* GetDevice() override;
 
 private:
@@ -101,9 +120,26 @@ private:
         bool dirty = false;
     };
 
-    struct BindingHash
+    struct DescriptorSetKey
     {
-        size_t operator()(const BindingArray& bindings) const;
+        BindingArray bindings;
+        VkDescriptorSetLayout layout;
+
+        bool operator==(const DescriptorSetKey& rhs) const = default;
+    };
+
+    struct DescriptorSetKeyHash
+    {
+        size_t operator()(const DescriptorSetKey& key) const;
+    };
+
+    // Descriptor sets persist between frames until evicted or a resource they reference is destroyed
+    struct CachedDescriptorSet
+    {
+        VkDescriptorSet handle;
+        VkDescriptorPool pool;
+        uint64 lastUsedFrame;
+        std::list<DescriptorSetKey>::iterator lru;
     };
 
     struct ScratchAllocation
@@ -112,27 +148,115 @@ private:
         uint32 binding;
         uint32 offset;
         uint32 size;
+        uint8* data;
     };
 
     friend class VulkanDevice;
 
+    enum class SyncOp
+    {
+        kRead,
+        kWrite,
+        kPrepare // Barrier only, for accesses made later by commands which can't record barriers themselves
+    };
+
+    struct BoundBuffer
+    {
+        const VulkanBuffer* buffer;
+        uint32 binding;
+    };
+
+    // Resources referenced by the descriptor set bound to a set index
+    struct BoundResources
+    {
+        std::vector<const VulkanTexture*> textures;
+        std::vector<const VulkanTexture*> images;
+        std::vector<BoundBuffer> storageBuffers;
+    };
+
+    // Shader access made inside a render pass, which only updates the synchronization state of the resource
+    struct PassAccess
+    {
+        const VulkanTexture* texture;
+        const VulkanBuffer* buffer;
+        VkPipelineStageFlags stage;
+        bool write;
+    };
+
+    // Region whose start and end timestamps are written to the query pool, if it had space
+    struct TimedRegion
+    {
+        const char* label;
+        uint32 depth;
+        uint32 startQuery;
+        uint32 endQuery;
+        uint32 statisticsQuery;
+        // Ended early as commands recorded in parallel within it couldn't be counted
+        bool statisticsSkipped = false;
+    };
+
 private:
     VkDescriptorSet FindDescriptorSet(const BindingArray& bindings, VkDescriptorSetLayout layout);
+    VkDescriptorSet AllocateDescriptorSet(VkDescriptorSetLayout layout, VkDescriptorPool& pool);
+    void EvictDescriptorSets();
+    void FreeStaleDescriptorSets();
+
+    // Called by the device before a texture or buffer referenced by cached descriptor sets is destroyed
+    void InvalidateDescriptorSets(const void* resource);
     VkDescriptorPool AllocateDescriptorPool() const;
     void BindDescriptorSets();
 
-    uint32 GetUniformBufferOffset(uint32 arg, uint32 binding);
+    void ResetRecordingState();
+
+    // Converts the timestamps of the last frame, whose fence must be signaled, before the queries are reused
+    void ReadRegionTimings();
+    void BeginRenderPass(const VulkanFramebuffer& framebuffer, VkSubpassContents contents);
+
+    // Begins a secondary command buffer continuing the render pass of the framebuffer, within a pipeline statistics
+    // query collecting the given statistics
+    void BeginSecondary(const VulkanFramebuffer& framebuffer, VkQueryPipelineStatisticFlags inheritedStatistics);
+    VulkanContext& NextSecondary();
+
+    // Returns the mapped memory of the scratch allocation for a uniform block, allocating it on first use in a draw
+    uint8* GetUniformBlock(uint32 set, uint32 binding);
     Buffer* AllocateUniformBuffer();
     void ResetScratchAllocations();
     void ResetUniformBuffers();
+    // Makes uniform writes visible to the device, once per scratch buffer when recording ends
+    void FlushUniformBuffers();
 
     void BindBuffer(uint32 set, uint32 binding, const Buffer* buffer, uint32 dynamicOffset);
 
     void TransitionLayout(const Texture* generalTexture, VkPipelineStageFlags stage, VkAccessFlags access,
-        VkImageLayout layout, uint32 layer = ~0u, uint32 level = ~0u) const;
+        VkImageLayout layout, uint32 layer = ~0u, uint32 level = ~0u);
 
     void RestoreLayout(const Texture* texture, VkPipelineStageFlags stage, VkAccessFlags access,
-        VkImageLayout layout, uint32 layer = ~0u, uint32 level = ~0u) const;
+        VkImageLayout layout, uint32 layer = ~0u, uint32 level = ~0u);
+
+    // Tracked synchronization, barriers are batched until FlushBarriers is called
+    void AccessTexture(const VulkanTexture* texture, VkPipelineStageFlags stage, VkAccessFlags access,
+        VkImageLayout layout, bool write);
+    void PrepareTexture(const VulkanTexture* texture, VkPipelineStageFlags stage, VkAccessFlags access,
+        VkImageLayout layout);
+    void AccessBuffer(const VulkanBuffer* buffer, VkPipelineStageFlags stage, VkAccessFlags access, bool write);
+    void PrepareBuffer(const VulkanBuffer* buffer, VkPipelineStageFlags stage, VkAccessFlags access);
+    void AccessBoundResources(VkPipelineStageFlags stage);
+    void RecordPassAccess(const PassAccess& access);
+    static void ApplyPassAccess(const PassAccess& access);
+    void DiscardTexture(const VulkanTexture* texture);
+    void FlushBarriers();
+
+    void AddImageBarrier(const VulkanTexture* texture, VkPipelineStageFlags stage, VkAccessFlags access,
+        VkImageLayout layout, SyncOp op);
+    void AddBufferBarrier(const VulkanBuffer* buffer, VkPipelineStageFlags stage, VkAccessFlags access, SyncOp op);
+
+    // Advances the synchronization state of a resource past an access, returns true if a barrier must come first
+    static bool UpdateSyncState(VulkanSyncState& sync, VkPipelineStageFlags stage, VkAccessFlags access,
+        VkImageLayout layout, SyncOp op, VkPipelineStageFlags& srcStages, VkAccessFlags& srcAccess);
+
+    // Subresource copies transition from and back to the starting layout of a texture
+    void BeginSubresourceAccess(const VulkanTexture* texture);
+    void EndSubresourceAccess(const VulkanTexture* texture);
 
 public:
     VulkanDevice& m_Device;
@@ -140,15 +264,51 @@ public:
     VkCommandPool m_CommandPool{};
     VkCommandBuffer m_CommandBuffer{};
     VkFence m_ReadyFence{};
+    VkCommandBufferLevel m_Level;
+
+    // Secondary contexts recorded by worker threads, each is used at most once per frame
+    std::vector<std::unique_ptr<VulkanContext>> m_Secondaries;
+    uint32 m_NumSecondariesUsed = 0;
+
+    // Accesses made by a secondary context, applied by its primary once recording has finished so that worker threads
+    // never modify shared resource state
+    std::vector<PassAccess> m_PassAccesses;
+
+    // Descriptor set cache, least recently used sets are evicted once it is full
+    static constexpr auto kMaxCachedDescriptorSets = 2048;
 
     Pool<VkDescriptorPool> m_DescriptorPools;
-    std::unordered_map<BindingArray, VkDescriptorSet, BindingHash> m_DescriptorSets;
+    std::unordered_map<DescriptorSetKey, CachedDescriptorSet, DescriptorSetKeyHash> m_DescriptorSets;
+    std::list<DescriptorSetKey> m_DescriptorSetLru;
+    // Invalidated sets which may still be referenced by commands in flight, freed at the start of the next frame
+    std::vector<std::pair<VkDescriptorSet, VkDescriptorPool>> m_StaleDescriptorSets;
+    uint64 m_FrameIndex = 0;
+
+    ContextStats m_Stats;
+
+    // Timestamp queries written by primary contexts at the start and end of each region
+    static constexpr uint32 kMaxTimestamps = 256;
+
+    VkQueryPool m_TimestampPool{};
+    uint32 m_NumTimestamps = 0;
+
+    // Pipeline statistics queries of top level regions, which can't nest
+    static constexpr uint32 kMaxStatisticsQueries = 64;
+
+    VkQueryPool m_StatisticsPool{};
+    uint32 m_NumStatisticsQueries = 0;
+    bool m_StatisticsEnabled = false;
+    bool m_StatisticsQueryActive = false;
+    std::vector<TimedRegion> m_Regions;
+    std::vector<uint32> m_OpenRegions;
+    std::vector<RegionTiming> m_RegionTimings;
 
     // Scratch uniform allocations
     static constexpr auto kMaxScratchAllocations = 8;
     static constexpr auto kScratchBufferSize = 65536;
 
     Pool<Buffer*> m_ScratchUniformBuffers;
+    std::vector<uint32> m_ScratchBytesUsed; // Bytes written to each active scratch buffer, in allocation order
     uint32 m_ScratchDrawOffset = 0;
     Array <ScratchAllocation, kMaxScratchAllocations> m_ScratchAllocations{};
 
@@ -156,6 +316,14 @@ public:
     const VulkanPipeline* m_BoundPipeline{};
     const VulkanFramebuffer* m_BoundFramebuffer{};
     std::array<BoundSet, VulkanShader::kMaxSets> m_BoundSets{};
+
+    std::array<BoundResources, VulkanShader::kMaxSets> m_BoundResources;
+
+    // Pending barrier batch
+    VkPipelineStageFlags m_BarrierSrcStages = 0;
+    VkPipelineStageFlags m_BarrierDstStages = 0;
+    std::vector<VkImageMemoryBarrier> m_ImageBarriers;
+    std::vector<VkBufferMemoryBarrier> m_BufferBarriers;
 };
 
 }
@@ -9,19 +9,51 @@
 #include "device/vulkan/VulkanPipeline.hpp"
 #include "device/vulkan/VulkanContext.hpp"
 #include "device/vulkan/VulkanFramebuffer.hpp"
+#include "device/vulkan/VulkanUploader.hpp"
 #include "device/vulkan/ShaderCache.hpp"
+#include "core/Utility.hpp"
+
+#include <cstring>
 
 namespace lucent
 {
 
-VulkanDevice::VulkanDevice(GLFWwindow* window)
+// Shared by all static meshes, enough for a couple of million vertices of the standard mesh format
+static constexpr uint32 kGeometryArenaVertexBytes = 128 * 1024 * 1024;
+static constexpr uint32 kGeometryArenaMaxIndices = 8 * 1024 * 1024;
+
+// Staging memory reused by uploads once the batches reading it complete, larger uploads get a buffer of their own
+static constexpr VkDeviceSize kUploadStagingSize = 128 * 1024 * 1024;
+
+// Header prepended to serialized pipeline cache data to validate it against the current device
+struct PipelineCacheHeader
+{
+    static constexpr uint32 kMagic = 0x4350434c; // "LCPC"
+
+    uint32 magic;
+    uint32 vendorID;
+    uint32 deviceID;
+    uint32 driverVersion;
+    uint8 pipelineCacheUUID[VK_UUID_SIZE];
+    uint64 dataSize;
+};
+
+static std::string GetPipelineCachePath()
+{
+    return GetCacheDirectory() + "pipelines.bin";
+}
+
+VulkanDevice::VulkanDevice(GLFWwindow* window, const SwapchainSettings& swapchainSettings)
     : m_Window(window)
+    , m_SwapchainSettings(swapchainSettings)
 {
     glslang::InitializeProcess();
 
     CreateInstance();
-    glfwCreateWindowSurface(m_Instance, m_Window, nullptr, &m_Surface);
+    if (!IsHeadless())
+        glfwCreateWindowSurface(m_Instance, m_Window, nullptr, &m_Surface);
     CreateDevice();
+    CreateBindlessTable();
 
     // Initialize VMA
     auto allocatorInfo = VmaAllocatorCreateInfo{
@@ -32,29 +64,58 @@ VulkanDevice::VulkanDevice(GLFWwindow* window)
     };
     vmaCreateAllocator(&allocatorInfo, &m_Allocator);
 
-    // Create transfer buffer
-    m_TransferBuffer = VulkanDevice::CreateBuffer(BufferType::kStaging, 128 * 1024 * 1024);
-    m_OneShotContext = Get(VulkanDevice::CreateContext());
+    LoadPipelineCache();
 
-    // Create shader cache
+    // Textures record their initial layout transitions with the uploader, so it must exist before any are created
+    m_Uploader = std::make_unique<VulkanUploader>(*this, kUploadStagingSize);
+    m_GeometryArena = std::make_unique<GeometryArena>(this, kGeometryArenaVertexBytes, kGeometryArenaMaxIndices);
+
+    // Create shader cache, compiling on a pool of worker threads
+    // glslang::InitializeProcess above must complete before any worker parses a shader
+    m_Workers = std::make_unique<ThreadPool>();
     m_ShaderCache = std::make_unique<ShaderCache>(this);
 
-    m_Swapchain = std::make_unique<VulkanSwapchain>(this);
+    if (!IsHeadless())
+        m_Swapchain = std::make_unique<VulkanSwapchain>(this, m_SwapchainSettings);
 }
 
 VulkanDevice::~VulkanDevice()
 {
+    WaitForPipelines();
     vkDeviceWaitIdle(m_Handle);
 
+    // Nothing is in flight, so releases waiting on a submission can run too
+    RunCompletedReleases();
+    RunPendingReleases();
+
+    for (auto fence: m_FreeReleaseFences)
+        vkDestroyFence(m_Handle, fence, nullptr);
+
     m_Contexts.clear();
+    m_Uploader.reset();
     m_Pipelines.clear();
     m_Framebuffers.clear();
+
+    for (auto&[layout, renderPass]: m_RenderPasses)
+        vkDestroyRenderPass(m_Handle, renderPass, nullptr);
+
+    // The objects above destroy their resources through deferred releases, which can run straight away
+    RunPendingReleases();
+
     m_Textures.clear();
+    m_GeometryArena.reset();
+    RunPendingReleases();
     m_Buffers.clear();
     m_ShaderCache->Clear();
 
+    vkDestroyDescriptorPool(m_Handle, m_BindlessPool, nullptr);
+    vkDestroyDescriptorSetLayout(m_Handle, m_BindlessLayout, nullptr);
+
     m_Swapchain.reset();
 
+    SavePipelineCache();
+    vkDestroyPipelineCache(m_Handle, m_PipelineCache, nullptr);
+
     // VMA
     vmaDestroyAllocator(m_Allocator);
 
@@ -69,29 +130,84 @@ VulkanDevice::~VulkanDevice()
 
     vkDestroyInstance(m_Instance, nullptr);
 
+    // Join workers before tearing down glslang's process-wide state
+    m_Workers.reset();
     glslang::FinalizeProcess();
 
     glfwTerminate();
 }
 
+bool VulkanDevice::HasHeadlessDevice()
+{
+    auto appInfo = VkApplicationInfo{
+        .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
+        .apiVersion = VK_API_VERSION_1_2
+    };
+    auto createInfo = VkInstanceCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+        .pApplicationInfo = &appInfo
+    };
+
+    // Fails without a driver, e.g. when only the loader is installed
+    VkInstance instance;
+    if (vkCreateInstance(&createInfo, nullptr, &instance) != VK_SUCCESS)
+        return false;
+
+    uint32 deviceCount = 0;
+    vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
+    std::vector<VkPhysicalDevice> physicalDevices(deviceCount);
+    vkEnumeratePhysicalDevices(instance, &deviceCount, physicalDevices.data());
+
+    bool found = false;
+    for (auto device: physicalDevices)
+    {
+        uint32 queueFamilyCount;
+        vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> familyProperties(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, familyProperties.data());
+
+        found |= std::any_of(familyProperties.begin(), familyProperties.end(), [](auto& family)
+        { return (family.queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0; });
+    }
+
+    vkDestroyInstance(instance, nullptr);
+    return found;
+}
+
 void VulkanDevice::CreateInstance()
 {
     std::vector<const char*> instanceExtensions = {
         VK_EXT_DEBUG_UTILS_EXTENSION_NAME
     };
 
-    uint32 glfwExtCount;
-    const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtCount);
-    instanceExtensions.insert(instanceExtensions.end(), glfwExtensions, glfwExtensions + glfwExtCount);
+    if (!IsHeadless())
+    {
+        uint32 glfwExtCount;
+        const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtCount);
+        instanceExtensions.insert(instanceExtensions.end(), glfwExtensions, glfwExtensions + glfwExtCount);
+    }
 
-    std::vector<const char*> validationLayers = {
-        "VK_LAYER_KHRONOS_validation"
-    };
+    // Validation is enabled where installed, machines running headless often only have the loader and a driver
+    uint32 layerCount;
+    std::vector<VkLayerProperties> availableLayers;
+    vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
+    availableLayers.resize(layerCount);
+    vkEnumerateInstanceLayerProperties(&layerCount, availableLayers.data());
+
+    std::vector<const char*> validationLayers;
+    for (auto& layer: availableLayers)
+    {
+        if (strcmp(layer.layerName, "VK_LAYER_KHRONOS_validation") == 0)
+            validationLayers.push_back("VK_LAYER_KHRONOS_validation");
+    }
+    if (validationLayers.empty())
+        LC_WARN("Validation layer not found, running without validation");
 
     auto appInfo = VkApplicationInfo{
         .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
         .pApplicationName = "Lucent Demo",
-        .pEngineName = "Lucent Engine"
+        .pEngineName = "Lucent Engine",
+        .apiVersion = VK_API_VERSION_1_2
     };
 
     auto createInfo = VkInstanceCreateInfo{
@@ -126,6 +242,11 @@ void VulkanDevice::CreateInstance()
     {
         LC_CHECK(createMessenger(m_Instance, &debugMessengerInfo, nullptr, &m_DebugMessenger));
     }
+
+    m_CmdBeginDebugLabel = (PFN_vkCmdBeginDebugUtilsLabelEXT)vkGetInstanceProcAddr(
+        m_Instance, "vkCmdBeginDebugUtilsLabelEXT");
+    m_CmdEndDebugLabel = (PFN_vkCmdEndDebugUtilsLabelEXT)vkGetInstanceProcAddr(
+        m_Instance, "vkCmdEndDebugUtilsLabelEXT");
 }
 
 void VulkanDevice::CreateDevice()
@@ -137,55 +258,108 @@ void VulkanDevice::CreateDevice()
     physicalDevices.resize(deviceCount);
     vkEnumeratePhysicalDevices(m_Instance, &deviceCount, physicalDevices.data());
 
-    VkPhysicalDevice selectedDevice;
+    // Find queue families for graphics and present, headless devices present from the graphics queue
+    auto findQueueFamilies = [this](VkPhysicalDevice device, std::vector<VkQueueFamilyProperties>& familyProperties,
+        uint32& graphicsFamilyIdx, uint32& presentFamilyIdx)
+    {
+        uint32 queueFamilyCount;
+        vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
+        familyProperties.resize(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, familyProperties.data());
+
+        graphicsFamilyIdx = -1;
+        presentFamilyIdx = -1;
+        for (int i = 0; i < familyProperties.size(); ++i)
+        {
+            const auto& family = familyProperties[i];
+
+            VkBool32 graphics = family.queueFlags & VK_QUEUE_GRAPHICS_BIT;
+            VkBool32 present = VK_FALSE;
+            if (IsHeadless())
+                present = graphics;
+            else
+                vkGetPhysicalDeviceSurfaceSupportKHR(device, i, m_Surface, &present);
+
+            if (graphics && present)
+            {
+                graphicsFamilyIdx = presentFamilyIdx = i;
+                break;
+            }
+            else if (graphics)
+            {
+                graphicsFamilyIdx = i;
+            }
+            else if (present)
+            {
+                presentFamilyIdx = i;
+            }
+        }
+        return graphicsFamilyIdx != -1 && presentFamilyIdx != -1;
+    };
+
+    // Prefer discrete GPUs, but accept any device able to render, including CPU implementations such as lavapipe
+    auto rankDeviceType = [](VkPhysicalDeviceType type)
+    {
+        switch (type)
+        {
+        case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+            return 4;
+        case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+            return 3;
+        case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+            return 2;
+        case VK_PHYSICAL_DEVICE_TYPE_CPU:
+            return 1;
+        default:
+            return 0;
+        }
+    };
+
+    VkPhysicalDevice selectedDevice{};
+    int selectedRank = -1;
+    std::vector<VkQueueFamilyProperties> familyProperties;
+    uint32 graphicsFamilyIdx;
+    uint32 presentFamilyIdx;
     for (auto& device: physicalDevices)
     {
-        vkGetPhysicalDeviceProperties(device, &m_DeviceProperties);
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(device, &properties);
 
-        if (m_DeviceProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
+        auto rank = rankDeviceType(properties.deviceType);
+        if (rank > selectedRank && findQueueFamilies(device, familyProperties, graphicsFamilyIdx, presentFamilyIdx))
         {
             selectedDevice = device;
-            break;
+            selectedRank = rank;
+            m_DeviceProperties = properties;
         }
     }
 
     LC_ASSERT(selectedDevice != nullptr);
     m_PhysicalDevice = selectedDevice;
+    findQueueFamilies(selectedDevice, familyProperties, graphicsFamilyIdx, presentFamilyIdx);
 
-    // Find queue families for graphics and present
-    uint32 queueFamilyCount;
-    std::vector<VkQueueFamilyProperties> familyProperties;
-    vkGetPhysicalDeviceQueueFamilyProperties(selectedDevice, &queueFamilyCount, nullptr);
-    familyProperties.resize(queueFamilyCount);
-    vkGetPhysicalDeviceQueueFamilyProperties(selectedDevice, &queueFamilyCount, familyProperties.data());
+    LC_INFO("Using device {}{}", m_DeviceProperties.deviceName, IsHeadless() ? " (headless)" : "");
+
+    m_TimestampsSupported = familyProperties[graphicsFamilyIdx].timestampValidBits > 0;
+    if (!m_TimestampsSupported)
+        LC_INFO("Timestamps not supported, GPU pass timings disabled");
 
-    uint32 graphicsFamilyIdx = -1;
-    uint32 presentFamilyIdx = -1;
+    // Prefer a family without graphics or compute, usually a copy engine which can run alongside rendering
+    uint32 transferFamilyIdx = -1;
     for (int i = 0; i < familyProperties.size(); ++i)
     {
-        const auto& family = familyProperties[i];
+        auto flags = familyProperties[i].queueFlags;
+        if (!(flags & VK_QUEUE_TRANSFER_BIT) || (flags & VK_QUEUE_GRAPHICS_BIT))
+            continue;
 
-        VkBool32 graphics = family.queueFlags & VK_QUEUE_GRAPHICS_BIT;
-        VkBool32 present;
-        vkGetPhysicalDeviceSurfaceSupportKHR(selectedDevice, i, m_Surface, &present);
-
-        if (graphics && present)
-        {
-            graphicsFamilyIdx = presentFamilyIdx = i;
-            break;
-        }
-        else if (graphics)
-        {
-            graphicsFamilyIdx = i;
-        }
-        else if (present)
-        {
-            presentFamilyIdx = i;
-        }
+        if (transferFamilyIdx == -1 || !(flags & VK_QUEUE_COMPUTE_BIT))
+            transferFamilyIdx = i;
     }
 
     float queuePriority = 1.0f;
     std::set<uint32> familyIndices = { graphicsFamilyIdx, presentFamilyIdx };
+    if (transferFamilyIdx != -1)
+        familyIndices.insert(transferFamilyIdx);
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
     queueCreateInfos.reserve(familyIndices.size());
     for (auto idx: familyIndices)
@@ -198,16 +372,100 @@ void VulkanDevice::CreateDevice()
         });
     }
 
+    VkPhysicalDeviceFeatures supportedFeatures10;
+    vkGetPhysicalDeviceFeatures(selectedDevice, &supportedFeatures10);
+
+    // Draws of meshes sharing the geometry arena are combined into one indirect draw where possible
+    m_MultiDrawIndirectSupported = supportedFeatures10.multiDrawIndirect;
+
+    // Indirect draws select their instances with a first instance, otherwise meshes are drawn directly
+    m_IndirectDrawingSupported = supportedFeatures10.drawIndirectFirstInstance;
+    if (!m_IndirectDrawingSupported)
+        LC_INFO("Indirect first instance not supported, indirect drawing disabled");
+    m_PipelineStatisticsSupported = supportedFeatures10.pipelineStatisticsQuery;
+
+    // Secondary command buffers can only add to a statistics query of their primary with inherited queries
+    m_InheritedQueriesSupported = supportedFeatures10.inheritedQueries;
+
+    // Compute shaders write packed and 16-bit render targets where their image formats are supported
+    m_StorageExtendedFormatsSupported = supportedFeatures10.shaderStorageImageExtendedFormats;
+
     auto deviceFeatures = VkPhysicalDeviceFeatures{
+        .multiDrawIndirect = m_MultiDrawIndirectSupported,
+        .drawIndirectFirstInstance = m_IndirectDrawingSupported,
         .depthClamp = VK_TRUE,
-        .samplerAnisotropy = VK_TRUE
+        .samplerAnisotropy = VK_TRUE,
+        .pipelineStatisticsQuery = m_PipelineStatisticsSupported,
+        .shaderStorageImageExtendedFormats = m_StorageExtendedFormatsSupported,
+        .inheritedQueries = m_InheritedQueriesSupported
     };
 
+    // Enable the descriptor indexing features needed for the global texture array if they are available
+    auto vulkan12Features = VkPhysicalDeviceVulkan12Features{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES
+    };
+    if (m_DeviceProperties.apiVersion >= VK_API_VERSION_1_2)
+    {
+        auto supportedFeatures = VkPhysicalDeviceFeatures2{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+            .pNext = &vulkan12Features
+        };
+        vkGetPhysicalDeviceFeatures2(selectedDevice, &supportedFeatures);
+
+        m_BindlessSupported = vulkan12Features.descriptorBindingPartiallyBound &&
+            vulkan12Features.descriptorBindingSampledImageUpdateAfterBind &&
+            vulkan12Features.descriptorBindingUpdateUnusedWhilePending &&
+            supportedFeatures.features.shaderSampledImageArrayDynamicIndexing;
+
+        // The update-after-bind limits count every sampler in a pipeline layout, so leave room for the other sets
+        auto vulkan12Properties = VkPhysicalDeviceVulkan12Properties{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES
+        };
+        auto properties = VkPhysicalDeviceProperties2{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+            .pNext = &vulkan12Properties
+        };
+        vkGetPhysicalDeviceProperties2(selectedDevice, &properties);
+
+        uint32 requiredDescriptors = VulkanShader::kMaxBindlessTextures + VulkanShader::kMaxDescriptors;
+        bool withinLimits = vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSamplers >= requiredDescriptors &&
+            vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSampledImages >= requiredDescriptors &&
+            vulkan12Properties.maxDescriptorSetUpdateAfterBindSamplers >= requiredDescriptors &&
+            vulkan12Properties.maxDescriptorSetUpdateAfterBindSampledImages >= requiredDescriptors;
+
+        if (m_BindlessSupported && !withinLimits)
+        {
+            LC_INFO("Descriptor limits below {} textures, bindless textures disabled", requiredDescriptors);
+            m_BindlessSupported = false;
+        }
+
+        // Indirect draws skip the commands of batches culled entirely when the number of draws can be read from a buffer
+        m_IndirectDrawCountSupported = vulkan12Features.drawIndirectCount;
+    }
+
+    vulkan12Features = VkPhysicalDeviceVulkan12Features{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+        .drawIndirectCount = m_IndirectDrawCountSupported,
+        .descriptorBindingSampledImageUpdateAfterBind = m_BindlessSupported,
+        .descriptorBindingUpdateUnusedWhilePending = m_BindlessSupported,
+        .descriptorBindingPartiallyBound = m_BindlessSupported
+    };
+    if (m_BindlessSupported)
+        deviceFeatures.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+    else
+        LC_INFO("Descriptor indexing not supported, bindless textures disabled");
+
+    if (!m_IndirectDrawCountSupported)
+        LC_INFO("Indirect draw count not supported, culled batches are drawn with no instances");
+
     // Create device
-    std::vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+    std::vector<const char*> deviceExtensions;
+    if (!IsHeadless())
+        deviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
 
     auto deviceCreateInfo = VkDeviceCreateInfo{
         .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+        .pNext = (m_BindlessSupported || m_IndirectDrawCountSupported) ? &vulkan12Features : nullptr,
         .queueCreateInfoCount = static_cast<uint32>(queueCreateInfos.size()),
         .pQueueCreateInfos = queueCreateInfos.data(),
         .enabledExtensionCount = static_cast<uint32>(deviceExtensions.size()),
@@ -221,44 +479,486 @@ void VulkanDevice::CreateDevice()
 
     vkGetDeviceQueue(m_Handle, graphicsFamilyIdx, 0, &m_GraphicsQueue.handle);
     vkGetDeviceQueue(m_Handle, presentFamilyIdx, 0, &m_PresentQueue.handle);
+
+    if (transferFamilyIdx != -1)
+    {
+        m_TransferQueue.familyIndex = transferFamilyIdx;
+        vkGetDeviceQueue(m_Handle, transferFamilyIdx, 0, &m_TransferQueue.handle);
+    }
+}
+
+void VulkanDevice::CreateBindlessTable()
+{
+    if (!m_BindlessSupported)
+        return;
+
+    // Descriptors are written as textures are added, including while the set is bound by commands in flight
+    VkDescriptorBindingFlags bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+        VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+
+    auto bindingFlagsInfo = VkDescriptorSetLayoutBindingFlagsCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+        .bindingCount = 1,
+        .pBindingFlags = &bindingFlags
+    };
+
+    auto binding = VkDescriptorSetLayoutBinding{
+        .binding = 0,
+        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .descriptorCount = VulkanShader::kMaxBindlessTextures,
+        .stageFlags = VK_SHADER_STAGE_ALL
+    };
+
+    auto layoutInfo = VkDescriptorSetLayoutCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext = &bindingFlagsInfo,
+        .flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+        .bindingCount = 1,
+        .pBindings = &binding
+    };
+    LC_CHECK(vkCreateDescriptorSetLayout(m_Handle, &layoutInfo, nullptr, &m_BindlessLayout));
+
+    auto poolSize = VkDescriptorPoolSize{
+        .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .descriptorCount = VulkanShader::kMaxBindlessTextures
+    };
+
+    auto poolInfo = VkDescriptorPoolCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+        .maxSets = 1,
+        .poolSizeCount = 1,
+        .pPoolSizes = &poolSize
+    };
+    LC_CHECK(vkCreateDescriptorPool(m_Handle, &poolInfo, nullptr, &m_BindlessPool));
+
+    auto allocInfo = VkDescriptorSetAllocateInfo{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = m_BindlessPool,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &m_BindlessLayout
+    };
+    LC_CHECK(vkAllocateDescriptorSets(m_Handle, &allocInfo, &m_BindlessSet));
+}
+
+bool VulkanDevice::SupportsBindlessTextures()
+{
+    return m_BindlessSupported;
+}
+
+bool VulkanDevice::SupportsIndirectDrawing()
+{
+    return m_IndirectDrawingSupported;
+}
+
+bool VulkanDevice::SupportsIndirectDrawCount()
+{
+    return m_IndirectDrawCountSupported;
+}
+
+bool VulkanDevice::SupportsStorageFormat(TextureFormat format)
+{
+    // Shaders can only declare images of the remaining formats with the extended formats feature
+    switch (format)
+    {
+    case TextureFormat::kRGBA8:
+    case TextureFormat::kRGBA16F:
+    case TextureFormat::kR32F:
+    case TextureFormat::kRGBA32F:
+        break;
+    default:
+        if (!m_StorageExtendedFormatsSupported)
+            return false;
+    }
+
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(m_PhysicalDevice, TextureFormatToVkFormat(format), &properties);
+    return properties.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT;
+}
+
+GeometryArena* VulkanDevice::GetGeometryArena()
+{
+    return m_GeometryArena.get();
+}
+
+uint32 VulkanDevice::AddBindlessTexture(Texture* generalTexture)
+{
+    LC_ASSERT(m_BindlessSupported);
+
+    auto texture = Get(generalTexture);
+    if (texture->bindlessIndex != VulkanTexture::kNoBindlessIndex)
+        return texture->bindlessIndex;
+
+    // Textures in the array are sampled without tracked synchronization, so must stay in their starting layout
+    LC_ASSERT(texture->GetSettings().usage != TextureUsage::kReadWrite);
+
+    uint32 index;
+    if (!m_FreeBindlessIndices.empty())
+    {
+        index = m_FreeBindlessIndices.back();
+        m_FreeBindlessIndices.pop_back();
+    }
+    else if (m_NumBindlessTextures < VulkanShader::kMaxBindlessTextures)
+    {
+        index = m_NumBindlessTextures++;
+    }
+    else
+    {
+        // Sample the first texture rather than index past the end of the array
+        LC_ERROR("Bindless texture array is full ({} textures)", VulkanShader::kMaxBindlessTextures);
+        return 0;
+    }
+
+    WriteBindlessDescriptor(texture, index);
+
+    texture->bindlessIndex = index;
+    return index;
+}
+
+uint64 VulkanDevice::GetBindlessGeneration()
+{
+    return m_BindlessGeneration;
+}
+
+void VulkanDevice::WriteBindlessDescriptor(VulkanTexture* texture, uint32 index)
+{
+    auto imageInfo = VkDescriptorImageInfo{
+        .sampler = texture->sampler,
+        .imageView = texture->imageView,
+        .imageLayout = texture->GetStartingLayout()
+    };
+
+    auto write = VkWriteDescriptorSet{
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = m_BindlessSet,
+        .dstBinding = 0,
+        .dstArrayElement = index,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .pImageInfo = &imageInfo
+    };
+    vkUpdateDescriptorSets(m_Handle, 1, &write, 0, nullptr);
+}
+
+void VulkanDevice::LoadPipelineCache()
+{
+    bool found = false;
+    auto data = ReadFile(GetPipelineCachePath(), std::ios::in | std::ios::binary, &found);
+
+    // Only seed the cache with data produced by this exact device and driver
+    PipelineCacheHeader header{};
+    std::string_view initialData;
+    if (found && data.size() >= sizeof(header))
+    {
+        std::memcpy(&header, data.data(), sizeof(header));
+
+        bool valid = header.magic == PipelineCacheHeader::kMagic &&
+            header.vendorID == m_DeviceProperties.vendorID &&
+            header.deviceID == m_DeviceProperties.deviceID &&
+            header.driverVersion == m_DeviceProperties.driverVersion &&
+            std::memcmp(header.pipelineCacheUUID, m_DeviceProperties.pipelineCacheUUID, VK_UUID_SIZE) == 0 &&
+            header.dataSize == data.size() - sizeof(header);
+
+        if (valid)
+            initialData = std::string_view(data).substr(sizeof(header));
+        else
+            LC_INFO("Discarding pipeline cache from a different device or driver");
+    }
+
+    auto cacheInfo = VkPipelineCacheCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .initialDataSize = initialData.size(),
+        .pInitialData = initialData.data()
+    };
+    LC_CHECK(vkCreatePipelineCache(m_Handle, &cacheInfo, nullptr, &m_PipelineCache));
+
+    LC_DEBUG("Loaded pipeline cache ({} bytes)", initialData.size());
+}
+
+void VulkanDevice::SavePipelineCache()
+{
+    // The cache can grow between the size query and the fetch, so retry until the data fits
+    std::string cacheData;
+    VkResult result;
+    do
+    {
+        size_t querySize = 0;
+        LC_CHECK(vkGetPipelineCacheData(m_Handle, m_PipelineCache, &querySize, nullptr));
+
+        cacheData.resize(querySize);
+        size_t dataSize = querySize;
+        result = vkGetPipelineCacheData(m_Handle, m_PipelineCache, &dataSize, cacheData.data());
+        cacheData.resize(dataSize);
+    } while (result == VK_INCOMPLETE);
+
+    if (result != VK_SUCCESS)
+    {
+        LC_WARN("Failed to retrieve pipeline cache data");
+        return;
+    }
+
+    auto header = PipelineCacheHeader{
+        .magic = PipelineCacheHeader::kMagic,
+        .vendorID = m_DeviceProperties.vendorID,
+        .deviceID = m_DeviceProperties.deviceID,
+        .driverVersion = m_DeviceProperties.driverVersion,
+        .dataSize = cacheData.size()
+    };
+    std::memcpy(header.pipelineCacheUUID, m_DeviceProperties.pipelineCacheUUID, VK_UUID_SIZE);
+
+    std::string data(reinterpret_cast<const char*>(&header), sizeof(header));
+    data += cacheData;
+
+    if (!WriteFileAtomic(GetPipelineCachePath(), data, std::ios::out | std::ios::binary))
+    {
+        LC_WARN("Failed to write pipeline cache {}", GetPipelineCachePath());
+    }
+}
+
+// Settings of a new pipeline, with defines viewing the strings owned by its key so they stay valid for reloads
+static PipelineSettings GetKeyedSettings(const PipelineSettings& settings, const PipelineKey& key)
+{
+    auto keyed = settings;
+    keyed.shaderDefines.assign(key.shaderDefines.begin(), key.shaderDefines.end());
+    return keyed;
+}
+
+VulkanDevice::PipelineMap::value_type& VulkanDevice::FindPipeline(const PipelineSettings& settings)
+{
+    auto key = PipelineKey{
+        .shaderName = settings.shaderName,
+        .shaderDefines = { settings.shaderDefines.begin(), settings.shaderDefines.end() },
+        .type = settings.type,
+        .depthTestEnable = settings.depthTestEnable,
+        .depthWriteEnable = settings.depthWriteEnable,
+        .depthClampEnable = settings.depthClampEnable,
+        .additiveBlendEnable = settings.additiveBlendEnable
+    };
+    if (settings.type == PipelineType::kGraphics)
+    {
+        LC_ASSERT(settings.framebuffer);
+        key.layout = Get(settings.framebuffer)->layout;
+    }
+
+    // Keys are compared in full, so settings whose hashes collide still get their own pipelines
+    auto& item = *m_Pipelines.try_emplace(std::move(key)).first;
+    item.second.references++;
+    return item;
 }
 
 Pipeline* VulkanDevice::CreatePipeline(const PipelineSettings& settings)
 {
-    auto shader = m_ShaderCache->Compile(settings);
-    LC_ASSERT(shader);
+    auto&[key, entry] = FindPipeline(settings);
+    if (entry.pipeline)
+        return entry.pipeline.get();
+
+    auto keyed = GetKeyedSettings(settings, key);
+    auto shader = m_ShaderCache->Compile(keyed);
+
+    // The cache logs compile errors, and pipelines are left unbuilt until a reload compiles their shader
+    if (shader)
+        entry.pipeline = std::make_unique<VulkanPipeline>(this, shader, keyed, key.layout);
+    else
+        entry.pipeline = std::make_unique<VulkanPipeline>(this, keyed, key.layout);
+    entry.pipeline->key = &key;
+    return entry.pipeline.get();
+}
+
+Pipeline* VulkanDevice::CreatePipelineAsync(const PipelineSettings& settings)
+{
+    auto&[key, entry] = FindPipeline(settings);
+    if (entry.pipeline)
+        return entry.pipeline.get();
+
+    auto keyed = GetKeyedSettings(settings, key);
+    entry.pipeline = std::make_unique<VulkanPipeline>(this, keyed, key.layout);
+    entry.pipeline->key = &key;
+
+    m_PendingPipelines.push_back(PendingPipeline{
+        .pipeline = entry.pipeline.get(),
+        .shader = m_ShaderCache->CompileAsync(keyed, *m_Workers)
+    });
+    return entry.pipeline.get();
+}
+
+void VulkanDevice::WaitForPipelines()
+{
+    if (m_PendingPipelines.empty())
+        return;
+
+    // Shader modules and layouts are created here, then the driver builds pipelines concurrently
+    std::vector<std::future<void>> creates;
+    creates.reserve(m_PendingPipelines.size());
+    for (auto& pending: m_PendingPipelines)
+    {
+        auto shader = m_ShaderCache->Finish(pending.shader.get());
+
+        // Left unbuilt like a failed synchronous creation, the cache has logged the compile error
+        if (!shader)
+            continue;
+
+        auto pipeline = pending.pipeline;
+        pipeline->AttachShader(shader);
+        creates.push_back(m_Workers->Submit([pipeline]()
+        {
+            pipeline->Create();
+        }));
+    }
+
+    for (auto& create: creates)
+        create.wait();
 
-    return m_Pipelines.emplace_back(std::make_unique<VulkanPipeline>(this, shader, settings)).get();
+    m_PendingPipelines.clear();
 }
 
 void VulkanDevice::DestroyPipeline(Pipeline* pipeline)
 {
-    RemoveResource(pipeline, m_Pipelines);
+    // Unreferenced pipelines are retained for reuse until ReleaseUnusedPipelines
+    auto it = m_Pipelines.find(*Get(pipeline)->key);
+    LC_ASSERT(it != m_Pipelines.end() && it->second.references > 0);
+
+    it->second.references--;
+}
+
+void VulkanDevice::ReleaseUnusedPipelines()
+{
+    // Pending pipelines may have been destroyed before being built
+    WaitForPipelines();
+
+    auto unused = std::make_shared<std::vector<std::unique_ptr<VulkanPipeline>>>();
+    for (auto it = m_Pipelines.begin(); it != m_Pipelines.end();)
+    {
+        if (it->second.references == 0)
+        {
+            unused->push_back(std::move(it->second.pipeline));
+            it = m_Pipelines.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    if (!unused->empty())
+    {
+        LC_INFO("Releasing {} unused pipelines", unused->size());
+        DeferRelease([unused]() { unused->clear(); });
+    }
 }
 
 void VulkanDevice::ReloadPipelines()
 {
+    WaitForPipelines();
     vkDeviceWaitIdle(m_Handle);
-    for (auto& pipeline: m_Pipelines)
+    for (auto&[key, entry]: m_Pipelines)
     {
+        auto& pipeline = entry.pipeline;
         auto updatedShader = m_ShaderCache->Compile(pipeline->GetSettings());
         if (updatedShader)
         {
             if (pipeline->shader != updatedShader)
             {
-                *pipeline = VulkanPipeline(this, updatedShader, pipeline->GetSettings());
+                pipeline->Rebuild(updatedShader);
             }
         }
     }
 }
 
+VkRenderPass VulkanDevice::FindRenderPass(const RenderPassLayout& layout)
+{
+    auto it = m_RenderPasses.find(layout);
+    if (it != m_RenderPasses.end())
+        return it->second;
+
+    // Internal convention used here is that all color attachments are placed at indices starting at 0, then the depth
+    // attachment (if present) is placed at the end
+    Array <VkAttachmentDescription, kMaxAttachments> attachments;
+    auto depthIndex = VK_ATTACHMENT_UNUSED;
+
+    // Populate attachment descriptions
+    for (auto format: layout.colorFormats)
+    {
+        attachments.emplace_back(VkAttachmentDescription{
+            .format = format,
+            .samples = static_cast<VkSampleCountFlagBits>(layout.samples),
+            .loadOp = VK_ATTACHMENT_LOAD_OP_LOAD,
+            .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+            .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+            .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            .initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            .finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+        });
+    }
+    if (layout.depthFormat != VK_FORMAT_UNDEFINED)
+    {
+        depthIndex = attachments.size();
+        attachments.emplace_back(VkAttachmentDescription{
+            .format = layout.depthFormat,
+            .samples = static_cast<VkSampleCountFlagBits>(layout.samples),
+            .loadOp = VK_ATTACHMENT_LOAD_OP_LOAD,
+            .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+            .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+            .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            .initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+            .finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+        });
+    }
+
+    // Populate attachment references
+    Array <VkAttachmentReference, kMaxColorAttachments> colorRefs;
+    for (uint32 i = 0; i < layout.colorFormats.size(); ++i)
+    {
+        colorRefs.push_back(VkAttachmentReference{
+            .attachment = i,
+            .layout = attachments[i].finalLayout
+        });
+    }
+    auto depthRef = VkAttachmentReference{
+        .attachment = depthIndex,
+        .layout = (depthIndex != VK_ATTACHMENT_UNUSED) ? attachments[depthIndex].finalLayout : VK_IMAGE_LAYOUT_UNDEFINED
+    };
+
+    auto subpassDesc = VkSubpassDescription{
+        .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+        .colorAttachmentCount = static_cast<uint32_t>(colorRefs.size()),
+        .pColorAttachments = colorRefs.data(),
+        .pDepthStencilAttachment = &depthRef
+    };
+
+    auto passInfo = VkRenderPassCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+        .attachmentCount = static_cast<uint32_t>(attachments.size()),
+        .pAttachments = attachments.data(),
+        .subpassCount = 1,
+        .pSubpasses = &subpassDesc
+    };
+
+    VkRenderPass renderPass;
+    LC_CHECK(vkCreateRenderPass(m_Handle, &passInfo, nullptr, &renderPass));
+
+    m_RenderPasses.insert(it, { layout, renderPass });
+    return renderPass;
+}
+
 Buffer* VulkanDevice::CreateBuffer(BufferType type, size_t size)
 {
+    std::lock_guard lock(m_BufferMutex);
     return m_Buffers.emplace_back(std::make_unique<VulkanBuffer>(this, type, size)).get();
 }
 
 void VulkanDevice::DestroyBuffer(Buffer* buffer)
 {
+    for (auto& context: m_Contexts)
+        context->InvalidateDescriptorSets(Get(buffer));
+
+    // Commands in flight may still read the buffer
+    DeferRelease([this, buffer]()
+    { ReleaseBuffer(buffer); });
+}
+
+void VulkanDevice::ReleaseBuffer(Buffer* buffer)
+{
+    std::lock_guard lock(m_BufferMutex);
     RemoveResource(buffer, m_Buffers);
 }
 
@@ -269,7 +969,125 @@ Texture* VulkanDevice::CreateTexture(const TextureSettings& settings)
 
 void VulkanDevice::DestroyTexture(Texture* texture)
 {
-    RemoveResource(texture, m_Textures);
+    for (auto& context: m_Contexts)
+        context->InvalidateDescriptorSets(Get(texture));
+
+    // The stale descriptor is partially bound, so is left in place until commands in flight are done with it
+    auto index = Get(texture)->bindlessIndex;
+    if (index != VulkanTexture::kNoBindlessIndex)
+    {
+        DeferRelease([this, index]()
+        { m_FreeBindlessIndices.push_back(index); });
+    }
+
+    m_Uploader->Forget(Get(texture));
+    DeferRelease([this, texture]()
+    { RemoveResource(texture, m_Textures); });
+}
+
+void VulkanDevice::ResizeTexture(Texture* generalTexture, uint32 width, uint32 height)
+{
+    auto texture = Get(generalTexture);
+    LC_ASSERT(texture->GetSettings().usage == TextureUsage::kReadOnly);
+
+    for (auto& context: m_Contexts)
+        context->InvalidateDescriptorSets(texture);
+    m_Uploader->Forget(texture);
+
+    texture->Resize(width, height);
+
+    // Commands in flight may still sample the old image through its index, so the new image is written to an unused
+    // index and the old one is freed along with the old image
+    auto oldIndex = texture->bindlessIndex;
+    if (oldIndex != VulkanTexture::kNoBindlessIndex)
+    {
+        texture->bindlessIndex = VulkanTexture::kNoBindlessIndex;
+        AddBindlessTexture(texture);
+        ++m_BindlessGeneration;
+
+        DeferRelease([this, oldIndex]()
+        { m_FreeBindlessIndices.push_back(oldIndex); });
+    }
+}
+
+Texture* VulkanDevice::CreateTransientTexture(const TextureSettings& settings)
+{
+    return m_Textures.emplace_back(std::make_unique<VulkanTexture>(this, settings,
+        VulkanTexture::DeferMemory{})).get();
+}
+
+TransientMemoryStats VulkanDevice::AllocateTransientTextures(const std::vector<TextureLifetime>& lifetimes)
+{
+    std::vector<TransientResource> resources;
+    resources.reserve(lifetimes.size());
+
+    for (auto& lifetime: lifetimes)
+    {
+        auto texture = Get(lifetime.texture);
+        LC_ASSERT(texture->transient && !texture->IsResident());
+
+        // All transient textures are optimally tiled, so bufferImageGranularity does not constrain placement
+        VkMemoryRequirements requirements;
+        vkGetImageMemoryRequirements(m_Handle, texture->image, &requirements);
+
+        resources.push_back(TransientResource{
+            .size = requirements.size,
+            .alignment = requirements.alignment,
+            .memoryTypeBits = requirements.memoryTypeBits,
+            .firstPass = lifetime.firstPass,
+            .lastPass = lifetime.lastPass
+        });
+    }
+
+    auto plan = PlanTransientMemory(resources);
+
+    // Allocate one block of memory per group of aliased textures
+    std::vector<VulkanTransientBlock*> blocks;
+    for (auto& block: plan.blocks)
+    {
+        auto requirements = VkMemoryRequirements{
+            .size = block.size,
+            .alignment = block.alignment,
+            .memoryTypeBits = block.memoryTypeBits
+        };
+        auto allocInfo = VmaAllocationCreateInfo{
+            .usage = VMA_MEMORY_USAGE_GPU_ONLY
+        };
+
+        auto& transientBlock = m_TransientBlocks.emplace_back(std::make_unique<VulkanTransientBlock>());
+        LC_CHECK(vmaAllocateMemory(m_Allocator, &requirements, &allocInfo, &transientBlock->alloc, nullptr));
+        blocks.push_back(transientBlock.get());
+    }
+
+    for (uint32 i = 0; i < lifetimes.size(); ++i)
+    {
+        auto& placement = plan.placements[i];
+        Get(lifetimes[i].texture)->BindMemory(blocks[placement.block], placement.offset);
+    }
+
+    // Create framebuffers which were waiting on memory for their attachments
+    for (auto& framebuffer: m_Framebuffers)
+    {
+        if (!framebuffer->handle && framebuffer->AttachmentsResident())
+            framebuffer->Create();
+    }
+
+    return plan.stats;
+}
+
+void VulkanDevice::ReleaseTransientBlock(VulkanTransientBlock* block)
+{
+    LC_ASSERT(block->references > 0);
+    if (--block->references == 0)
+    {
+        vmaFreeMemory(m_Allocator, block->alloc);
+
+        auto it = std::find_if(m_TransientBlocks.begin(), m_TransientBlocks.end(), [&](auto& p)
+        {
+            return p.get() == block;
+        });
+        m_TransientBlocks.erase(it);
+    }
 }
 
 Framebuffer* VulkanDevice::CreateFramebuffer(const FramebufferSettings& info)
@@ -295,6 +1113,7 @@ void VulkanDevice::DestroyContext(Context* context)
 
 Texture* VulkanDevice::AcquireSwapchainImage()
 {
+    LC_ASSERT(!IsHeadless());
     m_SwapchainImageAcquired = true;
     return m_Swapchain->AcquireImage(m_FrameIndex);
 }
@@ -303,6 +1122,9 @@ void VulkanDevice::Submit(Context* generalContext)
 {
     auto context = Get(generalContext);
 
+    // Commands may use resources uploaded since the last submission
+    m_Uploader->Flush();
+
     if (m_SwapchainImageAcquired)
     {
         VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_TRANSFER_BIT };
@@ -327,10 +1149,69 @@ void VulkanDevice::Submit(Context* generalContext)
         };
         LC_CHECK(vkQueueSubmit(m_GraphicsQueue.handle, 1, &submitInfo, context->m_ReadyFence));
     }
+
+    // An empty submission signals its fence once all work submitted before it has completed
+    if (!m_PendingReleases.empty())
+    {
+        VkFence fence;
+        if (!m_FreeReleaseFences.empty())
+        {
+            fence = m_FreeReleaseFences.back();
+            m_FreeReleaseFences.pop_back();
+        }
+        else
+        {
+            auto fenceInfo = VkFenceCreateInfo{
+                .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO
+            };
+            LC_CHECK(vkCreateFence(m_Handle, &fenceInfo, nullptr, &fence));
+        }
+        LC_CHECK(vkQueueSubmit(m_GraphicsQueue.handle, 0, nullptr, fence));
+
+        m_DeferredReleases.push_back(DeferredReleases{ fence, std::move(m_PendingReleases) });
+        m_PendingReleases.clear();
+    }
+
+    RunCompletedReleases();
+}
+
+void VulkanDevice::DeferRelease(std::function<void()> release)
+{
+    m_PendingReleases.push_back(std::move(release));
+}
+
+void VulkanDevice::RunPendingReleases()
+{
+    // Releases may defer further releases
+    while (!m_PendingReleases.empty())
+    {
+        auto releases = std::move(m_PendingReleases);
+        m_PendingReleases.clear();
+
+        for (auto& release: releases)
+            release();
+    }
+}
+
+void VulkanDevice::RunCompletedReleases()
+{
+    while (!m_DeferredReleases.empty() && vkGetFenceStatus(m_Handle, m_DeferredReleases.front().fence) == VK_SUCCESS)
+    {
+        // Releases may defer further releases, which wait for the next submission
+        auto deferred = std::move(m_DeferredReleases.front());
+        m_DeferredReleases.pop_front();
+
+        for (auto& release: deferred.releases)
+            release();
+
+        LC_CHECK(vkResetFences(m_Handle, 1, &deferred.fence));
+        m_FreeReleaseFences.push_back(deferred.fence);
+    }
 }
 
 bool VulkanDevice::Present()
 {
+    LC_ASSERT(!IsHeadless());
     return m_Swapchain->Present(m_FrameIndex++, m_PresentQueue.handle);
 }
 
@@ -374,13 +1255,37 @@ void VulkanDevice::RemoveResource(T resource, C& container)
 
 void VulkanDevice::WaitIdle()
 {
+    m_Uploader->Flush();
     vkDeviceWaitIdle(m_Handle);
+
+    RunCompletedReleases();
 }
 
 void VulkanDevice::RebuildSwapchain()
 {
+    if (IsHeadless())
+        return;
+
     m_Swapchain.reset();
-    m_Swapchain = std::make_unique<VulkanSwapchain>(this);
+    m_Swapchain = std::make_unique<VulkanSwapchain>(this, m_SwapchainSettings);
+}
+
+void VulkanDevice::SetSwapchainSettings(const SwapchainSettings& settings)
+{
+    m_SwapchainSettings = settings;
+
+    WaitIdle();
+    RebuildSwapchain();
+}
+
+const SwapchainSettings& VulkanDevice::GetSwapchainSettings()
+{
+    return m_SwapchainSettings;
+}
+
+bool VulkanDevice::IsHeadless()
+{
+    return m_Window == nullptr;
 }
 
 }
@@ -1,9 +1,13 @@
 #pragma once
 
 #include "VulkanCommon.hpp"
+#include "core/ThreadPool.hpp"
 #include "device/Device.hpp"
 #include "debug/Input.hpp"
 #include "VulkanSwapchain.hpp"
+#include "VulkanFramebuffer.hpp"
+#include "VulkanPipeline.hpp"
+#include "ShaderCache.hpp"
 
 struct GLFWwindow;
 
@@ -13,18 +17,38 @@ namespace lucent
 class VulkanDevice : public Device
 {
 public:
-    explicit VulkanDevice(GLFWwindow* window);
+    //! Creates a headless device without a surface or swapchain if no window is given
+    explicit VulkanDevice(GLFWwindow* window, const SwapchainSettings& swapchainSettings = {});
     ~VulkanDevice() override;
 
+    //! True if a headless device can be created, i.e. a Vulkan implementation with a graphics queue is installed
+    static bool HasHeadlessDevice();
+
     Buffer* CreateBuffer(BufferType type, size_t size) override;
     void DestroyBuffer(Buffer* buffer) override;
 
     Texture* CreateTexture(const TextureSettings& textureSettings) override;
     void DestroyTexture(Texture* texture) override;
+    void ResizeTexture(Texture* texture, uint32 width, uint32 height) override;
+
+    Texture* CreateTransientTexture(const TextureSettings& textureSettings) override;
+    TransientMemoryStats AllocateTransientTextures(const std::vector<TextureLifetime>& lifetimes) override;
+
+    bool SupportsBindlessTextures() override;
+    bool SupportsIndirectDrawing() override;
+    bool SupportsIndirectDrawCount() override;
+    bool SupportsStorageFormat(TextureFormat format) override;
+    uint32 AddBindlessTexture(Texture* texture) override;
+    uint64 GetBindlessGeneration() override;
+
+    GeometryArena* GetGeometryArena() override;
 
     Pipeline* CreatePipeline(const PipelineSettings& settings) override;
+    Pipeline* CreatePipelineAsync(const PipelineSettings& settings) override;
+    void WaitForPipelines() override;
     void DestroyPipeline(Pipeline* pipeline) override;
     void ReloadPipelines() override;
+    void ReleaseUnusedPipelines() override;
 
     Framebuffer* CreateFramebuffer(const FramebufferSettings& settings) override;
     void DestroyFramebuffer(Framebuffer* framebuffer) override;
@@ -32,6 +56,7 @@ public:
     Context* CreateContext() override;
     void DestroyContext(Context* context) override;
     void Submit(Context* context) override;
+    void DeferRelease(std::function<void()> release) override;
 
     Texture* AcquireSwapchainImage() override;
     bool Present() override;
@@ -39,23 +64,58 @@ public:
     void WaitIdle() override;
     void RebuildSwapchain() override;
 
+    void SetSwapchainSettings(const SwapchainSettings& settings) override;
+    const SwapchainSettings& GetSwapchainSettings() override;
+
+    bool IsHeadless() override;
+
     VkDevice GetHandle() const { return m_Handle; }
     VmaAllocator GetAllocator() const { return m_Allocator; }
     const VkPhysicalDeviceLimits& GetLimits() const { return m_DeviceProperties.limits; }
     VkPhysicalDevice GetPhysicalHandle() const { return m_PhysicalDevice; }
     VkSurfaceKHR GetSurface() const { return m_Surface; }
+    VkPipelineCache GetPipelineCache() const { return m_PipelineCache; }
+    VkDescriptorSetLayout GetBindlessLayout() const { return m_BindlessLayout; }
+    ThreadPool& GetWorkers() { return *m_Workers; }
+    VulkanUploader& GetUploader() { return *m_Uploader; }
+
+    //! Returns a render pass compatible with all framebuffers of the given layout
+    VkRenderPass FindRenderPass(const RenderPassLayout& layout);
 
 private:
     friend class VulkanContext;
     friend class VulkanSwapchain;
     friend class VulkanTexture;
+    friend class VulkanUploader;
 
     void CreateInstance();
     void CreateDevice();
+    void CreateBindlessTable();
+    void WriteBindlessDescriptor(VulkanTexture* texture, uint32 index);
+
+    void LoadPipelineCache();
+    void SavePipelineCache();
 
     template<typename T, typename C>
     void RemoveResource(T resource, C& container);
 
+    void ReleaseTransientBlock(VulkanTransientBlock* block);
+
+    // Destroys a buffer without invalidating descriptor sets which reference it
+    void ReleaseBuffer(Buffer* buffer);
+
+    // Calls deferred releases whose submissions have completed, without waiting for those still in flight
+    void RunCompletedReleases();
+
+    // Calls deferred releases still waiting on a submission, for when nothing is in flight
+    void RunPendingReleases();
+
+    struct PipelineEntry;
+    using PipelineMap = std::unordered_map<PipelineKey, PipelineEntry, PipelineKeyHash>;
+
+    // Adds a reference to the entry matching the settings, adding an entry without a pipeline if there is none
+    PipelineMap::value_type& FindPipeline(const PipelineSettings& settings);
+
     static VkBool32 DebugCallback(VkDebugUtilsMessageSeverityFlagBitsEXT severity,
         VkDebugUtilsMessageTypeFlagsEXT types,
         const VkDebugUtilsMessengerCallbackDataEXT* callbackData,
@@ -70,6 +130,28 @@ private:
     VkPhysicalDevice m_PhysicalDevice{};
     VkPhysicalDeviceProperties m_DeviceProperties{};
     VmaAllocator m_Allocator{};
+    VkPipelineCache m_PipelineCache{};
+
+    // Global texture array, only created if the device supports updating descriptors after they are bound
+    bool m_BindlessSupported = false;
+    bool m_MultiDrawIndirectSupported = false;
+    bool m_IndirectDrawingSupported = false;
+    bool m_IndirectDrawCountSupported = false;
+
+    // Regions are timed if the graphics queue supports timestamps, and labelled if a debugger has hooked debug utils
+    bool m_TimestampsSupported = false;
+    bool m_PipelineStatisticsSupported = false;
+    bool m_InheritedQueriesSupported = false;
+    bool m_StorageExtendedFormatsSupported = false;
+    PFN_vkCmdBeginDebugUtilsLabelEXT m_CmdBeginDebugLabel{};
+    PFN_vkCmdEndDebugUtilsLabelEXT m_CmdEndDebugLabel{};
+
+    VkDescriptorSetLayout m_BindlessLayout{};
+    VkDescriptorPool m_BindlessPool{};
+    VkDescriptorSet m_BindlessSet{};
+    uint32 m_NumBindlessTextures = 0;
+    std::vector<uint32> m_FreeBindlessIndices;
+    uint64 m_BindlessGeneration = 0;
 
     struct DeviceQueue
     {
@@ -78,21 +160,55 @@ private:
     };
     DeviceQueue m_GraphicsQueue{};
     DeviceQueue m_PresentQueue{};
+    // Only created if the device has a queue family for transfers alone, otherwise uploads use the graphics queue
+    DeviceQueue m_TransferQueue{};
+
+    // Pipelines are shared between identical settings and kept alive when unreferenced so that renderer
+    // rebuilds can reuse them, until ReleaseUnusedPipelines
+    struct PipelineEntry
+    {
+        std::unique_ptr<VulkanPipeline> pipeline;
+        uint32 references = 0;
+    };
+    PipelineMap m_Pipelines;
+    std::unordered_map<RenderPassLayout, VkRenderPass, RenderPassLayoutHash> m_RenderPasses;
 
-    std::vector<std::unique_ptr<VulkanPipeline>> m_Pipelines;
+    // Contexts recording on worker threads allocate scratch buffers
+    std::mutex m_BufferMutex;
     std::vector<std::unique_ptr<VulkanBuffer>> m_Buffers;
     std::vector<std::unique_ptr<VulkanTexture>> m_Textures;
+    std::vector<std::unique_ptr<VulkanTransientBlock>> m_TransientBlocks;
     std::vector<std::unique_ptr<VulkanFramebuffer>> m_Framebuffers;
     std::vector<std::unique_ptr<VulkanContext>> m_Contexts;
 
     std::unique_ptr<VulkanSwapchain> m_Swapchain;
+    SwapchainSettings m_SwapchainSettings;
     bool m_SwapchainImageAcquired = false;
     uint64 m_FrameIndex{};
 
-    Buffer* m_TransferBuffer;
-    VulkanContext* m_OneShotContext;
+    std::unique_ptr<VulkanUploader> m_Uploader;
+    std::unique_ptr<GeometryArena> m_GeometryArena;
 
+    // Releases wait for the next submission, then for a fence signaled after it on the graphics queue, which
+    // completes in submission order
+    struct DeferredReleases
+    {
+        VkFence fence;
+        std::vector<std::function<void()>> releases;
+    };
+    std::vector<std::function<void()>> m_PendingReleases;
+    std::deque<DeferredReleases> m_DeferredReleases;
+    std::vector<VkFence> m_FreeReleaseFences;
+
+    std::unique_ptr<ThreadPool> m_Workers;
     std::unique_ptr<ShaderCache> m_ShaderCache;
+
+    struct PendingPipeline
+    {
+        VulkanPipeline* pipeline;
+        std::future<ShaderCache::CompileResult> shader;
+    };
+    std::vector<PendingPipeline> m_PendingPipelines;
 };
 
 }
@@ -13,6 +13,25 @@ VulkanFramebuffer::VulkanFramebuffer(VulkanDevice* dev, const FramebufferSetting
     extent = Get(info.colorTextures.empty() ? info.depthTexture : info.colorTextures.front())->extent;
     samples = Get(info.colorTextures.empty() ? info.depthTexture : info.colorTextures.front())->samples;
 
+    // Find a compatible render pass
+    for (auto texture: info.colorTextures)
+        layout.colorFormats.push_back(Get(texture)->format);
+
+    if (info.depthTexture)
+        layout.depthFormat = Get(info.depthTexture)->format;
+
+    layout.samples = samples;
+    renderPass = device->FindRenderPass(layout);
+
+    // Transient attachments may not have memory bound yet, in which case the device creates the framebuffer later
+    if (AttachmentsResident())
+        Create();
+}
+
+void VulkanFramebuffer::Create()
+{
+    auto& info = m_Settings;
+
     // Create image views if a specific layer or level is requested
     auto createTempView =
         [&](VulkanTexture* texture, int layer, int level, VkImageAspectFlags aspectFlags) -> VkImageView
@@ -47,79 +66,18 @@ VulkanFramebuffer::VulkanFramebuffer(VulkanDevice* dev, const FramebufferSetting
     depthImageView = createTempView(
         Get(info.depthTexture), info.depthLayer, info.depthLevel, VK_IMAGE_ASPECT_DEPTH_BIT);
 
-    // Create render pass
-
     // Internal convention used here is that all color attachments are placed at indices starting at 0, then the depth
     // attachment (if present) is placed at the end
-
-    Array <VkAttachmentDescription, kMaxAttachments> attachments;
     Array <VkImageView, kMaxAttachments> imageViews;
-    auto depthIndex = VK_ATTACHMENT_UNUSED;
-
-    // Populate attachment descriptions
     for (int i = 0; i < info.colorTextures.size(); ++i)
     {
-        auto colorTexture = Get(info.colorTextures[i]);
-        auto colorView = colorImageViews[i] ? colorImageViews[i] : colorTexture->imageView;
-
-        attachments.emplace_back(VkAttachmentDescription{
-            .format = colorTexture->format,
-            .samples = static_cast<VkSampleCountFlagBits>(colorTexture->samples),
-            .loadOp = VK_ATTACHMENT_LOAD_OP_LOAD,
-            .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
-            .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-            .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-            .initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-            .finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
-        });
-        imageViews.push_back(colorView);
+        imageViews.push_back(colorImageViews[i] ? colorImageViews[i] : Get(info.colorTextures[i])->imageView);
     }
     if (info.depthTexture)
     {
-        depthIndex = attachments.size();
-        attachments.emplace_back(VkAttachmentDescription{
-            .format = Get(info.depthTexture)->format,
-            .samples = static_cast<VkSampleCountFlagBits>(Get(info.depthTexture)->samples),
-            .loadOp = VK_ATTACHMENT_LOAD_OP_LOAD,
-            .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
-            .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-            .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-            .initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
-            .finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
-        });
         imageViews.push_back(depthImageView ? depthImageView : Get(info.depthTexture)->imageView);
     }
 
-    // Populate attachment references
-    Array <VkAttachmentReference, kMaxColorAttachments> colorRefs;
-    for (uint32 i = 0; i < info.colorTextures.size(); ++i)
-    {
-        colorRefs.push_back(VkAttachmentReference{
-            .attachment = i,
-            .layout = attachments[i].finalLayout
-        });
-    }
-    auto depthRef = VkAttachmentReference{
-        .attachment = depthIndex,
-        .layout = (depthIndex != VK_ATTACHMENT_UNUSED) ? attachments[depthIndex].finalLayout : VK_IMAGE_LAYOUT_UNDEFINED
-    };
-
-    auto subpassDesc = VkSubpassDescription{
-        .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
-        .colorAttachmentCount = static_cast<uint32_t>(colorRefs.size()),
-        .pColorAttachments = colorRefs.data(),
-        .pDepthStencilAttachment = &depthRef
-    };
-
-    auto passInfo = VkRenderPassCreateInfo{
-        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
-        .attachmentCount = static_cast<uint32_t>(attachments.size()),
-        .pAttachments = attachments.data(),
-        .subpassCount = 1,
-        .pSubpasses = &subpassDesc
-    };
-    LC_CHECK(vkCreateRenderPass(device->GetHandle(), &passInfo, nullptr, &renderPass));
-
     // Create framebuffer
     auto fbInfo = VkFramebufferCreateInfo{
         .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
@@ -133,6 +91,16 @@ VulkanFramebuffer::VulkanFramebuffer(VulkanDevice* dev, const FramebufferSetting
     LC_CHECK(vkCreateFramebuffer(device->GetHandle(), &fbInfo, nullptr, &handle));
 }
 
+bool VulkanFramebuffer::AttachmentsResident() const
+{
+    for (auto texture: m_Settings.colorTextures)
+    {
+        if (!Get(texture)->IsResident())
+            return false;
+    }
+    return !m_Settings.depthTexture || Get(m_Settings.depthTexture)->IsResident();
+}
+
 VulkanFramebuffer::~VulkanFramebuffer()
 {
     auto deviceHandle = device->GetHandle();
@@ -142,7 +110,16 @@ VulkanFramebuffer::~VulkanFramebuffer()
     }
     if (depthImageView) vkDestroyImageView(deviceHandle, depthImageView, nullptr);
     vkDestroyFramebuffer(deviceHandle, handle, nullptr);
-    vkDestroyRenderPass(deviceHandle, renderPass, nullptr);
+}
+
+uint64 RenderPassLayout::Hash(uint64 hash) const
+{
+    for (auto format: colorFormats)
+        hash = HashBytes(format, hash);
+
+    hash = HashBytes(static_cast<uint32>(colorFormats.size()), hash);
+    hash = HashBytes(depthFormat, hash);
+    return HashBytes(samples, hash);
 }
 
 }
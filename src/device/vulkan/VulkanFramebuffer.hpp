@@ -1,21 +1,44 @@
 #pragma once
 
 #include "device/Framebuffer.hpp"
+#include "core/Hash.hpp"
 #include "VulkanCommon.hpp"
 
 namespace lucent
 {
 
+//! Attachment formats and sample count of a framebuffer, which determine render pass compatibility
+struct RenderPassLayout
+{
+    Array <VkFormat, kMaxColorAttachments> colorFormats;
+    VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+    uint32 samples = 1;
+
+    bool operator==(const RenderPassLayout& other) const = default;
+
+    uint64 Hash(uint64 hash = FNVTraits<uint64>::kOffset) const;
+};
+
+struct RenderPassLayoutHash
+{
+    size_t operator()(const RenderPassLayout& layout) const { return layout.Hash(); }
+};
+
 class VulkanFramebuffer : public Framebuffer
 {
 public:
     VulkanFramebuffer(VulkanDevice* device, const FramebufferSettings& settings);
     ~VulkanFramebuffer();
 
+    //! Creates the framebuffer handle, deferred by the constructor until all attachments have memory bound
+    void Create();
+    bool AttachmentsResident() const;
+
 public:
     VulkanDevice* device;
-    VkFramebuffer handle;
-    VkRenderPass renderPass;
+    VkFramebuffer handle{};
+    VkRenderPass renderPass; // Shared by all framebuffers with the same layout, owned by the device
+    RenderPassLayout layout;
     VkExtent2D extent;
     uint32 samples;
 
@@ -9,43 +9,84 @@ namespace lucent
 
 using Vertex = Mesh::Vertex;
 
-VulkanPipeline::VulkanPipeline(VulkanDevice* vulkanDevice, VulkanShader* vulkanShader, const PipelineSettings& info)
+uint64 PipelineKey::Hash() const
+{
+    auto hash = lucent::Hash<uint64>(shaderName);
+    for (auto& define: shaderDefines)
+        hash = lucent::Hash<uint64>(define, HashBytes<uint64>(define.size(), hash));
+
+    hash = HashBytes(type, hash);
+    hash = HashBytes(depthTestEnable, hash);
+    hash = HashBytes(depthWriteEnable, hash);
+    hash = HashBytes(depthClampEnable, hash);
+    hash = HashBytes(additiveBlendEnable, hash);
+    return layout.Hash(hash);
+}
+
+VulkanPipeline::VulkanPipeline(VulkanDevice* vulkanDevice, VulkanShader* vulkanShader, const PipelineSettings& info,
+    const RenderPassLayout& renderPassLayout)
+    : VulkanPipeline(vulkanDevice, info, renderPassLayout)
+{
+    AttachShader(vulkanShader);
+    Create();
+}
+
+VulkanPipeline::VulkanPipeline(VulkanDevice* vulkanDevice, const PipelineSettings& info,
+    const RenderPassLayout& renderPassLayout)
     : device(vulkanDevice)
-    , shader(vulkanShader)
+    , layout(renderPassLayout)
 {
     m_Settings = info;
+    m_Settings.framebuffer = nullptr;
 
-    LC_ASSERT(shader);
+    if (info.type == PipelineType::kGraphics)
+        renderPass = device->FindRenderPass(layout);
+}
+
+VulkanPipeline::~VulkanPipeline()
+{
+    if (handle)
+        vkDestroyPipeline(device->GetHandle(), handle, nullptr);
+
+    if (shader)
+        shader->uses--;
+}
+
+void VulkanPipeline::AttachShader(VulkanShader* vulkanShader)
+{
+    LC_ASSERT(vulkanShader && !shader);
+    shader = vulkanShader;
     shader->uses++;
+}
 
-    (info.type == PipelineType::kGraphics) ? InitGraphics() : InitCompute();
+void VulkanPipeline::Create()
+{
+    LC_ASSERT(shader && !handle);
+    (m_Settings.type == PipelineType::kGraphics) ? InitGraphics() : InitCompute();
 }
 
-VulkanPipeline::~VulkanPipeline()
+void VulkanPipeline::Rebuild(VulkanShader* updatedShader)
 {
     if (handle)
     {
         vkDestroyPipeline(device->GetHandle(), handle, nullptr);
+        handle = VK_NULL_HANDLE;
+    }
+
+    if (shader)
+    {
         shader->uses--;
+        shader = nullptr;
     }
-}
 
-VulkanPipeline& VulkanPipeline::operator=(VulkanPipeline&& other) noexcept
-{
-    std::swap(m_Settings, other.m_Settings);
-    std::swap(device, other.device);
-    std::swap(shader, other.shader);
-    std::swap(handle, other.handle);
-    return *this;
+    AttachShader(updatedShader);
+    Create();
 }
 
 void VulkanPipeline::InitGraphics()
 {
     auto& settings = m_Settings;
 
-    LC_ASSERT(settings.framebuffer);
-    auto& framebuffer = *Get(settings.framebuffer);
-
     // Populate pipeline shader stages
     VkPipelineShaderStageCreateInfo stageInfos[VulkanShader::kMaxStages];
     for (int i = 0; i < shader->stages.size(); ++i)
@@ -116,24 +157,11 @@ void VulkanPipeline::InitGraphics()
         .primitiveRestartEnable = VK_FALSE
     };
 
-    auto viewport = VkViewport{
-        .x = 0.0f, .y = 0.0f,
-        .width = static_cast<float>(framebuffer.extent.width),
-        .height = static_cast<float>(framebuffer.extent.height),
-        .minDepth = 0.0f, .maxDepth = 1.0f
-    };
-
-    auto scissor = VkRect2D{
-        .offset = {},
-        .extent = framebuffer.extent
-    };
-
+    // Viewport and scissor are dynamic so pipelines are independent of framebuffer size
     auto viewportStateInfo = VkPipelineViewportStateCreateInfo{
         .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
         .viewportCount = 1,
-        .pViewports = &viewport,
-        .scissorCount = 1,
-        .pScissors = &scissor
+        .scissorCount = 1
     };
 
     auto rasterizationInfo = VkPipelineRasterizationStateCreateInfo{
@@ -148,7 +176,7 @@ void VulkanPipeline::InitGraphics()
 
     auto multisampleInfo = VkPipelineMultisampleStateCreateInfo{
         .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
-        .rasterizationSamples = static_cast<VkSampleCountFlagBits>(framebuffer.samples),
+        .rasterizationSamples = static_cast<VkSampleCountFlagBits>(layout.samples),
         .sampleShadingEnable = VK_FALSE
     };
 
@@ -162,14 +190,28 @@ void VulkanPipeline::InitGraphics()
     };
 
     Array <VkPipelineColorBlendAttachmentState, kMaxColorAttachments> colorAttachments;
-    for (int i = 0; i < framebuffer.GetSettings().colorTextures.size(); ++i)
+    for (int i = 0; i < layout.colorFormats.size(); ++i)
     {
         auto colorBlendAttachmentInfo = VkPipelineColorBlendAttachmentState{
             .blendEnable = VK_FALSE,
             .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT
                 | VK_COLOR_COMPONENT_A_BIT
         };
-        if (!settings.depthTestEnable)
+        if (settings.additiveBlendEnable)
+        {
+            colorBlendAttachmentInfo = VkPipelineColorBlendAttachmentState{
+                .blendEnable = VK_TRUE,
+                .srcColorBlendFactor = VK_BLEND_FACTOR_ONE,
+                .dstColorBlendFactor = VK_BLEND_FACTOR_ONE,
+                .colorBlendOp = VK_BLEND_OP_ADD,
+                .srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
+                .dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
+                .alphaBlendOp = VK_BLEND_OP_ADD,
+                .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT
+                    | VK_COLOR_COMPONENT_A_BIT
+            };
+        }
+        else if (!settings.depthTestEnable)
         {
             colorBlendAttachmentInfo = VkPipelineColorBlendAttachmentState{
                 .blendEnable = VK_TRUE,
@@ -195,7 +237,8 @@ void VulkanPipeline::InitGraphics()
     };
 
     VkDynamicState dynamicStates[] = {
-        VK_DYNAMIC_STATE_VIEWPORT
+        VK_DYNAMIC_STATE_VIEWPORT,
+        VK_DYNAMIC_STATE_SCISSOR
     };
 
     auto dynamicInfo = VkPipelineDynamicStateCreateInfo{
@@ -217,10 +260,11 @@ void VulkanPipeline::InitGraphics()
         .pColorBlendState = &colorBlendInfo,
         .pDynamicState = &dynamicInfo,
         .layout = shader->pipelineLayout,
-        .renderPass = framebuffer.renderPass,
+        .renderPass = renderPass,
         .subpass = 0
     };
-    LC_CHECK(vkCreateGraphicsPipelines(device->GetHandle(), VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &handle));
+    LC_CHECK(vkCreateGraphicsPipelines(device->GetHandle(), device->GetPipelineCache(),
+        1, &pipelineCreateInfo, nullptr, &handle));
 }
 
 void VulkanPipeline::InitCompute()
@@ -238,7 +282,8 @@ void VulkanPipeline::InitCompute()
         },
         .layout = shader->pipelineLayout
     };
-    LC_CHECK(vkCreateComputePipelines(device->GetHandle(), VK_NULL_HANDLE, 1, &computeInfo, nullptr, &handle));
+    LC_CHECK(vkCreateComputePipelines(device->GetHandle(), device->GetPipelineCache(),
+        1, &computeInfo, nullptr, &handle));
 }
 
 Descriptor* VulkanPipeline::Lookup(DescriptorID id) const
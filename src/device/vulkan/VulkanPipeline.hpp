@@ -2,29 +2,73 @@
 
 #include "VulkanCommon.hpp"
 #include "device/vulkan/VulkanShader.hpp"
+#include "device/vulkan/VulkanFramebuffer.hpp"
 #include "device/Pipeline.hpp"
 
 namespace lucent
 {
 
+//! Settings which distinguish pipelines, owning its defines so it outlives the settings it was made from
+struct PipelineKey
+{
+    std::string shaderName;
+    std::vector<std::string> shaderDefines;
+    PipelineType type;
+    bool depthTestEnable;
+    bool depthWriteEnable;
+    bool depthClampEnable;
+    bool additiveBlendEnable;
+    // Attachment formats rather than the framebuffer itself, so pipelines survive framebuffer rebuilds
+    RenderPassLayout layout;
+
+    bool operator==(const PipelineKey& other) const = default;
+
+    uint64 Hash() const;
+};
+
+struct PipelineKeyHash
+{
+    size_t operator()(const PipelineKey& key) const { return key.Hash(); }
+};
+
 class VulkanPipeline : public Pipeline
 {
 public:
-    VulkanPipeline(VulkanDevice* device, VulkanShader* shader, const PipelineSettings& settings);
+    VulkanPipeline(VulkanDevice* device, VulkanShader* shader, const PipelineSettings& settings,
+        const RenderPassLayout& layout);
+
+    //! Creates an empty pipeline, to be completed with AttachShader and Create
+    VulkanPipeline(VulkanDevice* device, const PipelineSettings& settings, const RenderPassLayout& layout);
     ~VulkanPipeline();
 
-    VulkanPipeline& operator=(VulkanPipeline&& other) noexcept;
+    VulkanPipeline(const VulkanPipeline&) = delete;
+    VulkanPipeline& operator=(const VulkanPipeline&) = delete;
 
     Descriptor* Lookup(DescriptorID id) const override;
 
+    void AttachShader(VulkanShader* shader);
+
+    // May be called from any thread once a shader is attached
+    void Create();
+
+    //! Recreates the pipeline in place with an updated shader
+    void Rebuild(VulkanShader* shader);
+
 private:
     void InitGraphics();
     void InitCompute();
 
 public:
     VulkanDevice* device;
-    VulkanShader* shader;
+    VulkanShader* shader{};
     VkPipeline handle{};
+
+    // Pipelines may outlive the framebuffer they were created with, so only its layout is retained
+    RenderPassLayout layout;
+    VkRenderPass renderPass{};
+
+    // Entry in the device's pipeline registry
+    const PipelineKey* key{};
 };
 
 }
@@ -50,6 +50,10 @@ struct VulkanShader
     static constexpr int kMaxDynamicDescriptorsPerSet = 4;
     static constexpr int kMaxDescriptorBlocks = 8;
 
+    // Set reserved for the device's global array of textures, sampled by index from shaders declaring it
+    static constexpr int kBindlessSet = 3;
+    static constexpr int kMaxBindlessTextures = 4096;
+
     struct Stage
     {
         VkShaderStageFlagBits stageBit;
@@ -58,9 +62,11 @@ struct VulkanShader
 
     Array <Stage, kMaxStages> stages;
     Array <VkDescriptorSetLayout, kMaxSets> setLayouts;
+    Array <uint16, kMaxSets> writableBuffers; // Per set mask of storage buffer bindings the shader may write
     Array <Descriptor, kMaxDescriptors> descriptors;
     Array <Descriptor, kMaxDescriptorBlocks> blocks;
     VkPipelineLayout pipelineLayout{};
+    bool bindless{};
     uint64 hash{};
     uint32 uses{};
 };
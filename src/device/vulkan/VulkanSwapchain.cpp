@@ -7,7 +7,50 @@
 namespace lucent
 {
 
-VulkanSwapchain::VulkanSwapchain(VulkanDevice* device)
+static VkPresentModeKHR PresentModeToVk(PresentMode mode)
+{
+    switch (mode)
+    {
+    case PresentMode::kFifo:
+        return VK_PRESENT_MODE_FIFO_KHR;
+
+    case PresentMode::kFifoRelaxed:
+        return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+
+    case PresentMode::kMailbox:
+        return VK_PRESENT_MODE_MAILBOX_KHR;
+
+    case PresentMode::kImmediate:
+        return VK_PRESENT_MODE_IMMEDIATE_KHR;
+
+    default:
+        LC_ASSERT(0 && "Invalid present mode");
+        return VK_PRESENT_MODE_FIFO_KHR;
+    }
+}
+
+static const char* GetPresentModeName(VkPresentModeKHR mode)
+{
+    switch (mode)
+    {
+    case VK_PRESENT_MODE_FIFO_KHR:
+        return "FIFO";
+
+    case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+        return "FIFO relaxed";
+
+    case VK_PRESENT_MODE_MAILBOX_KHR:
+        return "mailbox";
+
+    case VK_PRESENT_MODE_IMMEDIATE_KHR:
+        return "immediate";
+
+    default:
+        return "unknown";
+    }
+}
+
+VulkanSwapchain::VulkanSwapchain(VulkanDevice* device, const SwapchainSettings& settings)
     : m_Device(device)
 {
     LC_INFO("Creating new swapchain");
@@ -35,8 +78,22 @@ VulkanSwapchain::VulkanSwapchain(VulkanDevice* device)
         }
     }
 
-    // Choose suitable present mode
-    VkPresentModeKHR chosenPresentMode = VK_PRESENT_MODE_FIFO_KHR;
+    // Choose requested present mode if supported, FIFO is always available
+    std::vector<VkPresentModeKHR> presentModes;
+    uint32 presentModeCount = 0;
+    vkGetPhysicalDeviceSurfacePresentModesKHR(device->m_PhysicalDevice, device->m_Surface, &presentModeCount, nullptr);
+    presentModes.resize(presentModeCount);
+    vkGetPhysicalDeviceSurfacePresentModesKHR(device->m_PhysicalDevice,
+        device->m_Surface,
+        &presentModeCount,
+        presentModes.data());
+
+    VkPresentModeKHR chosenPresentMode = PresentModeToVk(settings.presentMode);
+    if (std::find(presentModes.begin(), presentModes.end(), chosenPresentMode) == presentModes.end())
+    {
+        LC_WARN("Present mode {} is not supported by the surface, using FIFO", GetPresentModeName(chosenPresentMode));
+        chosenPresentMode = VK_PRESENT_MODE_FIFO_KHR;
+    }
 
     // Choose suitable extent
     VkExtent2D chosenExtent = surfaceCapabilities.currentExtent;
@@ -54,7 +111,14 @@ VulkanSwapchain::VulkanSwapchain(VulkanDevice* device)
         chosenExtent.height = std::clamp(chosenExtent.height, min.height, max.height);
     }
 
-    auto chosenImageCount = surfaceCapabilities.minImageCount + 1;
+    // A maximum of 0 means there is no limit
+    auto chosenImageCount = settings.imageCount > 0 ? settings.imageCount : surfaceCapabilities.minImageCount + 1;
+    chosenImageCount = Max(chosenImageCount, surfaceCapabilities.minImageCount);
+    if (surfaceCapabilities.maxImageCount > 0)
+        chosenImageCount = Min(chosenImageCount, surfaceCapabilities.maxImageCount);
+
+    LC_INFO("Swapchain: {}x{}, {} images, present mode {}", chosenExtent.width, chosenExtent.height,
+        chosenImageCount, GetPresentModeName(chosenPresentMode));
 
     auto sharedQueue = device->m_GraphicsQueue.familyIndex == device->m_PresentQueue.familyIndex;
     uint32 queueIndices[] = { device->m_GraphicsQueue.familyIndex, device->m_PresentQueue.familyIndex };
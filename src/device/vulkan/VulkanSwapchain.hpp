@@ -2,6 +2,7 @@
 
 #include "VulkanCommon.hpp"
 #include "VulkanTexture.hpp"
+#include "device/Device.hpp"
 
 namespace lucent
 {
@@ -9,7 +10,7 @@ namespace lucent
 class VulkanSwapchain
 {
 public:
-    explicit VulkanSwapchain(VulkanDevice* device);
+    VulkanSwapchain(VulkanDevice* device, const SwapchainSettings& settings);
     ~VulkanSwapchain();
 
     Texture* AcquireImage(uint32 frame);
@@ -1,12 +1,12 @@
 #include "VulkanTexture.hpp"
 
 #include "device/vulkan/VulkanDevice.hpp"
-#include "device/vulkan/VulkanContext.hpp"
+#include "device/vulkan/VulkanUploader.hpp"
 
 namespace lucent
 {
 
-static VkFormat TextureFormatToVkFormat(TextureFormat format)
+VkFormat TextureFormatToVkFormat(TextureFormat format)
 {
     switch (format)
     {
@@ -28,6 +28,27 @@ static VkFormat TextureFormatToVkFormat(TextureFormat format)
     case TextureFormat::kRGB10A2:
         return VK_FORMAT_A2R10G10B10_UNORM_PACK32;
 
+    case TextureFormat::kR16U:
+        return VK_FORMAT_R16_UNORM;
+
+    case TextureFormat::kRG16U:
+        return VK_FORMAT_R16G16_UNORM;
+
+    case TextureFormat::kRGBA16U:
+        return VK_FORMAT_R16G16B16A16_UNORM;
+
+    case TextureFormat::kR16F:
+        return VK_FORMAT_R16_SFLOAT;
+
+    case TextureFormat::kRG16F:
+        return VK_FORMAT_R16G16_SFLOAT;
+
+    case TextureFormat::kRGBA16F:
+        return VK_FORMAT_R16G16B16A16_SFLOAT;
+
+    case TextureFormat::kR11G11B10F:
+        return VK_FORMAT_B10G11R11_UFLOAT_PACK32;
+
     case TextureFormat::kR32F:
         return VK_FORMAT_R32_SFLOAT;
 
@@ -154,9 +175,38 @@ VulkanTexture::VulkanTexture(VulkanDevice* dev,
     VkImage existingImage,
     VkFormat existingFormat)
     : device(dev)
+{
+    Init(info, existingFormat);
+
+    // Create image
+    image = existingImage;
+    if (image == VK_NULL_HANDLE)
+    {
+        auto imageInfo = GetImageInfo();
+        auto allocInfo = VmaAllocationCreateInfo{
+            .usage = VMA_MEMORY_USAGE_GPU_ONLY
+        };
+        LC_CHECK(vmaCreateImage(device->GetAllocator(), &imageInfo, &allocInfo, &image, &alloc, nullptr));
+    }
+
+    CreateViews();
+    InitializeLayout();
+}
+
+VulkanTexture::VulkanTexture(VulkanDevice* dev, const TextureSettings& info, DeferMemory)
+    : device(dev)
+    , transient(true)
+{
+    Init(info, VK_FORMAT_UNDEFINED);
+
+    // Views can only be created once memory is bound
+    auto imageInfo = GetImageInfo();
+    LC_CHECK(vkCreateImage(device->GetHandle(), &imageInfo, nullptr, &image));
+}
+
+void VulkanTexture::Init(const TextureSettings& info, VkFormat existingFormat)
 {
     m_Settings = info;
-    auto deviceHandle = device->GetHandle();
 
     format = (existingFormat != VK_FORMAT_UNDEFINED) ? existingFormat : TextureFormatToVkFormat(info.format);
     aspect = TextureFormatToAspect(info.format);
@@ -166,8 +216,7 @@ VulkanTexture::VulkanTexture(VulkanDevice* dev,
     LC_ASSERT(info.samples > 0 && info.samples <= 64);
     samples = static_cast<VkSampleCountFlagBits>(info.samples);
 
-    VkFlags flags = 0;
-    uint32 arrayLayers = info.layers;
+    arrayLayers = info.layers;
     if (info.shape == TextureShape::kCube)
     {
         arrayLayers = 6;
@@ -176,53 +225,75 @@ VulkanTexture::VulkanTexture(VulkanDevice* dev,
         LC_ASSERT(info.width == info.height);
     }
 
-    // Override specified levels if generating mip chain
+    // Override specified levels if generating mip chain, so views and mip generation cover the whole chain
     levels = info.levels;
     if (info.generateMips)
     {
         levels = (uint32)Floor(Log2((float)Max(info.width, info.height))) + 1;
+        m_Settings.levels = levels;
     }
 
-    // Create image
-    image = existingImage;
-    if (image == VK_NULL_HANDLE)
-    {
-        auto imageInfo = VkImageCreateInfo{
-            .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
-            .flags = flags,
-            .imageType = VK_IMAGE_TYPE_2D,
-            .format = format,
-            .extent = {
-                .width = info.width,
-                .height = info.height,
-                .depth = 1
-            },
-            .mipLevels = levels,
-            .arrayLayers = arrayLayers,
-            .samples = samples,
-            .tiling = VK_IMAGE_TILING_OPTIMAL,
-            .usage = TextureUsageToVkUsage(info.usage),
-            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
-            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
-        };
+    // Create sampler
+    auto filter = TextureFilterToVk(info.filter);
+    auto addressMode = TextureAddressModeToVk(info.addressMode);
+    auto samplerInfo = VkSamplerCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .magFilter = filter,
+        .minFilter = filter,
+        .mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR,
+        .addressModeU = addressMode,
+        .addressModeV = addressMode,
+        .addressModeW = addressMode,
+        .mipLodBias = 0,
+        .anisotropyEnable = VK_TRUE,
+        .maxAnisotropy = device->GetLimits().maxSamplerAnisotropy,
+        .compareEnable = VK_FALSE,
+        .compareOp = VK_COMPARE_OP_ALWAYS,
+        .minLod = 0.0f,
+        .maxLod = VK_LOD_CLAMP_NONE,
+        .borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_BLACK,
+        .unnormalizedCoordinates = VK_FALSE
+    };
+    LC_CHECK(vkCreateSampler(device->GetHandle(), &samplerInfo, nullptr, &sampler));
+}
 
-        auto allocInfo = VmaAllocationCreateInfo{
-            .usage = VMA_MEMORY_USAGE_GPU_ONLY
-        };
-        LC_CHECK(vmaCreateImage(device->GetAllocator(), &imageInfo, &allocInfo, &image, &alloc, nullptr));
-    }
+VkImageCreateInfo VulkanTexture::GetImageInfo() const
+{
+    return VkImageCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .flags = flags,
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = format,
+        .extent = {
+            .width = extent.width,
+            .height = extent.height,
+            .depth = 1
+        },
+        .mipLevels = levels,
+        .arrayLayers = arrayLayers,
+        .samples = samples,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = TextureUsageToVkUsage(m_Settings.usage),
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
+    };
+}
+
+void VulkanTexture::CreateViews()
+{
+    auto deviceHandle = device->GetHandle();
 
     // Create image view
     auto viewInfo = VkImageViewCreateInfo{
         .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
         .image = image,
-        .viewType = TextureShapeToViewType(info.shape),
+        .viewType = TextureShapeToViewType(m_Settings.shape),
         .format = format,
         .components = {},
         .subresourceRange = {
             .aspectMask = aspect,
             .baseMipLevel = 0,
-            .levelCount = info.levels,
+            .levelCount = m_Settings.levels,
             .baseArrayLayer = 0,
             .layerCount = arrayLayers
         }
@@ -245,69 +316,68 @@ VulkanTexture::VulkanTexture(VulkanDevice* dev,
             mipViews.push_back(view);
         }
     }
+}
 
-    // Create sampler
-    auto filter = TextureFilterToVk(info.filter);
-    auto addressMode = TextureAddressModeToVk(info.addressMode);
-    auto samplerInfo = VkSamplerCreateInfo{
-        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
-        .magFilter = filter,
-        .minFilter = filter,
-        .mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR,
-        .addressModeU = addressMode,
-        .addressModeV = addressMode,
-        .addressModeW = addressMode,
-        .mipLodBias = 0,
-        .anisotropyEnable = VK_TRUE,
-        .maxAnisotropy = device->GetLimits().maxSamplerAnisotropy,
-        .compareEnable = VK_FALSE,
-        .compareOp = VK_COMPARE_OP_ALWAYS,
-        .minLod = 0.0f,
-        .maxLod = VK_LOD_CLAMP_NONE,
-        .borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_BLACK,
-        .unnormalizedCoordinates = VK_FALSE
-    };
-    LC_CHECK(vkCreateSampler(deviceHandle, &samplerInfo, nullptr, &sampler));
+void VulkanTexture::InitializeLayout()
+{
+    sync = VulkanSyncState{ .layout = GetStartingLayout() };
 
     // Transition image to starting layout
-    if (auto startLayout = GetStartingLayout(); startLayout != VK_IMAGE_LAYOUT_UNDEFINED)
+    if (GetStartingLayout() != VK_IMAGE_LAYOUT_UNDEFINED)
     {
-        device->m_OneShotContext->Begin();
-
-        auto imgBarrier = VkImageMemoryBarrier{
-            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-            .srcAccessMask = VK_ACCESS_NONE_KHR,
-            .dstAccessMask = VK_ACCESS_NONE_KHR,
-            .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-            .newLayout = startLayout,
-            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-            .image = image,
-            .subresourceRange = {
-                .aspectMask = aspect,
-                .baseMipLevel = 0,
-                .levelCount = VK_REMAINING_MIP_LEVELS,
-                .baseArrayLayer = 0,
-                .layerCount = VK_REMAINING_ARRAY_LAYERS
-            }
-        };
-        vkCmdPipelineBarrier(device->m_OneShotContext->m_CommandBuffer,
-            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-            VK_DEPENDENCY_BY_REGION_BIT,
-            0,
-            nullptr,
-            0,
-            nullptr,
-            1,
-            &imgBarrier);
-
-        device->m_OneShotContext->End();
-        device->Submit(device->m_OneShotContext);
+        // Submitted separately from the commands using the texture, so its first use must wait on all prior work
+        sync.writeStages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+        // Batched with uploads, an upload before the batch is submitted makes the transition itself
+        device->GetUploader().InitializeLayout(this);
     }
 }
 
-VulkanTexture::~VulkanTexture()
+void VulkanTexture::BindMemory(VulkanTransientBlock* block, VkDeviceSize offset)
+{
+    LC_ASSERT(transient && !transientBlock);
+
+    LC_CHECK(vmaBindImageMemory2(device->GetAllocator(), block->alloc, offset, image, nullptr));
+    transientBlock = block;
+    ++block->references;
+
+    CreateViews();
+    InitializeLayout();
+}
+
+void VulkanTexture::Resize(uint32 width, uint32 height)
+{
+    LC_ASSERT(!transient && m_Settings.usage != TextureUsage::kPresentSrc);
+
+    // Commands in flight may still sample the old image, so it is destroyed once they complete
+    device->DeferRelease([device = device, image = image, alloc = alloc, imageView = imageView, sampler = sampler,
+        mipViews = std::move(mipViews)]()
+    {
+        vkDestroyImageView(device->GetHandle(), imageView, nullptr);
+        vkDestroySampler(device->GetHandle(), sampler, nullptr);
+        for (auto view : mipViews)
+            vkDestroyImageView(device->GetHandle(), view, nullptr);
+
+        vmaDestroyImage(device->GetAllocator(), image, alloc);
+    });
+    mipViews.clear();
+
+    auto settings = m_Settings;
+    settings.width = width;
+    settings.height = height;
+    Init(settings, format);
+
+    auto imageInfo = GetImageInfo();
+    auto allocInfo = VmaAllocationCreateInfo{
+        .usage = VMA_MEMORY_USAGE_GPU_ONLY
+    };
+    LC_CHECK(vmaCreateImage(device->GetAllocator(), &imageInfo, &allocInfo, &image, &alloc, nullptr));
+
+    CreateViews();
+    InitializeLayout();
+}
+
+void VulkanTexture::DestroyViews()
 {
     vkDestroyImageView(device->GetHandle(), imageView, nullptr);
     vkDestroySampler(device->GetHandle(), sampler, nullptr);
@@ -316,8 +386,20 @@ VulkanTexture::~VulkanTexture()
     {
         vkDestroyImageView(device->GetHandle(), view, nullptr);
     }
+    mipViews.clear();
+}
+
+VulkanTexture::~VulkanTexture()
+{
+    DestroyViews();
 
-    if (m_Settings.usage != TextureUsage::kPresentSrc)
+    if (transient)
+    {
+        vkDestroyImage(device->GetHandle(), image, nullptr);
+        if (transientBlock)
+            device->ReleaseTransientBlock(transientBlock);
+    }
+    else if (m_Settings.usage != TextureUsage::kPresentSrc)
     {
         vmaDestroyImage(device->GetAllocator(), image, alloc);
     }
@@ -325,20 +407,7 @@ VulkanTexture::~VulkanTexture()
 
 void VulkanTexture::Upload(size_t size, const void* data)
 {
-    auto& settings = GetSettings();
-
-    auto& ctx = *device->m_OneShotContext;
-    auto buffer = device->m_TransferBuffer;
-    buffer->Upload(data, size, 0);
-
-    ctx.Begin();
-    ctx.CopyTexture(buffer, 0, this, 0, 0, settings.width, settings.height);
-
-    if (settings.generateMips)
-        ctx.GenerateMips(this);
-
-    ctx.End();
-    device->Submit(&ctx);
+    device->GetUploader().Upload(this, data, size);
 }
 
 VkImageLayout VulkanTexture::GetStartingLayout() const
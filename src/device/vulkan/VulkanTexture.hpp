@@ -6,6 +6,13 @@
 namespace lucent
 {
 
+//! Device memory shared between transient textures, freed when the last texture using it is destroyed
+struct VulkanTransientBlock
+{
+    VmaAllocation alloc;
+    uint32 references;
+};
+
 struct VulkanTexture : public Texture
 {
 public:
@@ -14,15 +21,33 @@ public:
         VkImage existingImage = VK_NULL_HANDLE,
         VkFormat existingFormat = VK_FORMAT_UNDEFINED);
 
+    //! Creates a texture without memory, which must be bound with BindMemory before use
+    struct DeferMemory {};
+    VulkanTexture(VulkanDevice* device, const TextureSettings& settings, DeferMemory);
+
     ~VulkanTexture();
 
     void Upload(size_t size, const void* data) override;
 
+    void BindMemory(VulkanTransientBlock* block, VkDeviceSize offset);
+
+    //! Replaces the image with an uninitialized one of a new size, recreating its views
+    //! The old image and views are released once commands in flight have completed.
+    void Resize(uint32 width, uint32 height);
+    bool IsResident() const { return imageView != VK_NULL_HANDLE; }
+
     VkImageLayout GetStartingLayout() const;
 
     void SyncSrc(VkPipelineStageFlags& stage, VkAccessFlags& access, VkImageLayout& layout) const;
     void SyncDst(VkPipelineStageFlags& stage, VkAccessFlags& access, VkImageLayout& layout) const;
 
+private:
+    void Init(const TextureSettings& settings, VkFormat existingFormat);
+    VkImageCreateInfo GetImageInfo() const;
+    void CreateViews();
+    void DestroyViews();
+    void InitializeLayout();
+
 public:
     VulkanDevice* device;
     VkImage image{};
@@ -30,12 +55,25 @@ public:
     std::vector<VkImageView> mipViews;
     VkSampler sampler{};
     VmaAllocation alloc{};
+    VulkanTransientBlock* transientBlock{};
+    bool transient = false;
+
+    // Index in the device's global texture array, if the texture has been added to it
+    static constexpr uint32 kNoBindlessIndex = ~0u;
+    uint32 bindlessIndex = kNoBindlessIndex;
+
+    // Updated as commands using the texture are recorded
+    mutable VulkanSyncState sync;
 
     uint32 levels;
     VkSampleCountFlagBits samples;
     VkFormat format;
     VkExtent2D extent{};
     VkImageAspectFlags aspect;
+    uint32 arrayLayers;
+    VkImageCreateFlags flags{};
 };
 
+VkFormat TextureFormatToVkFormat(TextureFormat format);
+
 }
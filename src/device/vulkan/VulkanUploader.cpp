@@ -0,0 +1,419 @@
+#include "VulkanUploader.hpp"
+
+#include "device/vulkan/VulkanBuffer.hpp"
+#include "device/vulkan/VulkanContext.hpp"
+#include "device/vulkan/VulkanDevice.hpp"
+#include "device/vulkan/VulkanTexture.hpp"
+
+#include <numeric>
+
+namespace lucent
+{
+
+// Stages which read data acquired from the transfer queue, the only ones graphics commands are held back at until the
+// transfers complete. Textures uploaded with mips also have the rest of their levels blitted.
+static constexpr VkPipelineStageFlags kBufferConsumerStages = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+    VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+static constexpr VkPipelineStageFlags kTextureConsumerStages = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+    VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+static void RecordInitialLayout(VkCommandBuffer commandBuffer, const VulkanTexture* texture)
+{
+    auto barrier = VkImageMemoryBarrier{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_NONE_KHR,
+        .dstAccessMask = VK_ACCESS_NONE_KHR,
+        .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .newLayout = texture->GetStartingLayout(),
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = texture->image,
+        .subresourceRange = {
+            .aspectMask = texture->aspect,
+            .baseMipLevel = 0,
+            .levelCount = VK_REMAINING_MIP_LEVELS,
+            .baseArrayLayer = 0,
+            .layerCount = VK_REMAINING_ARRAY_LAYERS
+        }
+    };
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+        VK_DEPENDENCY_BY_REGION_BIT, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+VulkanUploader::VulkanUploader(VulkanDevice& device, VkDeviceSize stagingSize)
+    : m_Device(device)
+    , m_GraphicsFamily(device.m_GraphicsQueue.familyIndex)
+    , m_StagingSize(stagingSize)
+{
+    if (device.m_TransferQueue.handle)
+    {
+        m_TransferQueue = device.m_TransferQueue.handle;
+        m_TransferFamily = device.m_TransferQueue.familyIndex;
+    }
+
+    m_Staging = Get(device.CreateBuffer(BufferType::kStaging, stagingSize));
+    m_StagingData = static_cast<uint8*>(m_Staging->Map());
+
+    for (auto& batch: m_Batches)
+    {
+        batch.context = std::make_unique<VulkanContext>(device);
+
+        if (!UsesTransferQueue())
+            continue;
+
+        auto poolInfo = VkCommandPoolCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+            .queueFamilyIndex = m_TransferFamily
+        };
+        LC_CHECK(vkCreateCommandPool(device.GetHandle(), &poolInfo, nullptr, &batch.transferPool));
+
+        auto allocInfo = VkCommandBufferAllocateInfo{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = batch.transferPool,
+            .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = 1
+        };
+        LC_CHECK(vkAllocateCommandBuffers(device.GetHandle(), &allocInfo, &batch.transferCommands));
+
+        auto semaphoreInfo = VkSemaphoreCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO
+        };
+        LC_CHECK(vkCreateSemaphore(device.GetHandle(), &semaphoreInfo, nullptr, &batch.transferDone));
+    }
+}
+
+VulkanUploader::~VulkanUploader()
+{
+    for (auto& batch: m_Batches)
+    {
+        Retire(batch);
+
+        if (batch.transferPool)
+        {
+            vkDestroySemaphore(m_Device.GetHandle(), batch.transferDone, nullptr);
+            vkDestroyCommandPool(m_Device.GetHandle(), batch.transferPool, nullptr);
+        }
+        batch.context.reset();
+    }
+    m_Device.DestroyBuffer(m_Staging);
+}
+
+void VulkanUploader::Upload(VulkanBuffer* buffer, const void* data, size_t size, size_t offset)
+{
+    LC_ASSERT(offset + size <= buffer->capacity);
+    if (size == 0)
+        return;
+
+    auto[staging, stagingOffset] = Stage(data, size, 4);
+    auto& batch = BeginBatch();
+    auto graphicsCommands = batch.context->m_CommandBuffer;
+
+    auto copy = VkBufferCopy{
+        .srcOffset = stagingOffset,
+        .dstOffset = offset,
+        .size = size
+    };
+
+    if (!UsesTransferQueue())
+    {
+        // Wait once per batch on earlier commands which may still use the buffers being written
+        if (!batch.recordedGraphicsCopy)
+        {
+            auto barrier = VkMemoryBarrier{
+                .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                .srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT,
+                .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT
+            };
+            vkCmdPipelineBarrier(graphicsCommands, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                0, 1, &barrier, 0, nullptr, 0, nullptr);
+            batch.recordedGraphicsCopy = true;
+        }
+        vkCmdCopyBuffer(graphicsCommands, staging->handle, buffer->handle, 1, &copy);
+        return;
+    }
+
+    BeginTransfer(batch);
+    vkCmdCopyBuffer(batch.transferCommands, staging->handle, buffer->handle, 1, &copy);
+
+    // Release the range to the graphics queue, which must acquire it with a matching barrier
+    auto barrier = VkBufferMemoryBarrier{
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_NONE_KHR,
+        .srcQueueFamilyIndex = m_TransferFamily,
+        .dstQueueFamilyIndex = m_GraphicsFamily,
+        .buffer = buffer->handle,
+        .offset = offset,
+        .size = size
+    };
+    vkCmdPipelineBarrier(batch.transferCommands, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+    // The acquire starts at the stages the submission waits on the transfer at, to chain after it
+    barrier.srcAccessMask = VK_ACCESS_NONE_KHR;
+    barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+    vkCmdPipelineBarrier(graphicsCommands, kBufferConsumerStages, kBufferConsumerStages,
+        0, 0, nullptr, 1, &barrier, 0, nullptr);
+}
+
+void VulkanUploader::Upload(VulkanTexture* texture, const void* data, size_t size)
+{
+    auto& settings = texture->GetSettings();
+    LC_ASSERT(texture->GetStartingLayout() != VK_IMAGE_LAYOUT_UNDEFINED);
+
+    // Copies from a buffer must start on a multiple of both the texel size and 4 bytes
+    auto texelSize = Max<size_t>(size / (settings.width * settings.height), 1);
+    auto[staging, stagingOffset] = Stage(data, size, std::lcm<size_t>(texelSize, 4));
+
+    auto& batch = BeginBatch();
+    auto& ctx = *batch.context;
+
+    // A texture whose initial layout transition is still pending has never been used by the graphics queue, so can be
+    // written by the transfer queue without first releasing it
+    auto pending = std::find(batch.pendingLayouts.begin(), batch.pendingLayouts.end(), texture);
+    bool unused = pending != batch.pendingLayouts.end();
+    if (unused)
+        batch.pendingLayouts.erase(pending);
+
+    if (!unused || !UsesTransferQueue())
+    {
+        if (unused)
+            RecordInitialLayout(ctx.m_CommandBuffer, texture);
+
+        ctx.CopyTexture(staging, static_cast<uint32>(stagingOffset), texture, 0, 0, settings.width, settings.height);
+        if (settings.generateMips)
+            ctx.GenerateMips(texture);
+        return;
+    }
+
+    BeginTransfer(batch);
+
+    auto barrier = VkImageMemoryBarrier{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_NONE_KHR,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = texture->image,
+        .subresourceRange = {
+            .aspectMask = texture->aspect,
+            .baseMipLevel = 0,
+            .levelCount = VK_REMAINING_MIP_LEVELS,
+            .baseArrayLayer = 0,
+            .layerCount = VK_REMAINING_ARRAY_LAYERS
+        }
+    };
+    vkCmdPipelineBarrier(batch.transferCommands, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    auto copy = VkBufferImageCopy{
+        .bufferOffset = stagingOffset,
+        .bufferRowLength = 0,
+        .bufferImageHeight = 0,
+        .imageSubresource = {
+            .aspectMask = texture->aspect,
+            .mipLevel = 0,
+            .baseArrayLayer = 0,
+            .layerCount = 1
+        },
+        .imageOffset = {},
+        .imageExtent = { settings.width, settings.height, 1 }
+    };
+    vkCmdCopyBufferToImage(batch.transferCommands, staging->handle, texture->image,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy);
+
+    // Release to the graphics queue, transitioning to the starting layout which the acquire repeats
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_NONE_KHR;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = texture->GetStartingLayout();
+    barrier.srcQueueFamilyIndex = m_TransferFamily;
+    barrier.dstQueueFamilyIndex = m_GraphicsFamily;
+    vkCmdPipelineBarrier(batch.transferCommands, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    barrier.srcAccessMask = VK_ACCESS_NONE_KHR;
+    barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+    vkCmdPipelineBarrier(ctx.m_CommandBuffer, kTextureConsumerStages, kTextureConsumerStages,
+        0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    if (settings.generateMips)
+        ctx.GenerateMips(texture);
+}
+
+void VulkanUploader::InitializeLayout(VulkanTexture* texture)
+{
+    BeginBatch().pendingLayouts.push_back(texture);
+}
+
+void VulkanUploader::Forget(VulkanTexture* texture)
+{
+    for (auto& batch: m_Batches)
+        std::erase(batch.pendingLayouts, texture);
+}
+
+void VulkanUploader::Flush()
+{
+    auto& batch = m_Batches[m_CurrentBatch];
+    if (!batch.recording)
+        return;
+
+    auto& ctx = *batch.context;
+
+    for (auto texture: batch.pendingLayouts)
+        RecordInitialLayout(ctx.m_CommandBuffer, texture);
+    batch.pendingLayouts.clear();
+
+    // Vertex and index reads aren't tracked by contexts, so copies are made visible to all later commands
+    if (batch.recordedGraphicsCopy)
+    {
+        auto barrier = VkMemoryBarrier{
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT
+        };
+        vkCmdPipelineBarrier(ctx.m_CommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+    ctx.End();
+
+    // Only the acquires wait on the transfer, so frame commands at other stages aren't held back by uploads
+    VkPipelineStageFlags waitStage = kBufferConsumerStages | kTextureConsumerStages;
+    auto submitInfo = VkSubmitInfo{
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .commandBufferCount = 1,
+        .pCommandBuffers = &ctx.m_CommandBuffer
+    };
+
+    // Submitted directly rather than through the device, which would wait on the swapchain for frame commands
+    if (batch.recordedTransfer)
+    {
+        LC_CHECK(vkEndCommandBuffer(batch.transferCommands));
+
+        auto transferInfo = VkSubmitInfo{
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .commandBufferCount = 1,
+            .pCommandBuffers = &batch.transferCommands,
+            .signalSemaphoreCount = 1,
+            .pSignalSemaphores = &batch.transferDone
+        };
+        LC_CHECK(vkQueueSubmit(m_TransferQueue, 1, &transferInfo, VK_NULL_HANDLE));
+
+        submitInfo.waitSemaphoreCount = 1;
+        submitInfo.pWaitSemaphores = &batch.transferDone;
+        submitInfo.pWaitDstStageMask = &waitStage;
+    }
+    LC_CHECK(vkQueueSubmit(m_Device.m_GraphicsQueue.handle, 1, &submitInfo, ctx.m_ReadyFence));
+
+    batch.ringEnd = m_RingHead;
+    batch.recording = false;
+    batch.recordedTransfer = false;
+    batch.recordedGraphicsCopy = false;
+    batch.submitted = true;
+
+    m_CurrentBatch = (m_CurrentBatch + 1) % kNumBatches;
+}
+
+VulkanUploader::Batch& VulkanUploader::BeginBatch()
+{
+    auto& batch = m_Batches[m_CurrentBatch];
+    if (batch.recording)
+        return batch;
+
+    Retire(batch);
+    batch.context->Begin();
+    batch.recording = true;
+
+    return batch;
+}
+
+void VulkanUploader::BeginTransfer(Batch& batch)
+{
+    if (batch.recordedTransfer)
+        return;
+
+    LC_CHECK(vkResetCommandPool(m_Device.GetHandle(), batch.transferPool, 0));
+
+    auto beginInfo = VkCommandBufferBeginInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+    };
+    LC_CHECK(vkBeginCommandBuffer(batch.transferCommands, &beginInfo));
+    batch.recordedTransfer = true;
+}
+
+void VulkanUploader::Retire(Batch& batch)
+{
+    if (batch.submitted)
+    {
+        vkWaitForFences(m_Device.GetHandle(), 1, &batch.context->m_ReadyFence, VK_TRUE, UINT64_MAX);
+        m_RingTail = Max(m_RingTail, batch.ringEnd);
+        batch.submitted = false;
+    }
+
+    for (auto buffer: batch.temporaryBuffers)
+        m_Device.DestroyBuffer(buffer);
+    batch.temporaryBuffers.clear();
+}
+
+bool VulkanUploader::RetireOldest()
+{
+    // Batches are submitted in slot order, so the oldest is the current slot unless it is recording, in which case it
+    // is the one after. Retiring strictly in submission order keeps the ring tail behind every batch still in flight.
+    for (uint32 i = 0; i < kNumBatches; ++i)
+    {
+        auto& batch = m_Batches[(m_CurrentBatch + i) % kNumBatches];
+        if (batch.submitted)
+        {
+            Retire(batch);
+            return true;
+        }
+    }
+    return false;
+}
+
+std::pair<VulkanBuffer*, VkDeviceSize> VulkanUploader::Stage(const void* data, size_t size, size_t alignment)
+{
+    // Data larger than the whole ring gets its own buffer, destroyed once the batch completes
+    if (size > m_StagingSize)
+    {
+        auto buffer = Get(m_Device.CreateBuffer(BufferType::kStaging, size));
+        buffer->Upload(data, size, 0);
+        BeginBatch().temporaryBuffers.push_back(buffer);
+
+        return { buffer, 0 };
+    }
+
+    // Allocations never straddle the end of the buffer
+    uint64 position = (m_RingHead + alignment - 1) / alignment * alignment;
+    if (position % m_StagingSize + size > m_StagingSize)
+        position = (position / m_StagingSize + 1) * m_StagingSize;
+
+    // Wait for batches reading the ring until the allocation fits, submitting the current one if it is in the way
+    while (position + size - m_RingTail > m_StagingSize)
+    {
+        if (m_RingTail == m_RingHead)
+        {
+            m_RingTail = position;
+            break;
+        }
+
+        if (!RetireOldest())
+        {
+            LC_ASSERT(m_Batches[m_CurrentBatch].recording);
+            Flush();
+        }
+    }
+
+    auto offset = position % m_StagingSize;
+    memcpy(m_StagingData + offset, data, size);
+    m_Staging->Flush(size, offset);
+    m_RingHead = position + size;
+
+    return { m_Staging, offset };
+}
+
+}
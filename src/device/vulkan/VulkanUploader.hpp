@@ -0,0 +1,85 @@
+#pragma once
+
+#include "VulkanCommon.hpp"
+
+namespace lucent
+{
+
+//! Copies data into device-local buffers and textures through a staging ring buffer
+//! Uploads are recorded into batches which are submitted together before the next submission of the device, or once
+//! the staging ring runs out of space. If the device has a queue dedicated to transfers, copies run on it alongside
+//! rendering and ownership of the written resources is released to the graphics queue, which acquires it (and
+//! generates mips) in a second command buffer waiting on the transfer.
+class VulkanUploader
+{
+public:
+    VulkanUploader(VulkanDevice& device, VkDeviceSize stagingSize);
+    ~VulkanUploader();
+
+    VulkanUploader(const VulkanUploader&) = delete;
+    VulkanUploader& operator=(const VulkanUploader&) = delete;
+
+    //! Ranges written through the transfer queue must not be in use by commands in flight
+    void Upload(VulkanBuffer* buffer, const void* data, size_t size, size_t offset);
+
+    //! Replaces the contents of the first level of a texture, generating the remaining levels if enabled
+    void Upload(VulkanTexture* texture, const void* data, size_t size);
+
+    //! Transitions a new texture to its starting layout with the next batch, unless an upload does so first
+    void InitializeLayout(VulkanTexture* texture);
+
+    //! Called before a texture is destroyed, so a pending layout transition doesn't reference it
+    void Forget(VulkanTexture* texture);
+
+    //! Submits the recorded batch, if any
+    void Flush();
+
+    bool UsesTransferQueue() const { return m_TransferQueue != VK_NULL_HANDLE; }
+
+private:
+    struct Batch
+    {
+        std::unique_ptr<VulkanContext> context; // Graphics queue commands, signals the batch's fence
+        VkCommandPool transferPool{};
+        VkCommandBuffer transferCommands{};
+        VkSemaphore transferDone{};
+
+        std::vector<VulkanTexture*> pendingLayouts;
+        std::vector<Buffer*> temporaryBuffers;
+        uint64 ringEnd = 0;
+
+        bool recording = false;
+        bool recordedTransfer = false;
+        bool recordedGraphicsCopy = false;
+        bool submitted = false;
+    };
+
+private:
+    Batch& BeginBatch();
+    void BeginTransfer(Batch& batch);
+    void Retire(Batch& batch);
+    bool RetireOldest();
+
+    // Returns a staging buffer and offset holding a copy of the data, from the ring if it fits
+    std::pair<VulkanBuffer*, VkDeviceSize> Stage(const void* data, size_t size, size_t alignment);
+
+private:
+    VulkanDevice& m_Device;
+
+    VkQueue m_TransferQueue{};
+    uint32 m_TransferFamily = 0;
+    uint32 m_GraphicsFamily = 0;
+
+    // Ring positions increase monotonically, wrapping around the buffer when taken modulo its size
+    VulkanBuffer* m_Staging;
+    uint8* m_StagingData;
+    VkDeviceSize m_StagingSize;
+    uint64 m_RingHead = 0;
+    uint64 m_RingTail = 0;
+
+    static constexpr uint32 kNumBatches = 4;
+    std::array<Batch, kNumBatches> m_Batches;
+    uint32 m_CurrentBatch = 0;
+};
+
+}
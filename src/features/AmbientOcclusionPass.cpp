@@ -12,25 +12,39 @@ Texture* AddGTAOPass(Renderer& renderer, GBuffer gBuffer, Texture* hiZ)
     uint32 width = settings.viewportWidth / 2;
     uint32 height = settings.viewportHeight / 2;
 
+    // Visibility is in [0, 1], so normalized 16-bit integers hold it as well as floats at half the size
+    bool packAO = !settings.fullPrecision && renderer.GetDevice()->SupportsStorageFormat(TextureFormat::kR16U);
+    auto aoFormat = packAO ? TextureFormat::kR16U : TextureFormat::kR32F;
+    auto aoFormatDefine = packAO ? "AO_FORMAT r16" : "AO_FORMAT r32f";
+
     auto aoResult = renderer.AddRenderTarget(TextureSettings{
-        .width = width, .height = height, .format = TextureFormat::kRG32F, .usage = TextureUsage::kReadWrite
+        .width = width, .height = height, .format = aoFormat, .usage = TextureUsage::kReadWrite
     });
 
     auto aoDenoised = renderer.AddRenderTarget(TextureSettings{
-        .width = width, .height = height, .format = TextureFormat::kR32F, .usage = TextureUsage::kReadWrite
+        .width = width, .height = height, .format = aoFormat, .usage = TextureUsage::kReadWrite
     });
 
+    std::vector<std::string_view> gtaoDefines = { aoFormatDefine };
+    if (gBuffer.compact)
+        gtaoDefines.emplace_back("COMPACT_GBUFFER");
+
     auto computeGTAO = renderer.AddPipeline(PipelineSettings{
         .shaderName = "GTAO.shader",
+        .shaderDefines = gtaoDefines,
         .type = PipelineType::kCompute
     });
 
     auto denoiseGTAO = renderer.AddPipeline(PipelineSettings{
         .shaderName = "GTAODenoise.shader",
+        .shaderDefines = { aoFormatDefine },
         .type = PipelineType::kCompute
     });
 
-    renderer.AddPass("Compute GTAO", [=, &settings](Context& ctx, View& view)
+    renderer.AddPass("Compute GTAO", PassResources{
+        .reads = { hiZ, gBuffer.normals },
+        .writes = { aoResult }
+    }, [=, &settings](Context& ctx, View& view)
     {
         ctx.BindPipeline(computeGTAO);
         view.BindUniforms(ctx);
@@ -45,7 +59,10 @@ Texture* AddGTAOPass(Renderer& renderer, GBuffer gBuffer, Texture* hiZ)
         ctx.Dispatch(numX, numY, 1);
     });
 
-    renderer.AddPass("Denoise GTAO", [=, &settings](Context& ctx, View& view)
+    renderer.AddPass("Denoise GTAO", PassResources{
+        .reads = { aoResult },
+        .writes = { aoDenoised }
+    }, [=, &settings](Context& ctx, View& view)
     {
         ctx.BindPipeline(denoiseGTAO);
 
@@ -23,17 +23,24 @@ void AddDebugOverlayPass(Renderer& renderer, DebugConsole* console, Texture* out
         . depthTestEnable = false, .depthWriteEnable = false
     });
 
-    auto debugShapes = (DebugShapeBuffer*)renderer.GetDebugShapesBuffer()->Map();
     auto sphere = settings.sphereMesh.get();
 
-    renderer.AddPass("Debug overlay", [=](Context& ctx, View& view)
+    renderer.AddPass("Debug overlay", PassResources{
+        .reads = { output },
+        .writes = { output }
+    }, [=, &renderer](Context& ctx, View& view)
     {
-        ctx.GetDevice()->WaitIdle();
+        // Shapes were written by the last frame to use this frame's buffer, which has completed, so no wait is needed
+        auto buffer = renderer.GetDebugShapesBuffer();
+        auto debugShapes = (DebugShapeBuffer*)buffer->Map();
+        buffer->Invalidate(sizeof(DebugShapeBuffer), 0);
 
         ctx.BeginRenderPass(overlayFramebuffer);
 
         ctx.BindPipeline(debugShapeShader);
-        for (int i = 0; i < debugShapes->numShapes; ++i)
+        sphere->Bind(ctx);
+        auto numShapes = Min(debugShapes->numShapes, kMaxDebugShapes);
+        for (uint32 i = 0; i < numShapes; ++i)
         {
             auto& shape = debugShapes->shapes[i];
 
@@ -44,9 +51,7 @@ void AddDebugOverlayPass(Renderer& renderer, DebugConsole* console, Texture* out
             ctx.Uniform("u_MVP"_id, mvp);
             ctx.Uniform("u_Color"_id, shape.color);
 
-            ctx.BindBuffer(sphere->vertexBuffer);
-            ctx.BindBuffer(sphere->indexBuffer);
-            ctx.Draw(sphere->numIndices);
+            sphere->Draw(ctx);
         }
 
         ctx.BindPipeline(debugTextShader);
@@ -55,6 +60,7 @@ void AddDebugOverlayPass(Renderer& renderer, DebugConsole* console, Texture* out
         ctx.EndRenderPass();
 
         debugShapes->numShapes = 0;
+        buffer->Flush(sizeof(uint32), 0);
     });
 }
 
@@ -1,19 +1,93 @@
 #include "GeometryPass.hpp"
 
 #include "device/Context.hpp"
+#include "rendering/Culling.hpp"
+#include "rendering/IndirectDrawList.hpp"
 #include "rendering/Material.hpp"
+#include "rendering/MaterialTable.hpp"
 #include "scene/Camera.hpp"
-#include "scene/ModelInstance.hpp"
-#include "scene/Transform.hpp"
 
 namespace lucent
 {
 
-GBuffer AddGeometryPass(Renderer& renderer)
+// Draws are split between recording threads once there are enough to outweigh the cost of a secondary command buffer
+static constexpr uint32 kMinDrawsPerTask = 128;
+static constexpr uint32 kMinBatchesPerTask = 32;
+
+static Texture* AddHiZTarget(Renderer& renderer, Texture* depthTexture)
+{
+    auto[baseWidth, baseHeight] = depthTexture->GetSize();
+
+    auto levels = (uint32)Floor(Log2((float)Max(baseWidth, baseHeight))) + 1;
+
+    return renderer.AddRenderTarget(TextureSettings{
+        .width = baseWidth, .height = baseHeight,
+        .levels = levels,
+        .format = TextureFormat::kR32F,
+        .addressMode = TextureAddressMode::kClampToEdge,
+        .filter = TextureFilter::kNearest,
+        .usage = TextureUsage::kReadWrite
+    });
+}
+
+// Builds a pyramid of the nearest depth in each texel, or the farthest if used to test for occlusion
+static void AddHiZPass(Renderer& renderer, const char* label, Texture* depthTexture, Texture* hiZ, bool farthest)
 {
     auto& settings = renderer.GetSettings();
 
-    GBuffer gBuffer{};
+    auto[baseWidth, baseHeight] = depthTexture->GetSize();
+
+    std::vector<std::string_view> defines;
+    if (farthest)
+        defines.emplace_back("FARTHEST_DEPTH");
+
+    auto generateHiZ = renderer.AddPipeline(PipelineSettings{
+        .shaderName = "GenerateHiZ.shader",
+        .shaderDefines = defines,
+        .type = PipelineType::kCompute
+    });
+
+    auto buffer = renderer.GetTransferBuffer();
+
+    renderer.AddPass(label, PassResources{
+        .reads = { depthTexture },
+        .writes = { hiZ }
+    }, [=, &settings](Context& ctx, View& view)
+    {
+        // Copy depth texture to level 0 of color mip pyramid
+        ctx.CopyTexture(depthTexture, 0, 0, buffer, 0, baseWidth, baseHeight);
+        ctx.CopyTexture(buffer, 0, hiZ, 0, 0, baseWidth, baseHeight);
+
+        // Progressively render to lower mip levels
+        ctx.BindPipeline(generateHiZ);
+        uint32 width = baseWidth;
+        uint32 height = baseHeight;
+
+        for (int level = 1; level < hiZ->GetSettings().levels; ++level)
+        {
+            width = Max(width / 2u, 1u);
+            height = Max(height / 2u, 1u);
+
+            // Only the nearest depth pyramid uses the offset, the farthest depth one covers the whole source level
+            auto offset = std::pair<int, int>(
+                width % 2 ? 2 : 1,
+                height % 2 ? 2 : 1);
+
+            ctx.BindTexture("u_Input"_id, hiZ, level - 1);
+            ctx.BindImage("u_Output"_id, hiZ, level);
+            ctx.Uniform("u_Offset"_id, offset);
+
+            auto[numX, numY] = settings.ComputeGroupCount(width, height);
+            ctx.Dispatch(numX, numY, 1);
+        }
+    });
+}
+
+GBuffer AddGeometryPass(Renderer& renderer, Texture* sceneRadiance)
+{
+    auto& settings = renderer.GetSettings();
+
+    GBuffer gBuffer{ .compact = settings.compactGBuffer };
 
     uint32 width = settings.viewportWidth;
     uint32 height = settings.viewportHeight;
@@ -24,114 +98,225 @@ GBuffer AddGeometryPass(Renderer& renderer)
     gBuffer.normals = renderer.AddRenderTarget(TextureSettings{
         .width = width, . height = height, .format = TextureFormat::kRGB10A2
     });
-    gBuffer.metalRoughness = renderer.AddRenderTarget(TextureSettings{
-        .width = width, .height = height, .format = TextureFormat::kRG8
-    });
     gBuffer.depth = renderer.AddRenderTarget(TextureSettings{
         .width = width, .height = height, .format = TextureFormat::kDepth32F,
         .usage = TextureUsage::kDepthAttachment
     });
-    gBuffer.emissive = renderer.AddRenderTarget(TextureSettings{
-        .width = width, .height = height, .format = TextureFormat::kRGBA32F
-    });
+
+    if (gBuffer.compact)
+    {
+        // Lighting is added to the emissive radiance, the clear leaves the rest of the scene black
+        gBuffer.emissive = sceneRadiance;
+    }
+    else
+    {
+        gBuffer.metalRoughness = renderer.AddRenderTarget(TextureSettings{
+            .width = width, .height = height, .format = TextureFormat::kRG8
+        });
+        // Emissive radiance is never negative and needs no alpha, so fits the packed unsigned float format
+        gBuffer.emissive = renderer.AddRenderTarget(TextureSettings{
+            .width = width, .height = height,
+            .format = settings.fullPrecision ? TextureFormat::kRGBA32F : TextureFormat::kR11G11B10F
+        });
+    }
+
+    Array<Texture*, kMaxColorAttachments> colorTextures = { gBuffer.baseColor, gBuffer.normals };
+    if (gBuffer.metalRoughness)
+        colorTextures.push_back(gBuffer.metalRoughness);
+    colorTextures.push_back(gBuffer.emissive);
 
     auto gFramebuffer = renderer.AddFramebuffer(FramebufferSettings{
-        .colorTextures = { gBuffer.baseColor, gBuffer.normals, gBuffer.metalRoughness, gBuffer.emissive },
+        .colorTextures = colorTextures,
         .depthTexture = gBuffer.depth
     });
 
+    // Materials are read from a table indexed per draw, so only the per-draw uniforms change between draws
+    auto device = renderer.GetDevice();
+    bool bindless = settings.bindlessTextures && device->SupportsBindlessTextures();
+    auto materials = bindless ? std::make_shared<MaterialTable>(device) : nullptr;
+
+    // Every mesh is drawn from the same vertex and index buffers, bound once per task
+    auto arena = device->GetGeometryArena();
+
+    // Instances are culled and drawn from commands written on the GPU, which needs materials to be in the table
+    bool indirect = bindless && settings.indirectDrawing && device->SupportsIndirectDrawing();
+    bool occlusion = indirect && settings.occlusionCulling;
+    auto drawList = indirect ? std::make_shared<IndirectDrawList>(renderer, occlusion ? 2 : 1, occlusion) : nullptr;
+
+    std::vector<std::string_view> defines;
+    if (bindless)
+        defines.emplace_back("BINDLESS");
+    if (indirect)
+        defines.emplace_back("INDIRECT");
+    if (gBuffer.compact)
+        defines.emplace_back("COMPACT_GBUFFER");
+
     auto renderGeometry = renderer.AddPipeline(PipelineSettings{
         .shaderName = "GeometryPass.shader",
+        .shaderDefines = defines,
         .framebuffer = gFramebuffer
     });
 
-    renderer.AddPass("Geometry pass", [=](Context& ctx, View& view)
+    // Instances which don't fit in the draw list are drawn directly
+    auto renderGeometryDirect = renderGeometry;
+    if (indirect)
     {
-        ctx.BeginRenderPass(gFramebuffer);
-        ctx.Clear();
+        std::erase(defines, "INDIRECT");
+        renderGeometryDirect = renderer.AddPipeline(PipelineSettings{
+            .shaderName = "GeometryPass.shader",
+            .shaderDefines = defines,
+            .framebuffer = gFramebuffer
+        });
+    }
 
-        ctx.BindPipeline(renderGeometry);
-        view.BindUniforms(ctx);
+    auto resources = PassResources{ .writes = { colorTextures.begin(), colorTextures.end() } };
+    resources.writes.push_back(gBuffer.depth);
+    if (materials)
+        resources.bufferReads.push_back(materials->GetBuffer());
 
-        view.GetScene().Each<ModelInstance, Transform>([&](ModelInstance& instance, Transform& local)
+    // Records the indirect draws of a view, which the late occlusion phase adds to the results of the early phase
+    auto drawIndirect = [=](Context& ctx, View& view, uint32 drawView, bool clear)
+    {
+        // Draws scale with the number of batches, so far fewer are needed per task to be worth splitting
+        auto numBatches = drawList->GetNumBatches();
+        auto numTasks = ctx.GetNumRecordingTasks(numBatches, kMinBatchesPerTask);
+
+        ctx.RecordParallel(gFramebuffer, numTasks, [&](Context& taskCtx, uint32, uint32 task)
         {
-            for (auto& primitive: *instance.model)
+            if (clear && task == 0)
+                taskCtx.Clear();
+
+            taskCtx.BindPipeline(renderGeometry);
+            view.BindUniforms(taskCtx);
+            taskCtx.BindBuffer("Materials"_id, materials->GetBuffer());
+            drawList->BindInstances(taskCtx);
+
+            drawList->Draw(taskCtx, drawView, numBatches * task / numTasks, numBatches * (task + 1) / numTasks);
+        });
+    };
+
+    // Records draws culled against the view's frustum, without a draw list or for the instances which overflowed it
+    // Draws are either the view's SceneDraws or the draw list's OverflowDraws, with their bounds in the same order.
+    auto drawDirect = [=](Context& ctx, View& view, const auto& draws, const BoundsList& bounds, bool clear)
+    {
+        std::vector<uint32> visible;
+        bounds.Cull(Frustum(view.GetViewProjectionMatrix()), true, visible);
+
+        // Material records are looked up before recording, as the table isn't safe to use from worker threads
+        std::vector<uint32> materialIndices;
+        if (materials)
+        {
+            materialIndices.reserve(visible.size());
+            for (auto index: visible)
+                materialIndices.push_back(materials->GetIndex(draws[index].material));
+        }
+
+        auto numTasks = ctx.GetNumRecordingTasks(visible.size(), kMinDrawsPerTask);
+        ctx.RecordParallel(gFramebuffer, numTasks, [&](Context& taskCtx, uint32, uint32 task)
+        {
+            if (clear && task == 0)
+                taskCtx.Clear();
+
+            taskCtx.BindPipeline(renderGeometryDirect);
+            view.BindUniforms(taskCtx);
+            if (materials)
+                taskCtx.BindBuffer("Materials"_id, materials->GetBuffer());
+            arena->Bind(taskCtx);
+
+            auto end = visible.size() * (task + 1) / numTasks;
+            for (auto i = visible.size() * task / numTasks; i < end; ++i)
             {
-                auto& mesh = primitive.mesh;
-                auto material = instance.material ? instance.material : primitive.material;
+                auto& draw = draws[visible[i]];
+                auto& mesh = *draw.mesh;
 
-                auto mv = view.GetViewMatrix() * local.model;
+                auto mv = view.GetViewMatrix() * draw.model;
                 auto mvp = view.GetProjectionMatrix() * mv;
 
                 // Bind material data
-                material->BindUniforms(ctx);
+                if (materials)
+                    taskCtx.Uniform("u_MaterialIndex"_id, materialIndices[i]);
+                else
+                    draw.material->BindUniforms(taskCtx);
 
                 // Bind per-draw data
-                ctx.Uniform("u_MVP"_id, mvp);
-                ctx.Uniform("u_MV"_id, mv);
+                taskCtx.Uniform("u_MVP"_id, mvp);
+                taskCtx.Uniform("u_MV"_id, mv);
 
-                ctx.BindBuffer(mesh.vertexBuffer);
-                ctx.BindBuffer(mesh.indexBuffer);
-                ctx.Draw(mesh.numIndices);
+                mesh.Draw(taskCtx);
             }
         });
-        ctx.EndRenderPass();
-    });
-
-    return gBuffer;
-}
+    };
 
-Texture* AddGenerateHiZPass(Renderer& renderer, Texture* depthTexture)
-{
-    auto& settings = renderer.GetSettings();
+    // The occlusion Hi-Z is read before it is written, so it carries over to the next frame's early phase
+    auto occlusionHiZ = occlusion ? AddHiZTarget(renderer, gBuffer.depth) : nullptr;
+    auto cullingStats = &renderer.GetCullingStats();
 
-    auto[baseWidth, baseHeight] = depthTexture->GetSize();
+    if (drawList)
+    {
+        auto cullOutputs = drawList->GetCullOutputs();
+        resources.bufferReads.insert(resources.bufferReads.end(), cullOutputs.begin(), cullOutputs.end());
 
-    auto levels = (uint32)Floor(Log2((float)Max(baseWidth, baseHeight))) + 1;
+        auto cullResources = PassResources{ .bufferWrites = cullOutputs };
+        if (occlusionHiZ)
+            cullResources.reads.push_back(occlusionHiZ);
 
-    auto hiZ = renderer.AddRenderTarget(TextureSettings{
-        .width = baseWidth, .height = baseHeight,
-        .levels = levels,
-        .format = TextureFormat::kR32F,
-        .addressMode = TextureAddressMode::kClampToEdge,
-        .filter = TextureFilter::kNearest,
-        .usage = TextureUsage::kReadWrite
-    });
+        renderer.AddPass("Geometry cull", std::move(cullResources), [=](Context& ctx, View& view)
+        {
+            drawList->Gather(view.GetScene(), materials.get());
+            *cullingStats = drawList->GetStats();
 
-    auto generateHiZ = renderer.AddPipeline(PipelineSettings{
-        .shaderName = "GenerateHiZ.shader", .type = PipelineType::kCompute
-    });
+            if (occlusionHiZ)
+                drawList->CullEarly(ctx, 0, view.GetViewProjectionMatrix(), occlusionHiZ);
+            else
+                drawList->Cull(ctx, 0, view.GetViewProjectionMatrix());
+        });
+    }
 
-    auto buffer = renderer.GetTransferBuffer();
+    auto lateResources = resources;
 
-    renderer.AddPass("Generate Hi-Z", [=, &settings](Context& ctx, View& view)
+    renderer.AddPass("Geometry pass", std::move(resources), [=](Context& ctx, View& view)
     {
-        // Copy depth texture to level 0 of color mip pyramid
-        ctx.CopyTexture(depthTexture, 0, 0, buffer, 0, baseWidth, baseHeight);
-        ctx.CopyTexture(buffer, 0, hiZ, 0, 0, baseWidth, baseHeight);
+        if (drawList)
+        {
+            drawIndirect(ctx, view, 0, true);
 
-        // Progressively render to lower mip levels
-        ctx.BindPipeline(generateHiZ);
-        uint32 width = baseWidth;
-        uint32 height = baseHeight;
+            auto& overflow = drawList->GetOverflow();
+            if (!overflow.empty())
+                drawDirect(ctx, view, overflow, drawList->GetOverflowBounds(), false);
+            return;
+        }
 
-        for (int level = 1; level < hiZ->GetSettings().levels; ++level)
+        drawDirect(ctx, view, view.GetSceneDraws(), view.GetSceneBounds(), true);
+    });
+
+    if (occlusionHiZ)
+    {
+        // Instances hidden by last frame's depth are tested again against the depth drawn so far
+        AddHiZPass(renderer, "Generate occlusion Hi-Z", gBuffer.depth, occlusionHiZ, true);
+
+        renderer.AddPass("Geometry cull late", PassResources{
+            .reads = { occlusionHiZ },
+            .bufferWrites = drawList->GetCullOutputs()
+        }, [=](Context& ctx, View& view)
         {
-            width = Max(width / 2u, 1u);
-            height = Max(height / 2u, 1u);
+            drawList->CullLate(ctx, 1, view.GetViewProjectionMatrix(), occlusionHiZ);
+        });
 
-            auto offset = std::pair<int, int>(
-                width % 2 ? 2 : 1,
-                height % 2 ? 2 : 1);
+        // Adds to the contents of the early pass rather than replacing them
+        lateResources.reads = lateResources.writes;
+        renderer.AddPass("Geometry pass late", std::move(lateResources), [=](Context& ctx, View& view)
+        {
+            drawIndirect(ctx, view, 1, false);
+        });
+    }
 
-            ctx.BindTexture("u_Input"_id, hiZ, level - 1);
-            ctx.BindImage("u_Output"_id, hiZ, level);
-            ctx.Uniform("u_Offset"_id, offset);
+    return gBuffer;
+}
 
-            auto[numX, numY] = settings.ComputeGroupCount(width, height);
-            ctx.Dispatch(numX, numY, 1);
-        }
-    });
+Texture* AddGenerateHiZPass(Renderer& renderer, Texture* depthTexture)
+{
+    auto hiZ = AddHiZTarget(renderer, depthTexture);
+    AddHiZPass(renderer, "Generate Hi-Z", depthTexture, hiZ, false);
 
     return hiZ;
 }
@@ -15,9 +15,14 @@ struct GBuffer
     Texture* normals;
     Texture* metalRoughness;
     Texture* emissive;
+
+    // Shaders reading the GBuffer must define COMPACT_GBUFFER to decode this layout, which has no metal/roughness
+    // target and whose emissive is the scene radiance
+    bool compact;
 };
 
-GBuffer AddGeometryPass(Renderer& renderer);
+//! Draws the scene's models into the GBuffer, writing emissive to the scene radiance if the GBuffer is compact
+GBuffer AddGeometryPass(Renderer& renderer, Texture* sceneRadiance);
 
 Texture* AddGenerateHiZPass(Renderer& renderer, Texture* depthTexture);
 
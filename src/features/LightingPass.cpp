@@ -22,7 +22,7 @@ Texture* CreateSceneRadianceTarget(Renderer& renderer)
     return renderer.AddRenderTarget(TextureSettings{
         .width = settings.viewportWidth,
         .height = settings.viewportHeight,
-        .format = TextureFormat::kRGBA32F
+        .format = settings.GetHdrFormat()
     });
 }
 
@@ -39,11 +39,18 @@ void AddLightingPass(Renderer& renderer,
         .depthTexture = gBuffer.depth
     });
 
+    std::vector<std::string_view> defines;
+    if (gBuffer.compact)
+        defines.emplace_back("COMPACT_GBUFFER");
+
+    // The compact GBuffer's emissive is already in the scene radiance, so lighting is added to it
     auto lightingPipeline = renderer.AddPipeline(PipelineSettings{
         .shaderName = "LightingPass.shader",
+        .shaderDefines = defines,
         .framebuffer = framebuffer,
         .depthTestEnable = false,
-        .depthWriteEnable = false
+        .depthWriteEnable = false,
+        .additiveBlendEnable = gBuffer.compact
     });
 
     auto skyboxPipeline = renderer.AddPipeline(PipelineSettings{
@@ -57,7 +64,17 @@ void AddLightingPass(Renderer& renderer,
     auto quad = settings.quadMesh.get();
     auto cube = settings.cubeMesh.get();
 
-    renderer.AddPass("Lighting", [=](Context& ctx, View& view)
+    auto resources = PassResources{
+        .reads = {
+            gBuffer.baseColor, gBuffer.normals, gBuffer.emissive, gBuffer.depth,
+            depth, momentShadows, screenAO, screenReflections
+        },
+        .writes = { sceneRadiance, gBuffer.depth }
+    };
+    if (gBuffer.metalRoughness)
+        resources.reads.push_back(gBuffer.metalRoughness);
+
+    renderer.AddPass("Lighting", std::move(resources), [=](Context& ctx, View& view)
     {
         ctx.BeginRenderPass(framebuffer);
 
@@ -96,18 +113,23 @@ void AddLightingPass(Renderer& renderer,
 
         ctx.BindTexture("u_BaseColor"_id, gBuffer.baseColor);
         ctx.BindTexture("u_Normal"_id, gBuffer.normals);
-        ctx.BindTexture("u_MetalRough"_id, gBuffer.metalRoughness);
         ctx.BindTexture("u_Depth"_id, depth);
-        ctx.BindTexture("u_Emissive"_id, gBuffer.emissive);
+        if (!gBuffer.compact)
+        {
+            ctx.BindTexture("u_MetalRough"_id, gBuffer.metalRoughness);
+            ctx.BindTexture("u_Emissive"_id, gBuffer.emissive);
+        }
 
-        ctx.BindBuffer(quad->vertexBuffer);
-        ctx.BindBuffer(quad->indexBuffer);
-        ctx.Draw(quad->numIndices);
+        quad->Bind(ctx);
+        quad->Draw(ctx);
 
         ctx.EndRenderPass();
     });
 
-    renderer.AddPass("Skybox", [=](Context& ctx, View& view)
+    renderer.AddPass("Skybox", PassResources{
+        .reads = { sceneRadiance, gBuffer.depth },
+        .writes = { sceneRadiance, gBuffer.depth }
+    }, [=](Context& ctx, View& view)
     {
         ctx.BeginRenderPass(framebuffer);
 
@@ -116,9 +138,8 @@ void AddLightingPass(Renderer& renderer,
 
         ctx.BindTexture("u_Skybox"_id, view.GetScene().environment.cubeMap);
 
-        ctx.BindBuffer(cube->indexBuffer);
-        ctx.BindBuffer(cube->vertexBuffer);
-        ctx.Draw(cube->numIndices);
+        cube->Bind(ctx);
+        cube->Draw(ctx);
 
         ctx.EndRenderPass();
     });
@@ -1,14 +1,21 @@
 #include "MomentShadowPass.hpp"
 
+#include "rendering/Culling.hpp"
+#include "rendering/IndirectDrawList.hpp"
 #include "scene/Transform.hpp"
 #include "scene/Camera.hpp"
-#include "scene/ModelInstance.hpp"
 
 namespace lucent
 {
 
+// Depth only draws are cheap to record, so each task needs more of them to be worthwhile
+static constexpr uint32 kMinDrawsPerTask = 256;
+static constexpr uint32 kMinBatchesPerTask = 64;
+
 static void CalculateCascades(View& view)
 {
+    LC_PROFILE_ZONE("CalculateCascades");
+
     auto& scene = view.GetScene();
 
     auto& cameraOrigin = scene.mainCamera.Get<Transform>();
@@ -152,50 +159,138 @@ Texture* AddMomentShadowPass(Renderer& renderer)
         });
     }
 
+    // Each cascade is a view of the same instance list, culled separately
+    bool indirect = settings.indirectDrawing && renderer.GetDevice()->SupportsIndirectDrawing();
+    auto drawList = indirect ? std::make_shared<IndirectDrawList>(renderer, numCascades) : nullptr;
+
     auto depthOnly = renderer.AddPipeline(PipelineSettings{
         .shaderName = "DepthOnly.shader",
+        .shaderDefines = drawList ? std::vector<std::string_view>{ "INDIRECT" } : std::vector<std::string_view>{},
         .framebuffer = depthFramebuffers.back(),
         .depthClampEnable = true
     });
 
+    // Instances which don't fit in the draw list are drawn directly
+    auto depthOnlyDirect = depthOnly;
+    if (drawList)
+    {
+        depthOnlyDirect = renderer.AddPipeline(PipelineSettings{
+            .shaderName = "DepthOnly.shader",
+            .framebuffer = depthFramebuffers.back(),
+            .depthClampEnable = true
+        });
+    }
+
     auto resolveDepth = renderer.AddPipeline(PipelineSettings{
         .shaderName = "MomentShadowResolve.shader",
-        .framebuffer = momentMapLayers.back()
+        .framebuffer = momentMapLayers.back(),
+        .depthTestEnable = false,
+        .depthWriteEnable = false
     });
 
     auto quad = settings.quadMesh.get();
+    auto arena = renderer.GetDevice()->GetGeometryArena();
+
+    auto depthResources = PassResources{
+        .writes = depthTextures
+    };
 
-    renderer.AddPass("Shadow map render depth MS", [=](Context& ctx, View& view)
+    if (drawList)
+    {
+        depthResources.bufferReads = drawList->GetCullOutputs();
+
+        renderer.AddPass("Shadow map cull", PassResources{
+            .bufferWrites = drawList->GetCullOutputs()
+        }, [=](Context& ctx, View& view)
+        {
+            CalculateCascades(view);
+            auto& cascades = view.GetScene().mainDirectionalLight.Get<DirectionalLight>().cascades;
+
+            // Depth is clamped, so casters in front of or behind a cascade still need to be drawn
+            drawList->Gather(view.GetScene());
+            for (uint32 i = 0; i < numCascades; ++i)
+                drawList->Cull(ctx, i, cascades[i].projection, false);
+        });
+    }
+
+    // Records draws culled against each cascade, without a draw list or for the instances which overflowed it
+    // Draws are either the view's SceneDraws or the draw list's OverflowDraws, with their bounds in the same order.
+    auto drawDirect = [=](Context& ctx, View& view, const auto& draws, const BoundsList& bounds, bool clear)
     {
-        CalculateCascades(view);
         auto& cascades = view.GetScene().mainDirectionalLight.Get<DirectionalLight>().cascades;
+        std::vector<const Framebuffer*> renderPasses(depthFramebuffers.begin(), depthFramebuffers.end());
 
-        // Render depth to the moment MS depth textures
-        for (int i = 0; i < numCascades; ++i)
+        // Depth is clamped, so casters in front of or behind a cascade still need to be drawn
+        std::vector<std::vector<uint32>> visible(numCascades);
+        size_t maxVisible = 0;
+        for (uint32 i = 0; i < numCascades; ++i)
         {
-            ctx.BeginRenderPass(depthFramebuffers[i]);
-            ctx.Clear();
+            bounds.Cull(Frustum(cascades[i].projection), false, visible[i]);
+            maxVisible = Max(maxVisible, visible[i].size());
+        }
 
-            auto& cascade = cascades[i];
-            ctx.BindPipeline(depthOnly);
-            view.GetScene().Each<ModelInstance, Transform>([&](ModelInstance& instance, Transform& local)
+        // Render depth to the moment MS depth textures, recording every cascade at once
+        auto numTasks = ctx.GetNumRecordingTasks(maxVisible, kMinDrawsPerTask);
+
+        ctx.RecordParallel(renderPasses, numTasks, [&](Context& taskCtx, uint32 pass, uint32 task)
+        {
+            if (clear && task == 0)
+                taskCtx.Clear();
+
+            auto& cascade = cascades[pass];
+            taskCtx.BindPipeline(depthOnlyDirect);
+            arena->Bind(taskCtx);
+
+            auto& cascadeDraws = visible[pass];
+            auto end = cascadeDraws.size() * (task + 1) / numTasks;
+            for (auto i = cascadeDraws.size() * task / numTasks; i < end; ++i)
             {
-                for (auto& primitive: *instance.model)
-                {
-                    auto& mesh = primitive.mesh;
-                    auto mvp = cascade.projection * local.model;
-                    ctx.Uniform("u_MVP"_id, mvp);
+                auto& draw = draws[cascadeDraws[i]];
+                auto& mesh = *draw.mesh;
+                auto mvp = cascade.projection * draw.model;
+                taskCtx.Uniform("u_MVP"_id, mvp);
 
-                    ctx.BindBuffer(mesh.vertexBuffer);
-                    ctx.BindBuffer(mesh.indexBuffer);
-                    ctx.Draw(mesh.numIndices);
-                }
+                mesh.Draw(taskCtx);
+            }
+        });
+    };
+
+    renderer.AddPass("Shadow map render depth MS", std::move(depthResources), [=](Context& ctx, View& view)
+    {
+        auto& cascades = view.GetScene().mainDirectionalLight.Get<DirectionalLight>().cascades;
+        std::vector<const Framebuffer*> renderPasses(depthFramebuffers.begin(), depthFramebuffers.end());
+
+        if (drawList)
+        {
+            auto numBatches = drawList->GetNumBatches();
+            auto numTasks = ctx.GetNumRecordingTasks(numBatches, kMinBatchesPerTask);
+
+            ctx.RecordParallel(renderPasses, numTasks, [&](Context& taskCtx, uint32 pass, uint32 task)
+            {
+                if (task == 0)
+                    taskCtx.Clear();
+
+                taskCtx.BindPipeline(depthOnly);
+                taskCtx.Uniform("u_ViewProjection"_id, cascades[pass].projection);
+                drawList->BindInstances(taskCtx);
+
+                drawList->Draw(taskCtx, pass, numBatches * task / numTasks, numBatches * (task + 1) / numTasks);
             });
-            ctx.EndRenderPass();
+
+            auto& overflow = drawList->GetOverflow();
+            if (!overflow.empty())
+                drawDirect(ctx, view, overflow, drawList->GetOverflowBounds(), false);
+            return;
         }
+
+        CalculateCascades(view);
+        drawDirect(ctx, view, view.GetSceneDraws(), view.GetSceneBounds(), true);
     });
 
-    renderer.AddPass("Shadow map resolve depth", [=](Context& ctx, View& view)
+    renderer.AddPass("Shadow map resolve depth", PassResources{
+        .reads = depthTextures,
+        .writes = { momentMap, tempDepth }
+    }, [=](Context& ctx, View& view)
     {
         // Calculate moments from depth values using custom resolve
         for (int i = 0; i < numCascades; ++i)
@@ -208,9 +303,8 @@ Texture* AddMomentShadowPass(Renderer& renderer)
             ctx.BindPipeline(resolveDepth);
             ctx.BindTexture("u_Depth"_id, depthTexture);
 
-            ctx.BindBuffer(quad->vertexBuffer);
-            ctx.BindBuffer(quad->indexBuffer);
-            ctx.Draw(quad->numIndices);
+            quad->Bind(ctx);
+            quad->Draw(ctx);
 
             ctx.EndRenderPass();
         }
@@ -18,7 +18,7 @@ static Texture* AddBloomPass(Renderer& renderer, Texture* sceneRadiance)
         .width = settings.viewportWidth,
         .height = settings.viewportHeight,
         .levels = bloomMips,
-        .format = TextureFormat::kRGBA32F,
+        .format = settings.GetHdrFormat(),
         .addressMode = TextureAddressMode::kClampToEdge,
         .usage = TextureUsage::kReadWrite
     };
@@ -27,21 +27,25 @@ static Texture* AddBloomPass(Renderer& renderer, Texture* sceneRadiance)
 
     auto bloomDownsample = renderer.AddPipeline(PipelineSettings{
         .shaderName = "Bloom.shader",
+        .shaderDefines = { settings.GetHdrFormatDefine() },
         .type = PipelineType::kCompute
     });
     auto bloomDownsampleWeighted = renderer.AddPipeline(PipelineSettings{
         .shaderName = "Bloom.shader",
-        .shaderDefines = { "AVERAGE KarisAverage" },
+        .shaderDefines = { "AVERAGE KarisAverage", settings.GetHdrFormatDefine() },
         .type = PipelineType::kCompute
     });
 
     auto bloomUpsample = renderer.AddPipeline(PipelineSettings{
         .shaderName = "Bloom.shader",
-        .shaderDefines = { "BLOOM_UPSAMPLE" },
+        .shaderDefines = { "BLOOM_UPSAMPLE", settings.GetHdrFormatDefine() },
         .type = PipelineType::kCompute
     });
 
-    renderer.AddPass("Bloom", [=, &settings](Context& ctx, View& view)
+    renderer.AddPass("Bloom", PassResources{
+        .reads = { sceneRadiance },
+        .writes = { bloomDownsampleMips, bloomUpsampleMips }
+    }, [=, &settings](Context& ctx, View& view)
     {
         auto[srcWidth, srcHeight] = sceneRadiance->GetSize();
         ctx.CopyTexture(sceneRadiance, 0, 0, bloomDownsampleMips, 0, 0, srcWidth, srcHeight);
@@ -105,7 +109,10 @@ Texture* AddPostProcessPass(Renderer& renderer, Texture* sceneRadiance)
         .type = PipelineType::kCompute
     });
 
-    renderer.AddPass("Post-process Output", [=, &settings](Context& ctx, View& view)
+    renderer.AddPass("Post-process Output", PassResources{
+        .reads = { sceneRadiance, bloomOutput },
+        .writes = { output }
+    }, [=, &settings](Context& ctx, View& view)
     {
         ctx.BindPipeline(computeOutput);
         ctx.BindTexture("u_Input"_id, sceneRadiance);
@@ -3,22 +3,22 @@
 namespace lucent
 {
 
-static Texture* AddBlurPass(Renderer& renderer, Texture* input)
+Texture* AddReflectionSourcePass(Renderer& renderer, Texture* prevColor)
 {
     auto& settings = renderer.GetSettings();
-    auto[width, height] = input->GetSize();
+    auto[width, height] = prevColor->GetSize();
 
     auto levels = (uint32)Floor(Log2((float)Max(width, height))) + 1;
 
     auto convolvedInput = renderer.AddRenderTarget(TextureSettings{
         .width = width, .height = height, .levels = levels,
-        .format = TextureFormat::kRGBA32F,
+        .format = settings.GetHdrFormat(),
         .usage = TextureUsage::kReadWrite,
     });
 
     auto tempTargetSettings = TextureSettings{
         .width = width / 2, .height = height / 2, .levels = levels - 1,
-        .format = TextureFormat::kRGBA32F,
+        .format = settings.GetHdrFormat(),
         .addressMode = TextureAddressMode::kClampToEdge,
         .usage = TextureUsage::kReadWrite,
     };
@@ -26,15 +26,22 @@ static Texture* AddBlurPass(Renderer& renderer, Texture* input)
     auto blurTarget = renderer.AddRenderTarget(tempTargetSettings);
 
     auto blurHorizontal = renderer.AddPipeline(PipelineSettings{
-        .shaderName = "SSRConvolve.shader", .shaderDefines = { "BLUR_HORIZONTAL" }, .type = PipelineType::kCompute
+        .shaderName = "SSRConvolve.shader",
+        .shaderDefines = { "BLUR_HORIZONTAL", settings.GetHdrFormatDefine() },
+        .type = PipelineType::kCompute
     });
     auto blurVertical = renderer.AddPipeline(PipelineSettings{
-        .shaderName = "SSRConvolve.shader", .shaderDefines = { "BLUR_VERTICAL" }, .type = PipelineType::kCompute
+        .shaderName = "SSRConvolve.shader",
+        .shaderDefines = { "BLUR_VERTICAL", settings.GetHdrFormatDefine() },
+        .type = PipelineType::kCompute
     });
 
-    renderer.AddPass("SSR pre-convolve", [=, &settings](Context& ctx, View& view)
+    renderer.AddPass("SSR pre-convolve", PassResources{
+        .reads = { prevColor },
+        .writes = { convolvedInput, downsampleTarget, blurTarget }
+    }, [=, &settings](Context& ctx, View& view)
     {
-        ctx.BlitTexture(input, 0, 0, convolvedInput, 0, 0);
+        ctx.BlitTexture(prevColor, 0, 0, convolvedInput, 0, 0);
 
         for (int mip = 0; mip < levels - 1; ++mip)
         {
@@ -60,25 +67,35 @@ static Texture* AddBlurPass(Renderer& renderer, Texture* input)
     return convolvedInput;
 }
 
-Texture* AddScreenSpaceReflectionsPass(Renderer& renderer, GBuffer gBuffer, Texture* minZ, Texture* prevColor)
+Texture* AddScreenSpaceReflectionsPass(Renderer& renderer, GBuffer gBuffer, Texture* minZ, Texture* convolvedScene)
 {
     auto& settings = renderer.GetSettings();
 
     uint32 width = settings.viewportWidth;
     uint32 height = settings.viewportHeight;
 
-    // Trace rays
+    // Trace rays, hits are screen coordinates in [0, 1] so keep enough precision in normalized 16-bit integers
+    bool packRays = !settings.fullPrecision && renderer.GetDevice()->SupportsStorageFormat(TextureFormat::kRG16U);
     auto rayHits = renderer.AddRenderTarget(TextureSettings{
         .width = width, .height = height,
-        .format = TextureFormat::kRG32F,
+        .format = packRays ? TextureFormat::kRG16U : TextureFormat::kRG32F,
         .usage = TextureUsage::kReadWrite
     });
 
+    std::vector<std::string_view> traceDefines = { packRays ? "RAY_FORMAT rg16" : "RAY_FORMAT rg32f" };
+    if (gBuffer.compact)
+        traceDefines.emplace_back("COMPACT_GBUFFER");
+
     auto traceReflections = renderer.AddPipeline(PipelineSettings{
-        .shaderName = "SSRTraceMinZ.shader", .type = PipelineType::kCompute
+        .shaderName = "SSRTraceMinZ.shader",
+        .shaderDefines = traceDefines,
+        .type = PipelineType::kCompute
     });
 
-    renderer.AddPass("SSR trace rays", [=, &settings](Context& ctx, View& view)
+    renderer.AddPass("SSR trace rays", PassResources{
+        .reads = { minZ, gBuffer.normals },
+        .writes = { rayHits }
+    }, [=, &settings](Context& ctx, View& view)
     {
         ctx.BindPipeline(traceReflections);
         view.BindUniforms(ctx);
@@ -91,21 +108,30 @@ Texture* AddScreenSpaceReflectionsPass(Renderer& renderer, GBuffer gBuffer, Text
         ctx.Dispatch(numX, numY, 1);
     });
 
-    // Scene blurring
-    auto convolvedScene = AddBlurPass(renderer, prevColor);
-
     // Resolve/reproject
     auto resolvedReflections = renderer.AddRenderTarget(TextureSettings{
         .width = width, .height = height,
-        .format = TextureFormat::kRGBA32F,
+        .format = settings.GetHdrFormat(),
         .usage = TextureUsage::kReadWrite
     });
 
+    std::vector<std::string_view> resolveDefines = { settings.GetHdrFormatDefine() };
+    if (gBuffer.compact)
+        resolveDefines.emplace_back("COMPACT_GBUFFER");
+
     auto resolveReflections = renderer.AddPipeline(PipelineSettings{
-        .shaderName = "SSRResolveReflections.shader", .type = PipelineType::kCompute
+        .shaderName = "SSRResolveReflections.shader",
+        .shaderDefines = resolveDefines,
+        .type = PipelineType::kCompute
     });
 
-    renderer.AddPass("SSR resolve reflections", [=, &settings](Context& ctx, View& view)
+    // The compact GBuffer stores roughness alongside the normals
+    auto roughness = gBuffer.compact ? gBuffer.normals : gBuffer.metalRoughness;
+
+    renderer.AddPass("SSR resolve reflections", PassResources{
+        .reads = { rayHits, convolvedScene, minZ, roughness },
+        .writes = { resolvedReflections }
+    }, [=, &settings](Context& ctx, View& view)
     {
         ctx.BindPipeline(resolveReflections);
         view.BindUniforms(ctx);
@@ -113,7 +139,7 @@ Texture* AddScreenSpaceReflectionsPass(Renderer& renderer, GBuffer gBuffer, Text
         ctx.BindTexture("u_Rays"_id, rayHits);
         ctx.BindTexture("u_ConvolvedScene"_id, convolvedScene);
         ctx.BindTexture("u_Depth"_id, minZ);
-        ctx.BindTexture("u_MetalRoughness"_id, gBuffer.metalRoughness);
+        ctx.BindTexture("u_MetalRoughness"_id, roughness);
         ctx.BindImage("u_Result"_id, resolvedReflections);
 
         auto[numX, numY] = settings.ComputeGroupCount(width, height);
@@ -6,6 +6,10 @@
 namespace lucent
 {
 
-Texture* AddScreenSpaceReflectionsPass(Renderer& renderer, GBuffer gBuffer, Texture* minZ, Texture* prevColor);
+//! Blurs the previous frame's color into a mip chain for reflections to sample by roughness
+//! Must be added before any pass writing to the color this frame.
+Texture* AddReflectionSourcePass(Renderer& renderer, Texture* prevColor);
+
+Texture* AddScreenSpaceReflectionsPass(Renderer& renderer, GBuffer gBuffer, Texture* minZ, Texture* convolvedScene);
 
 }
@@ -0,0 +1,142 @@
+#include "Culling.hpp"
+
+#include <bit>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define LC_CULLING_SSE
+#endif
+
+namespace lucent
+{
+
+Frustum::Frustum(const Matrix4& viewProjection)
+{
+    auto row = [&](int i)
+    {
+        return Vector4(viewProjection(i, 0), viewProjection(i, 1), viewProjection(i, 2), viewProjection(i, 3));
+    };
+    auto r0 = row(0);
+    auto r1 = row(1);
+    auto r2 = row(2);
+    auto r3 = row(3);
+
+    planes = {
+        r3 + r0, r3 - r0,
+        r3 + r1, r3 - r1,
+        r2, r3 - r2
+    };
+
+    for (auto& plane: planes)
+    {
+        auto length = Vector3(plane).Length();
+        if (length > 0.0f)
+            plane /= length;
+    }
+}
+
+bool Frustum::Intersects(Vector3 center, float radius, bool cullDepth) const
+{
+    auto numPlanes = cullDepth ? 6 : 4;
+    for (int i = 0; i < numPlanes; ++i)
+    {
+        auto& plane = planes[i];
+        if (plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w < -radius)
+            return false;
+    }
+    return true;
+}
+
+void BoundsList::Clear()
+{
+    m_X.clear();
+    m_Y.clear();
+    m_Z.clear();
+    m_Radius.clear();
+}
+
+void BoundsList::Reserve(size_t count)
+{
+    m_X.reserve(count);
+    m_Y.reserve(count);
+    m_Z.reserve(count);
+    m_Radius.reserve(count);
+}
+
+void BoundsList::Add(Vector3 center, float radius)
+{
+    m_X.push_back(center.x);
+    m_Y.push_back(center.y);
+    m_Z.push_back(center.z);
+    m_Radius.push_back(radius);
+}
+
+void BoundsList::Add(const StaticMesh& mesh, const Matrix4& model)
+{
+    auto center = Vector3(model * Vector4(mesh.boundsCenter, 1.0f));
+
+    // Non-uniform scale stretches the sphere by at most the largest axis scale
+    auto scale = Max(Vector3(model.c1).Length(), Max(Vector3(model.c2).Length(), Vector3(model.c3).Length()));
+
+    Add(center, mesh.boundsRadius * scale);
+}
+
+uint32 BoundsList::Size() const
+{
+    return static_cast<uint32>(m_X.size());
+}
+
+void BoundsList::Cull(const Frustum& frustum, bool cullDepth, std::vector<uint32>& visible) const
+{
+    visible.clear();
+
+    auto size = Size();
+    auto numPlanes = cullDepth ? 6 : 4;
+    uint32 i = 0;
+
+#ifdef LC_CULLING_SSE
+    // Test four spheres against each plane at once
+    __m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+    for (int p = 0; p < numPlanes; ++p)
+    {
+        planeX[p] = _mm_set1_ps(frustum.planes[p].x);
+        planeY[p] = _mm_set1_ps(frustum.planes[p].y);
+        planeZ[p] = _mm_set1_ps(frustum.planes[p].z);
+        planeW[p] = _mm_set1_ps(frustum.planes[p].w);
+    }
+
+    for (; i + 4 <= size; i += 4)
+    {
+        auto x = _mm_loadu_ps(&m_X[i]);
+        auto y = _mm_loadu_ps(&m_Y[i]);
+        auto z = _mm_loadu_ps(&m_Z[i]);
+        auto radius = _mm_loadu_ps(&m_Radius[i]);
+
+        auto inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < numPlanes; ++p)
+        {
+            auto distance = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(planeX[p], x), _mm_mul_ps(planeY[p], y)),
+                _mm_add_ps(_mm_mul_ps(planeZ[p], z), planeW[p]));
+
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+        }
+
+        auto mask = static_cast<uint32>(_mm_movemask_ps(inside));
+        while (mask)
+        {
+            visible.push_back(i + std::countr_zero(mask));
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    // Remainder which doesn't fill a batch, or every sphere without SIMD support
+    for (; i < size; ++i)
+    {
+        if (frustum.Intersects(Vector3(m_X[i], m_Y[i], m_Z[i]), m_Radius[i], cullDepth))
+            visible.push_back(i);
+    }
+}
+
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "rendering/StaticMesh.hpp"
+
+namespace lucent
+{
+
+//! Planes bounding the clip volume of a view projection in world space, with normals pointing inwards
+struct Frustum
+{
+public:
+    //! Expects clip space depth in [0, 1]
+    explicit Frustum(const Matrix4& viewProjection);
+
+    //! Views with clamped depth should not be culled by depth, as geometry outside their depth range is still drawn
+    bool Intersects(Vector3 center, float radius, bool cullDepth = true) const;
+
+public:
+    // Left, right, bottom, top, near and far, normalized so distances to the planes are in world units
+    std::array<Vector4, 6> planes;
+};
+
+//! World space bounding spheres kept in a separate contiguous array per component, so several can be culled at once
+class BoundsList
+{
+public:
+    void Clear();
+    void Reserve(size_t count);
+
+    void Add(Vector3 center, float radius);
+
+    //! Adds the bounds of a mesh placed in the world by a model matrix
+    void Add(const StaticMesh& mesh, const Matrix4& model);
+
+    uint32 Size() const;
+
+    //! Replaces the contents of visible with the indices of the spheres intersecting a frustum, in ascending order
+    void Cull(const Frustum& frustum, bool cullDepth, std::vector<uint32>& visible) const;
+
+private:
+    std::vector<float> m_X;
+    std::vector<float> m_Y;
+    std::vector<float> m_Z;
+    std::vector<float> m_Radius;
+};
+
+}
@@ -22,11 +22,14 @@ static void BuildDefaultSceneRenderer(Engine* engine, Renderer& renderer)
 {
     auto sceneRadiance = CreateSceneRadianceTarget(renderer);
 
-    auto gBuffer = AddGeometryPass(renderer);
+    // Reflections sample last frame's radiance, before the geometry pass writes emissive to it
+    auto reflectionSource = AddReflectionSourcePass(renderer, sceneRadiance);
+
+    auto gBuffer = AddGeometryPass(renderer, sceneRadiance);
     auto hiZ = AddGenerateHiZPass(renderer, gBuffer.depth);
     auto shadowMoments = AddMomentShadowPass(renderer);
     auto gtao = AddGTAOPass(renderer, gBuffer, hiZ);
-    auto ssr = AddScreenSpaceReflectionsPass(renderer, gBuffer, hiZ, sceneRadiance);
+    auto ssr = AddScreenSpaceReflectionsPass(renderer, gBuffer, hiZ, reflectionSource);
 
     AddLightingPass(renderer, gBuffer, hiZ, sceneRadiance, shadowMoments, gtao, ssr);
     auto output = AddPostProcessPass(renderer, sceneRadiance);
@@ -53,6 +56,11 @@ Engine* Engine::Instance()
     return s_Engine.get();
 }
 
+bool Engine::IsHeadlessSupported()
+{
+    return VulkanDevice::HasHeadlessDevice();
+}
+
 // TODO: Remove or extract to separate file
 // Ideally user provides existing window to the engine, might have to change debug functions in this case
 class Window
@@ -62,24 +70,36 @@ public:
 };
 
 Engine::Engine(RenderSettings settings)
+    : m_StartTime(std::chrono::steady_clock::now())
 {
-    // Set up GLFW
-    if (!glfwInit())
-        return;
+    LC_PROFILE_THREAD("Main");
 
-    // Create window
-    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    if (settings.headless)
+    {
+        // Render offscreen without a window, so no display is needed
+        m_Window = std::make_unique<Window>(Window{ nullptr });
+    }
+    else
+    {
+        // Set up GLFW
+        if (!glfwInit())
+            return;
 
-    m_Window = std::make_unique<Window>(Window{
-        glfwCreateWindow((int)settings.viewportWidth, (int)settings.viewportHeight, "Lucent", nullptr, nullptr)
-    });
-    LC_ASSERT(m_Window->window != nullptr);
+        // Create window
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 
-    m_Device = std::make_unique<VulkanDevice>(m_Window->window);
+        m_Window = std::make_unique<Window>(Window{
+            glfwCreateWindow((int)settings.viewportWidth, (int)settings.viewportHeight, "Lucent", nullptr, nullptr)
+        });
+        LC_ASSERT(m_Window->window != nullptr);
+    }
+
+    m_Device = std::make_unique<VulkanDevice>(m_Window->window, settings.swapchain);
     m_Input = std::make_unique<Input>(m_Window->window);
     m_Console = std::make_unique<DebugConsole>(*this, 120);
 
     settings.InitializeDefaultResources(m_Device.get());
+    m_TextureStreamer = std::make_unique<TextureStreamer>(m_Device.get(), settings.textureStreamingBudget);
     m_SceneRenderer = std::make_unique<Renderer>(m_Device.get(), std::move(settings));
     m_BuildSceneRenderer = BuildDefaultSceneRenderer;
 
@@ -88,14 +108,23 @@ Engine::Engine(RenderSettings settings)
 
 bool Engine::Update()
 {
-    if (glfwWindowShouldClose(m_Window->window))
-        return false;
+    LC_PROFILE_FRAME();
+    LC_PROFILE_ZONE("Engine::Update");
 
-    glfwPollEvents();
-    double time = glfwGetTime();
+    auto headless = m_Window->window == nullptr;
+    if (!headless)
+    {
+        if (glfwWindowShouldClose(m_Window->window))
+            return false;
+
+        glfwPollEvents();
+    }
+    double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_StartTime).count();
     auto dt = float(time - m_LastUpdateTime);
 
     UpdateDebug(dt);
+    m_TextureStreamer->Update(*m_ActiveScene, m_SceneRenderer->GetSettings().viewportHeight);
+
     if (!m_SceneRenderer->Render(*m_ActiveScene))
     {
         LC_INFO("Rebuilding scene renderer");
@@ -112,8 +141,7 @@ bool Engine::Update()
 
         m_ActiveScene->mainCamera.Get<Camera>().aspectRatio = (float)width / (float)height;
 
-        m_SceneRenderer->Clear();
-        m_BuildSceneRenderer(this, *m_SceneRenderer);
+        RebuildSceneRenderer();
     };
     m_Input->Reset();
 
@@ -190,4 +218,23 @@ const RenderSettings& Engine::GetRenderSettings()
     return m_SceneRenderer->GetSettings();
 }
 
+Renderer* Engine::GetSceneRenderer()
+{
+    return m_SceneRenderer.get();
+}
+
+void Engine::RebuildSceneRenderer()
+{
+    m_SceneRenderer->Clear();
+    m_BuildSceneRenderer(this, *m_SceneRenderer);
+
+    // Pipelines only the previous build used are no longer needed
+    m_Device->ReleaseUnusedPipelines();
+}
+
+TextureStreamer* Engine::GetTextureStreamer()
+{
+    return m_TextureStreamer.get();
+}
+
 }
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <chrono>
+
 #include "device/Device.hpp"
 #include "rendering/Renderer.hpp"
+#include "rendering/TextureStreamer.hpp"
 #include "debug/DebugConsole.hpp"
 
 namespace lucent
@@ -16,6 +19,9 @@ public:
 
     static Engine* Instance();
 
+    //! True if Init can create a headless engine on this machine, which needs a Vulkan device but no display
+    static bool IsHeadlessSupported();
+
     bool Update();
 
     Device* GetDevice();
@@ -28,6 +34,14 @@ public:
 
     const RenderSettings& GetRenderSettings();
 
+    Renderer* GetSceneRenderer();
+
+    //! Recreates the scene renderer's passes and render targets, e.g. after changing its settings
+    void RebuildSceneRenderer();
+
+    //! Owns the textures of imported models, loading their levels as the active scene needs them
+    TextureStreamer* GetTextureStreamer();
+
     using BuildSceneRendererCallback = std::function<void(Engine*, Renderer&)>;
 
 private:
@@ -43,6 +57,7 @@ private:
     std::unique_ptr<DebugConsole> m_Console;
     std::unique_ptr<Input> m_Input;
     std::unique_ptr<Window> m_Window;
+    std::unique_ptr<TextureStreamer> m_TextureStreamer;
 
     std::unique_ptr<Renderer> m_SceneRenderer;
     BuildSceneRendererCallback m_BuildSceneRenderer;
@@ -51,6 +66,7 @@ private:
     Scene* m_ActiveScene{};
 
     double m_LastUpdateTime{};
+    std::chrono::steady_clock::time_point m_StartTime;
 };
 
 }
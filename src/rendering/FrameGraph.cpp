@@ -0,0 +1,343 @@
+#include "FrameGraph.hpp"
+
+namespace lucent
+{
+
+template<typename T>
+static bool Contains(const std::vector<T*>& resources, const std::type_identity_t<T>* resource)
+{
+    return std::find(resources.begin(), resources.end(), resource) != resources.end();
+}
+
+template<typename T>
+static void AddUnique(std::vector<const T*>& resources, const std::type_identity_t<T>* resource)
+{
+    if (!Contains(resources, resource))
+        resources.push_back(resource);
+}
+
+void FrameGraph::AddPass(const char* label, RenderPass pass)
+{
+    LC_ASSERT(!m_Compiled);
+    m_Nodes.push_back(Node{ .label = label, .execute = std::move(pass), .declared = false });
+}
+
+void FrameGraph::AddPass(const char* label, PassResources resources, RenderPass pass)
+{
+    LC_ASSERT(!m_Compiled);
+    m_Nodes.push_back(Node{
+        .label = label,
+        .execute = std::move(pass),
+        .resources = std::move(resources),
+        .declared = true
+    });
+}
+
+void FrameGraph::Compile(const std::vector<Texture*>& targets, const Texture* output)
+{
+    auto numPasses = static_cast<uint32>(m_Nodes.size());
+
+    m_Targets = targets;
+    m_Output = output;
+    m_Buffers.clear();
+    m_Lifetimes.clear();
+
+    auto undeclared = std::find_if(m_Nodes.begin(), m_Nodes.end(), [](auto& node)
+    { return !node.declared; });
+
+    m_Aliasing = undeclared == m_Nodes.end();
+    if (!m_Aliasing)
+        LC_INFO("Frame graph culling and aliasing disabled, \"{}\" does not declare its resources", undeclared->label);
+
+    for (auto& node: m_Nodes)
+    {
+        node.culled = false;
+        node.transitions = {};
+
+        for (auto buffer: node.resources.bufferReads)
+            AddUnique(m_Buffers, buffer);
+        for (auto buffer: node.resources.bufferWrites)
+            AddUnique(m_Buffers, buffer);
+    }
+
+    // Targets read before being written carry contents over from the previous frame
+    std::vector<const Texture*> needed;
+    if (output)
+        needed.push_back(output);
+
+    std::vector<const Texture*> seen;
+    for (auto& node: m_Nodes)
+    {
+        for (auto texture: node.resources.reads)
+        {
+            if (!Contains(seen, texture))
+                AddUnique(needed, texture);
+        }
+        for (auto texture: node.resources.reads)
+            AddUnique(seen, texture);
+        for (auto texture: node.resources.writes)
+            AddUnique(seen, texture);
+    }
+
+    // Walk backwards from the output, keeping only passes which write something a later pass needs
+    if (m_Aliasing)
+    {
+        for (auto it = m_Nodes.rbegin(); it != m_Nodes.rend(); ++it)
+        {
+            auto& resources = it->resources;
+
+            bool live = resources.writes.empty() || !resources.bufferWrites.empty() ||
+                std::any_of(resources.writes.begin(), resources.writes.end(), [&](auto texture)
+                { return Contains(needed, texture); });
+
+            if (!live)
+            {
+                it->culled = true;
+                LC_INFO("Frame graph culled \"{}\", none of its outputs are used", it->label);
+                continue;
+            }
+
+            // Targets completely overwritten here don't need the results of earlier passes
+            for (auto texture: resources.writes)
+            {
+                if (!Contains(resources.reads, texture))
+                    needed.erase(std::remove(needed.begin(), needed.end(), texture), needed.end());
+            }
+            for (auto texture: resources.reads)
+                AddUnique(needed, texture);
+        }
+    }
+
+    // Find the span of live passes which access each target
+    for (auto texture: m_Targets)
+    {
+        auto lifetime = TextureLifetime{ texture, UINT32_MAX, 0 };
+        bool readFirst = false;
+        bool referenced = false;
+
+        for (uint32 i = 0; i < numPasses; ++i)
+        {
+            auto& node = m_Nodes[i];
+            bool read = Contains(node.resources.reads, texture);
+            bool written = Contains(node.resources.writes, texture);
+
+            if (!read && !written)
+                continue;
+
+            referenced = true;
+            if (node.culled)
+                continue;
+
+            if (lifetime.firstPass == UINT32_MAX)
+            {
+                lifetime.firstPass = i;
+                readFirst = read;
+            }
+            lifetime.lastPass = i;
+        }
+
+        if (!m_Aliasing || readFirst || !referenced)
+        {
+            // Whole frame, either because contents persist between frames or usage is unknown
+            lifetime.firstPass = 0;
+            lifetime.lastPass = numPasses;
+        }
+        else if (lifetime.firstPass == UINT32_MAX)
+        {
+            // Only accessed by culled passes, so never alive
+            lifetime.firstPass = lifetime.lastPass = numPasses + 1;
+        }
+        else
+        {
+            if (texture == m_Output)
+                lifetime.lastPass = numPasses;
+
+            m_Nodes[lifetime.firstPass].transitions.discards.push_back(texture);
+        }
+        m_Lifetimes.push_back(lifetime);
+    }
+
+    // Precompute the transitions needed before each pass
+    for (auto& node: m_Nodes)
+    {
+        if (node.culled)
+            continue;
+
+        auto& resources = node.resources;
+        auto& transitions = node.transitions;
+
+        if (!node.declared)
+        {
+            // Make every target available for sampling, or as a storage image if it supports it
+            for (auto texture: m_Targets)
+            {
+                if (texture->GetSettings().usage == TextureUsage::kReadWrite)
+                    transitions.writes.push_back(texture);
+                else
+                    transitions.reads.push_back(texture);
+            }
+            continue;
+        }
+
+        // Targets which are also written are transitioned once for the write
+        for (auto texture: resources.reads)
+        {
+            if (!Contains(resources.writes, texture))
+                transitions.reads.push_back(texture);
+        }
+        transitions.writes.assign(resources.writes.begin(), resources.writes.end());
+
+        for (auto buffer: resources.bufferReads)
+        {
+            if (!Contains(resources.bufferWrites, buffer))
+                transitions.bufferReads.push_back(buffer);
+        }
+        transitions.bufferWrites.assign(resources.bufferWrites.begin(), resources.bufferWrites.end());
+    }
+
+    m_Compiled = true;
+}
+
+bool FrameGraph::IsCompiled() const
+{
+    return m_Compiled;
+}
+
+const std::vector<TextureLifetime>& FrameGraph::GetLifetimes() const
+{
+    return m_Lifetimes;
+}
+
+void FrameGraph::Execute(Context& ctx, View& view)
+{
+    LC_ASSERT(m_Compiled);
+
+    for (auto& node: m_Nodes)
+    {
+        if (node.culled)
+            continue;
+
+        LC_PROFILE_ZONE(node.label);
+
+        // Barriers before a pass are timed as part of it
+        ctx.BeginRegion(node.label);
+        ctx.Transition(node.transitions);
+        node.execute(ctx, view);
+        ctx.EndRegion();
+    }
+}
+
+std::string FrameGraph::Dump() const
+{
+    auto numCulled = std::count_if(m_Nodes.begin(), m_Nodes.end(), [](auto& node)
+    { return node.culled; });
+
+    auto text = fmt::format("Frame graph: {} passes, {} culled{}\n", m_Nodes.size(), numCulled,
+        m_Aliasing ? "" : " (undeclared resources)");
+
+    auto list = [](std::string& out, const char* heading, const auto& resources, auto getName)
+    {
+        if (resources.empty())
+            return;
+
+        out += fmt::format("    {}:", heading);
+        for (auto resource: resources)
+            out += " " + getName(resource);
+        out += "\n";
+    };
+    auto textureName = [this](const Texture* texture) { return GetTextureName(texture); };
+    auto bufferName = [this](const Buffer* buffer) { return GetBufferName(buffer); };
+
+    for (uint32 i = 0; i < m_Nodes.size(); ++i)
+    {
+        auto& node = m_Nodes[i];
+        text += fmt::format("  [{}] {}{}\n", i, node.label, node.culled ? " (culled)" : "");
+
+        list(text, "reads", node.resources.reads, textureName);
+        list(text, "writes", node.resources.writes, textureName);
+        list(text, "buffer reads", node.resources.bufferReads, bufferName);
+        list(text, "buffer writes", node.resources.bufferWrites, bufferName);
+        list(text, "discards", node.transitions.discards, textureName);
+    }
+
+    text += "Targets:\n";
+    for (auto& lifetime: m_Lifetimes)
+    {
+        auto& settings = lifetime.texture->GetSettings();
+        bool aliased = lifetime.firstPass != 0 || lifetime.lastPass != m_Nodes.size();
+
+        text += fmt::format("  {} {}x{} passes {}-{}{}\n", GetTextureName(lifetime.texture),
+            settings.width, settings.height, lifetime.firstPass, lifetime.lastPass, aliased ? " (aliased)" : "");
+    }
+    return text;
+}
+
+std::string FrameGraph::DumpGraphviz() const
+{
+    std::string dot = "digraph FrameGraph {\n";
+    dot += "    rankdir=LR;\n";
+    dot += "    node [fontname=\"Helvetica\", fontsize=10];\n";
+
+    for (uint32 i = 0; i < m_Nodes.size(); ++i)
+    {
+        auto& node = m_Nodes[i];
+        dot += fmt::format("    p{} [label=\"{}: {}\", shape=box, style=\"{}\", fillcolor=\"{}\"];\n",
+            i, i, node.label, node.culled ? "dashed" : "filled", node.declared ? "#c6dbef" : "#fdd0a2");
+    }
+
+    for (auto& lifetime: m_Lifetimes)
+    {
+        auto& settings = lifetime.texture->GetSettings();
+        dot += fmt::format("    {} [label=\"{}\\n{}x{}\\npasses {}-{}\", shape=ellipse{}];\n",
+            GetTextureName(lifetime.texture), GetTextureName(lifetime.texture), settings.width, settings.height,
+            lifetime.firstPass, lifetime.lastPass, lifetime.texture == m_Output ? ", peripheries=2" : "");
+    }
+    for (auto buffer: m_Buffers)
+        dot += fmt::format("    {} [shape=cylinder];\n", GetBufferName(buffer));
+
+    for (uint32 i = 0; i < m_Nodes.size(); ++i)
+    {
+        auto& resources = m_Nodes[i].resources;
+
+        for (auto texture: resources.reads)
+            dot += fmt::format("    {} -> p{};\n", GetTextureName(texture), i);
+        for (auto texture: resources.writes)
+            dot += fmt::format("    p{} -> {};\n", i, GetTextureName(texture));
+        for (auto buffer: resources.bufferReads)
+            dot += fmt::format("    {} -> p{};\n", GetBufferName(buffer), i);
+        for (auto buffer: resources.bufferWrites)
+            dot += fmt::format("    p{} -> {};\n", i, GetBufferName(buffer));
+    }
+
+    dot += "}\n";
+    return dot;
+}
+
+void FrameGraph::Clear()
+{
+    m_Nodes.clear();
+    m_Targets.clear();
+    m_Output = nullptr;
+    m_Buffers.clear();
+    m_Lifetimes.clear();
+    m_Compiled = false;
+    m_Aliasing = false;
+}
+
+std::string FrameGraph::GetTextureName(const Texture* texture) const
+{
+    auto it = std::find(m_Targets.begin(), m_Targets.end(), texture);
+    if (it != m_Targets.end())
+        return fmt::format("t{}", it - m_Targets.begin());
+
+    // Textures owned outside of the renderer
+    return fmt::format("ext{:x}", reinterpret_cast<uintptr_t>(texture));
+}
+
+std::string FrameGraph::GetBufferName(const Buffer* buffer) const
+{
+    auto it = std::find(m_Buffers.begin(), m_Buffers.end(), buffer);
+    return fmt::format("b{}", it - m_Buffers.begin());
+}
+
+}
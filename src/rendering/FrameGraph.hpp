@@ -0,0 +1,83 @@
+#pragma once
+
+#include "device/Context.hpp"
+#include "rendering/View.hpp"
+
+namespace lucent
+{
+
+using RenderPass = std::function<void(Context&, View&)>;
+
+//! Resources accessed by a pass, used to order barriers between passes and find the span of passes over which each
+//! render target is alive
+//! Targets whose existing contents are needed (sampled, loaded, blended or partially written) must be listed in reads,
+//! targets listed only in writes are assumed to be completely overwritten by the pass.
+struct PassResources
+{
+    std::vector<Texture*> reads;
+    std::vector<Texture*> writes;
+
+    std::vector<Buffer*> bufferReads;
+    std::vector<Buffer*> bufferWrites;
+};
+
+//! Orders a sequence of render passes by the resources they declare
+//! Compiling the graph culls passes whose results never reach the output, and precomputes the layout transitions and
+//! memory barriers each pass needs so they can be recorded as a single batch before it executes.
+class FrameGraph
+{
+public:
+    //! Adds a pass which does not declare its resources, disabling culling and render target aliasing
+    void AddPass(const char* label, RenderPass pass);
+
+    //! Adds a pass whose accesses are limited to the declared resources
+    void AddPass(const char* label, PassResources resources, RenderPass pass);
+
+    //! Culls unused passes and finds the lifetime of each target, output is read after the final pass
+    void Compile(const std::vector<Texture*>& targets, const Texture* output);
+
+    bool IsCompiled() const;
+
+    //! Inclusive range of passes over which each target passed to Compile must keep its contents
+    const std::vector<TextureLifetime>& GetLifetimes() const;
+
+    //! Records the passes which weren't culled, each in a region labelled and timed by the context
+    void Execute(Context& ctx, View& view);
+
+    //! Human readable summary of passes, their resources and target lifetimes
+    std::string Dump() const;
+
+    //! Graph of passes and resources in Graphviz DOT format
+    std::string DumpGraphviz() const;
+
+    void Clear();
+
+private:
+    struct Node
+    {
+        const char* label;
+        RenderPass execute;
+        PassResources resources;
+        bool declared;
+        bool culled = false;
+
+        // Recorded before the pass executes
+        ResourceTransitions transitions;
+    };
+
+    std::string GetTextureName(const Texture* texture) const;
+    std::string GetBufferName(const Buffer* buffer) const;
+
+private:
+    std::vector<Node> m_Nodes;
+
+    std::vector<Texture*> m_Targets;
+    const Texture* m_Output{};
+    std::vector<const Buffer*> m_Buffers;
+    std::vector<TextureLifetime> m_Lifetimes;
+
+    bool m_Compiled = false;
+    bool m_Aliasing = false;
+};
+
+}
@@ -0,0 +1,158 @@
+#include "GpuProfiler.hpp"
+
+#include "core/Utility.hpp"
+
+namespace lucent
+{
+
+static std::string EscapeCsv(const std::string& text)
+{
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (char c: text)
+    {
+        if (c == '"')
+            escaped += '"';
+        escaped += c;
+    }
+    return escaped;
+}
+
+GpuProfiler::GpuProfiler(uint32 historySize)
+    : m_HistorySize(Max(historySize, 1u))
+{
+}
+
+void GpuProfiler::AddFrame(uint64 frame, const std::vector<RegionTiming>& timings)
+{
+    if (timings.empty())
+        return;
+
+    if (m_Frames.size() == m_HistorySize)
+        m_Frames.pop_front();
+
+    auto& added = m_Frames.emplace_back(Frame{ .index = frame });
+    added.passes.reserve(timings.size());
+    for (auto& timing: timings)
+    {
+        added.passes.push_back(PassTiming{
+            .label = timing.label,
+            .depth = timing.depth,
+            .startMs = timing.startMs,
+            .durationMs = timing.durationMs
+        });
+    }
+}
+
+std::vector<PassTimingStats> GpuProfiler::GetPassStats() const
+{
+    std::vector<PassTimingStats> stats;
+    std::unordered_map<std::string, uint32> indices;
+    std::vector<float> frameTotals;
+    std::vector<bool> timedInFrame;
+
+    for (auto& frame: m_Frames)
+    {
+        // Passes executed more than once in a frame are timed by their total
+        frameTotals.assign(stats.size(), 0.0f);
+        timedInFrame.assign(stats.size(), false);
+        for (auto& pass: frame.passes)
+        {
+            auto[it, added] = indices.try_emplace(pass.label, static_cast<uint32>(stats.size()));
+            if (added)
+            {
+                stats.push_back(PassTimingStats{
+                    .label = pass.label,
+                    .depth = pass.depth,
+                    .minMs = std::numeric_limits<float>::max()
+                });
+                frameTotals.push_back(0.0f);
+                timedInFrame.push_back(false);
+            }
+            frameTotals[it->second] += pass.durationMs;
+            timedInFrame[it->second] = true;
+        }
+
+        for (uint32 i = 0; i < stats.size(); ++i)
+        {
+            if (!timedInFrame[i])
+                continue;
+
+            auto& pass = stats[i];
+            pass.minMs = Min(pass.minMs, frameTotals[i]);
+            pass.maxMs = Max(pass.maxMs, frameTotals[i]);
+            pass.avgMs += frameTotals[i];
+            ++pass.numFrames;
+        }
+    }
+
+    for (auto& pass: stats)
+        pass.avgMs /= static_cast<float>(pass.numFrames);
+
+    return stats;
+}
+
+float GpuProfiler::GetAverageFrameMs() const
+{
+    if (m_Frames.empty())
+        return 0.0f;
+
+    double total = 0.0;
+    for (auto& frame: m_Frames)
+    {
+        auto start = std::numeric_limits<double>::max();
+        auto end = std::numeric_limits<double>::lowest();
+        for (auto& pass: frame.passes)
+        {
+            start = Min(start, pass.startMs);
+            end = Max(end, pass.startMs + pass.durationMs);
+        }
+        total += end - start;
+    }
+    return static_cast<float>(total / static_cast<double>(m_Frames.size()));
+}
+
+std::string GpuProfiler::DumpCsv() const
+{
+    std::string csv = "frame,pass,depth,start_ms,duration_ms\n";
+    for (auto& frame: m_Frames)
+    {
+        auto frameStart = frame.passes.front().startMs;
+        for (auto& pass: frame.passes)
+        {
+            csv += fmt::format("{},\"{}\",{},{:.4f},{:.4f}\n", frame.index, EscapeCsv(pass.label), pass.depth,
+                pass.startMs - frameStart, pass.durationMs);
+        }
+    }
+    return csv;
+}
+
+std::string GpuProfiler::DumpChromeTrace() const
+{
+    std::string json = "{\"traceEvents\":[";
+    if (!m_Frames.empty())
+    {
+        // Offset times to the start of the history, trace timestamps are in microseconds
+        auto origin = m_Frames.front().passes.front().startMs;
+        auto first = true;
+        for (auto& frame: m_Frames)
+        {
+            for (auto& pass: frame.passes)
+            {
+                json += fmt::format("{}\n{{\"name\":\"{}\",\"cat\":\"gpu\",\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f},"
+                    "\"pid\":1,\"tid\":1,\"args\":{{\"frame\":{}}}}}", first ? "" : ",", EscapeJson(pass.label),
+                    (pass.startMs - origin) * 1000.0, pass.durationMs * 1000.0, frame.index);
+                first = false;
+            }
+        }
+    }
+    json += "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return json;
+}
+
+void GpuProfiler::Clear()
+{
+    m_Frames.clear();
+}
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "device/Context.hpp"
+
+namespace lucent
+{
+
+//! Device time of a pass over the frames it was timed in
+struct PassTimingStats
+{
+    std::string label;
+    uint32 depth;
+    uint32 numFrames;
+    float minMs;
+    float avgMs;
+    float maxMs;
+};
+
+//! Keeps the device timings of render passes over a window of recent frames
+//! Timings are read back by each frame context once its previous frame has completed, so lag behind the frame being
+//! recorded by the number of frames in flight.
+class GpuProfiler
+{
+public:
+    static constexpr uint32 kDefaultHistorySize = 120;
+
+    explicit GpuProfiler(uint32 historySize = kDefaultHistorySize);
+
+    //! Adds the region timings of a completed frame, discarding the oldest frame once the history is full
+    void AddFrame(uint64 frame, const std::vector<RegionTiming>& timings);
+
+    //! Statistics of each pass over the history, in the order passes were first timed
+    std::vector<PassTimingStats> GetPassStats() const;
+
+    //! Device time from the start of the first pass to the end of the last, averaged over the history
+    float GetAverageFrameMs() const;
+
+    //! One row per pass per frame, with start times relative to the start of the frame's first pass
+    std::string DumpCsv() const;
+
+    //! Trace event JSON of the history, viewable in chrome://tracing or Perfetto
+    std::string DumpChromeTrace() const;
+
+    void Clear();
+
+private:
+    struct PassTiming
+    {
+        std::string label;
+        uint32 depth;
+        double startMs;
+        float durationMs;
+    };
+
+    struct Frame
+    {
+        uint64 index;
+        std::vector<PassTiming> passes;
+    };
+
+private:
+    uint32 m_HistorySize;
+    std::deque<Frame> m_Frames;
+};
+
+}
@@ -0,0 +1,551 @@
+#include "IndirectDrawList.hpp"
+
+#include "core/Hash.hpp"
+
+namespace lucent
+{
+
+// Must match the local size of CullInstances.shader, which is also the number of batches compacted together
+static constexpr uint32 kCullGroupSize = 64;
+static constexpr uint32 kMaxDrawGroups = IndirectDrawList::kMaxBatches / kCullGroupSize;
+
+struct DrawCommand
+{
+    uint32 indexCount;
+    uint32 instanceCount;
+    uint32 firstIndex;
+    int32 vertexOffset;
+    uint32 firstInstance;
+};
+
+static_assert(sizeof(CullingStats) == 5 * sizeof(uint32), "Must match the counters of CullInstances.shader");
+
+IndirectDrawList::IndirectDrawList(Renderer& renderer, uint32 numViews, bool occlusionCulling)
+    : m_Device(renderer.GetDevice())
+    , m_NumViews(numViews)
+    , m_OcclusionCulling(occlusionCulling)
+{
+    LC_ASSERT(numViews > 0 && numViews <= kMaxViews);
+
+    std::vector<std::string_view> defines;
+    if (occlusionCulling)
+        defines.emplace_back("OCCLUSION");
+
+    bool drawCount = m_Device->SupportsIndirectDrawCount();
+    if (drawCount)
+        defines.emplace_back("DRAW_COUNT");
+
+    m_CullPipeline = renderer.AddPipeline(PipelineSettings{
+        .shaderName = "CullInstances.shader",
+        .shaderDefines = defines,
+        .type = PipelineType::kCompute
+    });
+
+    // Instance data is rewritten every frame, so each frame in flight needs its own copy
+    for (uint32 i = 0; i < renderer.GetSettings().framesInFlight; ++i)
+    {
+        auto& frame = m_Frames.emplace_back(FrameBuffers{
+            .instances = m_Device->CreateBuffer(BufferType::kStorage, kMaxInstances * sizeof(InstanceData)),
+            .batches = m_Device->CreateBuffer(BufferType::kStorage, kMaxBatches * sizeof(BatchData)),
+            .stats = m_Device->CreateBuffer(BufferType::kStorage, sizeof(CullingStats))
+        });
+        frame.instances->Map();
+        frame.batches->Map();
+
+        memset(frame.stats->Map(), 0, sizeof(CullingStats));
+        frame.stats->Flush(sizeof(CullingStats), 0);
+    }
+
+    m_Commands = m_Device->CreateBuffer(BufferType::kIndirect, kMaxViews * kMaxBatches * sizeof(DrawCommand));
+    m_VisibleInstances = m_Device->CreateBuffer(BufferType::kDeviceStorage,
+        kMaxViews * kMaxInstances * sizeof(uint32));
+    m_Occluded = m_Device->CreateBuffer(BufferType::kDeviceStorage, kMaxInstances * sizeof(uint32));
+
+    if (drawCount)
+        m_DrawCounts = m_Device->CreateBuffer(BufferType::kIndirect, kMaxViews * kMaxDrawGroups * sizeof(uint32));
+}
+
+IndirectDrawList::~IndirectDrawList()
+{
+    for (auto& frame: m_Frames)
+    {
+        m_Device->DestroyBuffer(frame.instances);
+        m_Device->DestroyBuffer(frame.batches);
+        m_Device->DestroyBuffer(frame.stats);
+    }
+    m_Device->DestroyBuffer(m_Commands);
+    m_Device->DestroyBuffer(m_VisibleInstances);
+    m_Device->DestroyBuffer(m_Occluded);
+    if (m_DrawCounts)
+        m_Device->DestroyBuffer(m_DrawCounts);
+}
+
+std::vector<Buffer*> IndirectDrawList::GetCullOutputs() const
+{
+    std::vector<Buffer*> outputs = { m_Commands, m_VisibleInstances };
+    if (m_DrawCounts)
+        outputs.push_back(m_DrawCounts);
+    return outputs;
+}
+
+void IndirectDrawList::Gather(Scene& scene, MaterialTable* materials)
+{
+    LC_PROFILE_ZONE("IndirectDrawList::Gather");
+
+    m_FrameIndex = (m_FrameIndex + 1) % m_Frames.size();
+    auto& frame = m_Frames[m_FrameIndex];
+
+    // The commands of the last frame to use these buffers have completed, so its counters are final
+    auto counts = frame.stats->Map();
+    frame.stats->Invalidate(sizeof(CullingStats), 0);
+    memcpy(&m_Stats, counts, sizeof(CullingStats));
+    memset(counts, 0, sizeof(CullingStats));
+    frame.stats->Flush(sizeof(CullingStats), 0);
+
+    // Refreshes moved material records first, so the indices looked up below are current
+    auto materialGeneration = materials ? materials->GetGeneration() : 0;
+
+    m_ChangedEntities.clear();
+    bool rebuild = &scene != m_Scene || !scene.GetChangedEntities(m_SceneVersion, m_ChangedEntities);
+
+    // Instances which overflowed aren't tracked, so any change which could affect them rebuilds the list
+    if (!rebuild && !m_Overflow.empty())
+    {
+        rebuild = materialGeneration != m_MaterialGeneration || std::any_of(m_ChangedEntities.begin(),
+            m_ChangedEntities.end(), [&](EntityID id)
+            { return IsTracked(id) || scene.Find(id).Has<ModelInstance>(); });
+    }
+
+    if (rebuild)
+    {
+        Rebuild(scene, materials);
+    }
+    else
+    {
+        for (auto id: m_ChangedEntities)
+            UpdateEntity(scene, id, materials);
+
+        if (materials && materialGeneration != m_MaterialGeneration)
+            RefreshMaterialIndices(*materials);
+    }
+
+    m_Scene = &scene;
+    m_SceneVersion = scene.GetVersion();
+    m_MaterialGeneration = materialGeneration;
+
+    WriteFrame(frame);
+}
+
+void IndirectDrawList::Rebuild(Scene& scene, MaterialTable* materials)
+{
+    LC_PROFILE_ZONE("IndirectDrawList::Rebuild");
+
+    m_Instances.clear();
+    m_InstanceEntities.clear();
+    m_Entities.clear();
+    m_Batches.clear();
+    m_BatchMaterialIndices.clear();
+    m_BatchCounts.clear();
+    m_FreeBatches.clear();
+    m_BatchIndices.clear();
+    m_Overflow.clear();
+    m_OverflowBounds.Clear();
+
+    for (auto& frame: m_Frames)
+    {
+        frame.instancesDirty = true;
+        frame.dirtyInstances.clear();
+    }
+
+    scene.Each<ModelInstance, Transform>([&](Entity entity, const ModelInstance& instance, const Transform& local)
+    {
+        AddEntity(entity.id, instance, local, materials);
+    });
+    MarkBatchesDirty();
+}
+
+bool IndirectDrawList::IsTracked(EntityID entity) const
+{
+    if (entity.index >= m_Entities.size())
+        return false;
+
+    auto& entry = m_Entities[entity.index];
+    return entry.model && entry.entity == entity;
+}
+
+void IndirectDrawList::UpdateEntity(Scene& scene, EntityID id, MaterialTable* materials)
+{
+    // Instances of an earlier entity with the same index whose destruction went unseen
+    if (id.index < m_Entities.size() && m_Entities[id.index].model && !(m_Entities[id.index].entity == id))
+        RemoveEntity(m_Entities[id.index]);
+
+    bool tracked = IsTracked(id);
+    auto entity = scene.Find(id);
+    if (!entity.Has<ModelInstance>() || !entity.Has<Transform>())
+    {
+        if (tracked)
+            RemoveEntity(m_Entities[id.index]);
+        return;
+    }
+
+    auto& instance = entity.Get<ModelInstance>();
+    auto& local = entity.Get<Transform>();
+
+    // The same primitives in the same batches, so only the transform needs updating
+    if (tracked)
+    {
+        auto& entry = m_Entities[id.index];
+        if (entry.model == instance.model && entry.material == instance.material && !entry.overflowed)
+        {
+            for (auto slot: entry.slots)
+            {
+                m_Instances[slot].model = local.model;
+                MarkInstanceDirty(slot);
+            }
+            return;
+        }
+        RemoveEntity(entry);
+    }
+
+    AddEntity(id, instance, local, materials);
+}
+
+void IndirectDrawList::AddEntity(EntityID id, const ModelInstance& instance, const Transform& local,
+    MaterialTable* materials)
+{
+    if (m_Entities.size() <= id.index)
+        m_Entities.resize(id.index + 1);
+
+    auto& entry = m_Entities[id.index];
+    entry = EntityInstances{ .entity = id, .model = instance.model, .material = instance.material };
+
+    for (auto& primitive: *instance.model)
+    {
+        auto material = instance.material ? instance.material : primitive.material;
+        auto materialIndex = materials ? materials->GetIndex(material) : 0;
+        auto batch = Batch{ &primitive.mesh, materials ? material : nullptr };
+
+        // Instances beyond the size of the buffers are left for the caller to draw directly
+        auto it = m_BatchIndices.find(batch);
+        bool batchesFull = m_FreeBatches.empty() && m_Batches.size() == kMaxBatches;
+        if (m_Instances.size() == kMaxInstances || (it == m_BatchIndices.end() && batchesFull))
+        {
+            if (!m_OverflowLogged)
+            {
+                LC_WARN("Indirect draw list is full ({} instances, {} batches), drawing the rest directly",
+                    kMaxInstances, kMaxBatches);
+                m_OverflowLogged = true;
+            }
+            m_Overflow.push_back({ &primitive.mesh, material, materialIndex, local.model });
+            m_OverflowBounds.Add(primitive.mesh, local.model);
+            entry.overflowed = true;
+            continue;
+        }
+
+        if (it == m_BatchIndices.end())
+        {
+            uint32 index;
+            if (!m_FreeBatches.empty())
+            {
+                index = m_FreeBatches.back();
+                m_FreeBatches.pop_back();
+                m_Batches[index] = batch;
+                m_BatchMaterialIndices[index] = materialIndex;
+            }
+            else
+            {
+                index = static_cast<uint32>(m_Batches.size());
+                m_Batches.push_back(batch);
+                m_BatchMaterialIndices.push_back(materialIndex);
+                m_BatchCounts.push_back(0);
+            }
+            it = m_BatchIndices.emplace(batch, index).first;
+        }
+
+        auto slot = static_cast<uint32>(m_Instances.size());
+        m_Instances.push_back(InstanceData{
+            .model = local.model,
+            .batch = it->second,
+            .materialIndex = materialIndex
+        });
+        m_InstanceEntities.push_back(id.index);
+        m_BatchCounts[it->second]++;
+
+        entry.slots.push_back(slot);
+        MarkInstanceDirty(slot);
+    }
+    MarkBatchesDirty();
+}
+
+void IndirectDrawList::RemoveEntity(EntityInstances& entry)
+{
+    // Removing an instance may move one of the entry's later instances into its slot
+    while (!entry.slots.empty())
+    {
+        auto slot = entry.slots.back();
+        entry.slots.pop_back();
+        RemoveInstance(slot);
+    }
+    entry = EntityInstances{};
+    MarkBatchesDirty();
+}
+
+void IndirectDrawList::RemoveInstance(uint32 slot)
+{
+    auto batch = m_Instances[slot].batch;
+    if (--m_BatchCounts[batch] == 0)
+    {
+        m_BatchIndices.erase(m_Batches[batch]);
+        m_Batches[batch] = Batch{};
+        m_FreeBatches.push_back(batch);
+    }
+
+    // Keep instances contiguous by moving the last one into the slot
+    auto last = static_cast<uint32>(m_Instances.size() - 1);
+    if (slot != last)
+    {
+        m_Instances[slot] = m_Instances[last];
+        m_InstanceEntities[slot] = m_InstanceEntities[last];
+
+        auto& slots = m_Entities[m_InstanceEntities[slot]].slots;
+        *std::find(slots.begin(), slots.end(), last) = slot;
+        MarkInstanceDirty(slot);
+    }
+    m_Instances.pop_back();
+    m_InstanceEntities.pop_back();
+}
+
+void IndirectDrawList::RefreshMaterialIndices(MaterialTable& materials)
+{
+    std::vector<bool> moved(m_Batches.size());
+    bool anyMoved = false;
+    for (uint32 i = 0; i < m_Batches.size(); ++i)
+    {
+        if (!m_Batches[i].mesh)
+            continue;
+
+        auto index = materials.GetIndex(m_Batches[i].material);
+        if (index != m_BatchMaterialIndices[i])
+        {
+            m_BatchMaterialIndices[i] = index;
+            moved[i] = anyMoved = true;
+        }
+    }
+
+    if (!anyMoved)
+        return;
+
+    for (uint32 slot = 0; slot < m_Instances.size(); ++slot)
+    {
+        auto& instance = m_Instances[slot];
+        if (moved[instance.batch])
+        {
+            instance.materialIndex = m_BatchMaterialIndices[instance.batch];
+            MarkInstanceDirty(slot);
+        }
+    }
+}
+
+void IndirectDrawList::MarkInstanceDirty(uint32 slot)
+{
+    for (auto& frame: m_Frames)
+    {
+        if (frame.instancesDirty)
+            continue;
+
+        // Past as many changes as there are instances, writing them all is cheaper than tracking more
+        if (frame.dirtyInstances.size() >= m_Instances.size())
+        {
+            frame.instancesDirty = true;
+            frame.dirtyInstances.clear();
+            continue;
+        }
+        frame.dirtyInstances.push_back(slot);
+    }
+}
+
+void IndirectDrawList::MarkBatchesDirty()
+{
+    for (auto& frame: m_Frames)
+        frame.batchesDirty = true;
+}
+
+void IndirectDrawList::WriteFrame(FrameBuffers& frame)
+{
+    auto numInstances = static_cast<uint32>(m_Instances.size());
+    auto instances = static_cast<InstanceData*>(frame.instances->Map());
+    if (frame.instancesDirty)
+    {
+        memcpy(instances, m_Instances.data(), numInstances * sizeof(InstanceData));
+        frame.instances->Flush(numInstances * sizeof(InstanceData), 0);
+    }
+    else if (!frame.dirtyInstances.empty())
+    {
+        uint32 first = numInstances;
+        uint32 end = 0;
+        for (auto slot: frame.dirtyInstances)
+        {
+            // Instances removed since they changed
+            if (slot >= numInstances)
+                continue;
+
+            instances[slot] = m_Instances[slot];
+            first = std::min(first, slot);
+            end = std::max(end, slot + 1);
+        }
+        if (first < end)
+            frame.instances->Flush((end - first) * sizeof(InstanceData), first * sizeof(InstanceData));
+    }
+    frame.instancesDirty = false;
+    frame.dirtyInstances.clear();
+
+    if (!frame.batchesDirty)
+        return;
+
+    // Each batch's instances are given a range of the visible instances, unused batches an empty one
+    auto batches = static_cast<BatchData*>(frame.batches->Map());
+    uint32 firstInstance = 0;
+    for (uint32 i = 0; i < m_Batches.size(); ++i)
+    {
+        batches[i] = BatchData{ .firstInstance = firstInstance };
+        if (auto mesh = m_Batches[i].mesh)
+        {
+            batches[i].bounds = Vector4(mesh->boundsCenter, mesh->boundsRadius);
+            batches[i].indexCount = mesh->geometry.numIndices;
+            batches[i].firstIndex = mesh->geometry.firstIndex;
+            batches[i].vertexOffset = static_cast<int32>(mesh->geometry.firstVertex);
+        }
+        firstInstance += m_BatchCounts[i];
+    }
+    frame.batches->Flush(m_Batches.size() * sizeof(BatchData), 0);
+    frame.batchesDirty = false;
+}
+
+void IndirectDrawList::Cull(Context& ctx, uint32 view, const Matrix4& viewProjection, bool cullDepth)
+{
+    LC_ASSERT(!m_OcclusionCulling);
+    Dispatch(ctx, view, viewProjection, cullDepth, CullPhase::kFrustum, nullptr);
+}
+
+void IndirectDrawList::CullEarly(Context& ctx, uint32 view, const Matrix4& viewProjection, const Texture* hiZ)
+{
+    LC_ASSERT(m_OcclusionCulling);
+
+    // Nothing is occluded until a Hi-Z has been built, which also leaves nothing for the late phase
+    auto phase = m_HasOcclusionHistory ? CullPhase::kEarly : CullPhase::kFrustum;
+    Dispatch(ctx, view, viewProjection, true, phase, hiZ);
+}
+
+void IndirectDrawList::CullLate(Context& ctx, uint32 view, const Matrix4& viewProjection, const Texture* hiZ)
+{
+    LC_ASSERT(m_OcclusionCulling);
+
+    m_OcclusionViewProjection = viewProjection;
+    m_HasOcclusionHistory = true;
+    Dispatch(ctx, view, viewProjection, true, CullPhase::kLate, hiZ);
+}
+
+const CullingStats& IndirectDrawList::GetStats() const
+{
+    return m_Stats;
+}
+
+uint32 IndirectDrawList::GetNumBatches() const
+{
+    return m_Batches.size();
+}
+
+const std::vector<IndirectDrawList::OverflowDraw>& IndirectDrawList::GetOverflow() const
+{
+    return m_Overflow;
+}
+
+const BoundsList& IndirectDrawList::GetOverflowBounds() const
+{
+    return m_OverflowBounds;
+}
+
+void IndirectDrawList::BindInstances(Context& ctx) const
+{
+    ctx.BindBuffer("Instances"_id, m_Frames[m_FrameIndex].instances);
+    ctx.BindBuffer("VisibleInstances"_id, m_VisibleInstances);
+}
+
+void IndirectDrawList::Draw(Context& ctx, uint32 view, uint32 firstBatch, uint32 endBatch) const
+{
+    if (firstBatch == endBatch)
+        return;
+
+    // Every mesh is in the geometry arena, so the commands of all batches in the range are drawn at once
+    m_Device->GetGeometryArena()->Bind(ctx);
+
+    if (!m_DrawCounts)
+    {
+        ctx.DrawIndirect(m_Commands, (view * kMaxBatches + firstBatch) * sizeof(DrawCommand), endBatch - firstBatch);
+        return;
+    }
+
+    // Each group's visible commands were compacted to the start of its range
+    auto numBatches = static_cast<uint32>(m_Batches.size());
+    auto endGroup = (endBatch + kCullGroupSize - 1) / kCullGroupSize;
+    for (auto group = (firstBatch + kCullGroupSize - 1) / kCullGroupSize; group < endGroup; ++group)
+    {
+        auto groupBatch = group * kCullGroupSize;
+        ctx.DrawIndirectCount(m_Commands, (view * kMaxBatches + groupBatch) * sizeof(DrawCommand),
+            m_DrawCounts, (view * kMaxDrawGroups + group) * sizeof(uint32),
+            std::min(kCullGroupSize, numBatches - groupBatch));
+    }
+}
+
+void IndirectDrawList::Dispatch(Context& ctx, uint32 view, const Matrix4& viewProjection, bool cullDepth,
+    CullPhase phase, const Texture* hiZ)
+{
+    LC_ASSERT(view < m_NumViews);
+    auto& frame = m_Frames[m_FrameIndex];
+
+    ctx.BindPipeline(m_CullPipeline);
+    ctx.BindBuffer("Batches"_id, frame.batches);
+    ctx.BindBuffer("Instances"_id, frame.instances);
+    ctx.BindBuffer("Commands"_id, m_Commands);
+    ctx.BindBuffer("VisibleInstances"_id, m_VisibleInstances);
+    ctx.BindBuffer("Occluded"_id, m_Occluded);
+    ctx.BindBuffer("Stats"_id, frame.stats);
+    if (hiZ)
+        ctx.BindTexture("u_HiZ"_id, hiZ);
+    if (m_DrawCounts)
+        ctx.BindBuffer("DrawCounts"_id, m_DrawCounts);
+
+    // Uniforms are reset after each dispatch
+    auto bindUniforms = [&](CullStep step)
+    {
+        ctx.Uniform("u_ViewProjection"_id, viewProjection);
+        ctx.Uniform("u_OcclusionViewProjection"_id, m_OcclusionViewProjection);
+        ctx.Uniform("u_View"_id, view);
+        ctx.Uniform("u_NumInstances"_id, static_cast<uint32>(m_Instances.size()));
+        ctx.Uniform("u_NumBatches"_id, static_cast<uint32>(m_Batches.size()));
+        ctx.Uniform("u_CullDepth"_id, static_cast<uint32>(cullDepth));
+        ctx.Uniform("u_Step"_id, static_cast<uint32>(step));
+        ctx.Uniform("u_Phase"_id, static_cast<uint32>(phase));
+    };
+
+    // Reset the instance count of every command, then append visible instances
+    auto numBatchGroups = (static_cast<uint32>(m_Batches.size()) + kCullGroupSize - 1) / kCullGroupSize;
+    bindUniforms(CullStep::kReset);
+    ctx.Dispatch(numBatchGroups, 1, 1);
+
+    bindUniforms(CullStep::kInstances);
+    ctx.Dispatch((static_cast<uint32>(m_Instances.size()) + kCullGroupSize - 1) / kCullGroupSize, 1, 1);
+
+    if (m_DrawCounts)
+    {
+        bindUniforms(CullStep::kCompact);
+        ctx.Dispatch(numBatchGroups, 1, 1);
+    }
+}
+
+size_t IndirectDrawList::BatchHash::operator()(const Batch& batch) const
+{
+    return HashBytes(batch.material, HashBytes<size_t>(batch.mesh));
+}
+
+}
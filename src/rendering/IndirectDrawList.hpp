@@ -0,0 +1,211 @@
+#pragma once
+
+#include "rendering/Culling.hpp"
+#include "rendering/MaterialTable.hpp"
+#include "rendering/Renderer.hpp"
+#include "scene/ModelInstance.hpp"
+#include "scene/Transform.hpp"
+
+namespace lucent
+{
+
+//! Draws every model instance in a scene using indirect commands written by a culling compute shader
+//! Instances are grouped into one batch per mesh and material, and the commands of every batch are recorded as a
+//! single indirect draw. Where the device can read the number of draws from a buffer, the commands of batches without
+//! visible instances are compacted away in groups of batches and each group is drawn with its count.
+//! Each view is culled against its own frustum and has its own set of commands, so one list can be shared by several
+//! render passes (e.g. shadow cascades).
+//! Lists created with occlusion culling also test instances against a farthest depth pyramid in two phases: the early
+//! phase draws what was visible in the previous frame's pyramid, the late phase draws what was hidden there but is
+//! visible in the pyramid built from the early phase's depth.
+class IndirectDrawList
+{
+public:
+    // Must match Instances.shader
+    static constexpr uint32 kMaxInstances = 128 * 1024;
+    static constexpr uint32 kMaxBatches = 4096;
+    static constexpr uint32 kMaxViews = 4;
+
+    IndirectDrawList(Renderer& renderer, uint32 numViews, bool occlusionCulling = false);
+    ~IndirectDrawList();
+
+    IndirectDrawList(const IndirectDrawList&) = delete;
+    IndirectDrawList& operator=(const IndirectDrawList&) = delete;
+
+    //! Buffers written by Cull and read by Draw, which the passes calling them must declare
+    std::vector<Buffer*> GetCullOutputs() const;
+
+    //! Updates the instances to draw this frame, looking up materials only if a table is given
+    //! Instance data is kept between frames, and only the entities the scene reports as changed are gathered again.
+    //! Must be called once per frame before culling, as instance data is buffered per frame in flight.
+    void Gather(Scene& scene, MaterialTable* materials = nullptr);
+
+    //! Records the dispatches writing the draw commands for a view, outside of any render pass
+    //! Views rendered with depth clamping should not be culled by depth, as geometry outside their depth range is
+    //! still drawn.
+    void Cull(Context& ctx, uint32 view, const Matrix4& viewProjection, bool cullDepth = true);
+
+    //! Culls against the frustum and the Hi-Z built by the last frame's CullLate, or only the frustum without one
+    void CullEarly(Context& ctx, uint32 view, const Matrix4& viewProjection, const Texture* hiZ);
+
+    //! Writes the commands of a separate view drawing the instances occluded in CullEarly but not in the given Hi-Z
+    //! The Hi-Z is kept as the history of the next frame's early phase.
+    void CullLate(Context& ctx, uint32 view, const Matrix4& viewProjection, const Texture* hiZ);
+
+    //! Counters of the last frame to use this frame's buffers, lagging behind by the number of frames in flight
+    const CullingStats& GetStats() const;
+
+    uint32 GetNumBatches() const;
+
+    //! Instance which didn't fit in the list's buffers, and isn't culled or drawn by it
+    struct OverflowDraw
+    {
+        const StaticMesh* mesh;
+        Material* material;
+        uint32 materialIndex;
+        Matrix4 model;
+    };
+
+    //! Instances gathered this frame beyond kMaxInstances or kMaxBatches, which the caller must draw directly
+    const std::vector<OverflowDraw>& GetOverflow() const;
+
+    //! World bounds of GetOverflow(), in the same order, which are only recomputed when the overflow changes
+    const BoundsList& GetOverflowBounds() const;
+
+    //! Binds the instance buffers read through GetInstance() in Instances.shader to the bound pipeline
+    void BindInstances(Context& ctx) const;
+
+    //! Records the indirect draws for a range of batches [firstBatch, endBatch) of a view
+    //! With draw counts, both ends of the range are rounded up to whole groups of batches, so the ranges drawn for a
+    //! view must together cover [0, GetNumBatches()) with shared ends for every batch to be drawn once.
+    void Draw(Context& ctx, uint32 view, uint32 firstBatch, uint32 endBatch) const;
+
+private:
+    struct InstanceData
+    {
+        Matrix4 model;
+        uint32 batch;
+        uint32 materialIndex;
+        uint32 padding[2];
+    };
+
+    struct BatchData
+    {
+        Vector4 bounds;
+        uint32 indexCount;
+        uint32 firstInstance;
+        uint32 firstIndex;
+        int32 vertexOffset;
+    };
+
+    // Must match CullInstances.shader
+    enum class CullPhase : uint32
+    {
+        kFrustum,
+        kEarly,
+        kLate
+    };
+
+    enum class CullStep : uint32
+    {
+        kReset,
+        kInstances,
+        kCompact
+    };
+
+    // Unused batches have no mesh
+    struct Batch
+    {
+        const StaticMesh* mesh;
+        Material* material;
+
+        bool operator==(const Batch& rhs) const = default;
+    };
+
+    struct BatchHash
+    {
+        size_t operator()(const Batch& batch) const;
+    };
+
+    // Written by the host, each frame's copy is brought up to date with the changes since it was last written
+    struct FrameBuffers
+    {
+        Buffer* instances;
+        Buffer* batches;
+        Buffer* stats;
+
+        std::vector<uint32> dirtyInstances;
+        bool instancesDirty = true;
+        bool batchesDirty = true;
+    };
+
+    // Instances of an entity's model, in the order of its primitives unless some overflowed
+    struct EntityInstances
+    {
+        EntityID entity;
+        Model* model;
+        Material* material;
+        std::vector<uint32> slots;
+        bool overflowed;
+    };
+
+private:
+    void Rebuild(Scene& scene, MaterialTable* materials);
+    bool IsTracked(EntityID entity) const;
+    void UpdateEntity(Scene& scene, EntityID entity, MaterialTable* materials);
+    void AddEntity(EntityID entity, const ModelInstance& instance, const Transform& local, MaterialTable* materials);
+    void RemoveEntity(EntityInstances& entry);
+    void RemoveInstance(uint32 slot);
+    void RefreshMaterialIndices(MaterialTable& materials);
+
+    void MarkInstanceDirty(uint32 slot);
+    void MarkBatchesDirty();
+    void WriteFrame(FrameBuffers& frame);
+
+    void Dispatch(Context& ctx, uint32 view, const Matrix4& viewProjection, bool cullDepth, CullPhase phase,
+        const Texture* hiZ);
+
+private:
+    Device* m_Device;
+    Pipeline* m_CullPipeline;
+    uint32 m_NumViews;
+    bool m_OcclusionCulling;
+
+    std::vector<FrameBuffers> m_Frames;
+    uint32 m_FrameIndex = 0;
+
+    // Written by the culling shader
+    Buffer* m_Commands;
+    Buffer* m_VisibleInstances;
+    Buffer* m_Occluded;
+    Buffer* m_DrawCounts = nullptr; // Only with draw count support
+
+    // View projection of the Hi-Z tested by the next occlusion phase
+    Matrix4 m_OcclusionViewProjection;
+    bool m_HasOcclusionHistory = false;
+
+    CullingStats m_Stats{};
+
+    // Versions of the scene and material table the resident instances were last updated to
+    Scene* m_Scene = nullptr;
+    uint64 m_SceneVersion = 0;
+    uint64 m_MaterialGeneration = 0;
+    std::vector<EntityID> m_ChangedEntities;
+
+    // Instances in no particular order, culling sorts them into the range of their batch
+    std::vector<InstanceData> m_Instances;
+    std::vector<uint32> m_InstanceEntities;
+    std::vector<EntityInstances> m_Entities; // Indexed by entity index
+
+    std::vector<Batch> m_Batches;
+    std::vector<uint32> m_BatchMaterialIndices;
+    std::vector<uint32> m_BatchCounts;
+    std::vector<uint32> m_FreeBatches;
+    std::unordered_map<Batch, uint32, BatchHash> m_BatchIndices;
+
+    std::vector<OverflowDraw> m_Overflow;
+    BoundsList m_OverflowBounds;
+    bool m_OverflowLogged = false;
+};
+
+}
@@ -5,6 +5,22 @@
 namespace lucent
 {
 
+//! Material parameters as read by shaders from a MaterialTable, textures are indices into the global texture array
+//! Layout must match MaterialData in GeometryPass.shader (std430)
+struct MaterialData
+{
+    Color baseColorFactor;
+    float metallicFactor;
+    float roughnessFactor;
+    float emissiveFactor;
+    uint32 baseColorMap;
+    uint32 metalRoughMap;
+    uint32 normalMap;
+    uint32 emissiveMap;
+    uint32 padding;
+};
+static_assert(sizeof(MaterialData) == 48);
+
 //! Interface exposing a shader bound with specific textures and uniforms
 // TODO: Shader interface is programmatic at the moment but could be made more data driven
 class Material
@@ -17,6 +33,12 @@ public:
     virtual Pipeline* GetPipeline() = 0;
 
     virtual void BindUniforms(Context& context) {}
+
+    //! Fills the record for the material in a MaterialTable, returns false if the material can't be drawn bindless
+    virtual bool GetMaterialData(Device& device, MaterialData& data) { return false; }
+
+    //! Appends the textures sampled by the material
+    virtual void GetTextures(std::vector<Texture*>& textures) const {}
 };
 
 }
@@ -0,0 +1,84 @@
+#include "MaterialTable.hpp"
+
+namespace lucent
+{
+
+MaterialTable::MaterialTable(Device* device)
+    : m_Device(device)
+    , m_BindlessGeneration(device->GetBindlessGeneration())
+{
+    m_Buffer = m_Device->CreateBuffer(BufferType::kStorage, kMaxMaterials * sizeof(MaterialData));
+}
+
+MaterialTable::~MaterialTable()
+{
+    m_Device->DestroyBuffer(m_Buffer);
+}
+
+uint32 MaterialTable::GetIndex(Material* material)
+{
+    if (m_BindlessGeneration != m_Device->GetBindlessGeneration())
+        RefreshRecords();
+
+    auto it = m_Records.find(material);
+    if (it != m_Records.end())
+        return it->second.index;
+
+    MaterialData data{};
+    bool supported = material->GetMaterialData(*m_Device, data);
+    LC_ASSERT(supported);
+
+    auto index = WriteRecord(data);
+    m_Records.emplace(material, Record{ index, data });
+    return index;
+}
+
+uint64 MaterialTable::GetGeneration()
+{
+    if (m_BindlessGeneration != m_Device->GetBindlessGeneration())
+        RefreshRecords();
+
+    return m_Generation;
+}
+
+uint32 MaterialTable::WriteRecord(const MaterialData& data)
+{
+    uint32 index;
+    if (!m_FreeRecords->empty())
+    {
+        index = m_FreeRecords->back();
+        m_FreeRecords->pop_back();
+    }
+    else
+    {
+        LC_ASSERT(m_NumRecords < kMaxMaterials);
+        index = m_NumRecords++;
+    }
+
+    // Only unused records are written, so the buffer can be updated while earlier frames are still reading it
+    m_Buffer->Upload(&data, sizeof(MaterialData), index * sizeof(MaterialData));
+    return index;
+}
+
+void MaterialTable::RefreshRecords()
+{
+    LC_PROFILE_ZONE("MaterialTable::RefreshRecords");
+    m_BindlessGeneration = m_Device->GetBindlessGeneration();
+
+    for (auto&[material, record]: m_Records)
+    {
+        MaterialData data{};
+        material->GetMaterialData(*m_Device, data);
+        if (std::memcmp(&data, &record.data, sizeof(MaterialData)) == 0)
+            continue;
+
+        // Earlier frames in flight keep reading the old record until they complete
+        m_Device->DeferRelease([freeRecords = m_FreeRecords, index = record.index]()
+        { freeRecords->push_back(index); });
+
+        record = Record{ WriteRecord(data), data };
+        ++m_Generation;
+    }
+}
+
+}
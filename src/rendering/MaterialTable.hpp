@@ -0,0 +1,55 @@
+#pragma once
+
+#include "device/Device.hpp"
+#include "rendering/Material.hpp"
+
+namespace lucent
+{
+
+//! Storage buffer of MaterialData records, indexed by shaders using the global texture array
+//! Records are written once when a material is first drawn, so materials must not change after that point. When
+//! textures move to new indices in the global array, affected materials are given new records instead of rewriting
+//! those earlier frames may still be reading, so indices must be fetched again whenever the table's generation changes.
+class MaterialTable
+{
+public:
+    static constexpr uint32 kMaxMaterials = 4096;
+
+    explicit MaterialTable(Device* device);
+    ~MaterialTable();
+
+    MaterialTable(const MaterialTable&) = delete;
+    MaterialTable& operator=(const MaterialTable&) = delete;
+
+    //! Returns the index of the material's record, adding it to the table on first use
+    uint32 GetIndex(Material* material);
+
+    //! Changes whenever materials already in the table are given new records
+    uint64 GetGeneration();
+
+    Buffer* GetBuffer() const { return m_Buffer; }
+
+private:
+    struct Record
+    {
+        uint32 index;
+        MaterialData data;
+    };
+
+    uint32 WriteRecord(const MaterialData& data);
+    void RefreshRecords();
+
+private:
+    Device* m_Device;
+    Buffer* m_Buffer;
+    std::unordered_map<Material*, Record> m_Records;
+
+    uint32 m_NumRecords = 0;
+    uint64 m_BindlessGeneration = 0;
+    uint64 m_Generation = 0;
+
+    // Shared with deferred releases, which may run after the table is destroyed
+    std::shared_ptr<std::vector<uint32>> m_FreeRecords = std::make_shared<std::vector<uint32>>();
+};
+
+}
@@ -1,6 +1,7 @@
 #include "rendering/PbrMaterial.hpp"
 
 #include "device/Context.hpp"
+#include "device/Device.hpp"
 
 namespace lucent
 {
@@ -18,6 +19,26 @@ void PbrMaterial::BindUniforms(Context& ctx)
     ctx.Uniform("u_EmissiveFactor"_id, emissiveFactor);
 }
 
+bool PbrMaterial::GetMaterialData(Device& device, MaterialData& data)
+{
+    data = MaterialData{
+        .baseColorFactor = baseColorFactor,
+        .metallicFactor = metallicFactor,
+        .roughnessFactor = roughnessFactor,
+        .emissiveFactor = emissiveFactor,
+        .baseColorMap = device.AddBindlessTexture(baseColorMap),
+        .metalRoughMap = device.AddBindlessTexture(metalRough),
+        .normalMap = device.AddBindlessTexture(normalMap),
+        .emissiveMap = device.AddBindlessTexture(emissive)
+    };
+    return true;
+}
+
+void PbrMaterial::GetTextures(std::vector<Texture*>& textures) const
+{
+    textures.insert(textures.end(), { baseColorMap, metalRough, normalMap, aoMap, emissive });
+}
+
 PbrMaterial* PbrMaterial::Clone()
 {
     // TODO: Implement
@@ -16,6 +16,10 @@ public:
 
     void BindUniforms(Context& context) override;
 
+    bool GetMaterialData(Device& device, MaterialData& data) override;
+
+    void GetTextures(std::vector<Texture*>& textures) const override;
+
 public:
     Color baseColorFactor = { 1.0f, 1.0f, 1.0f, 1.0f };
     float metallicFactor = 1.0f;
@@ -10,6 +10,16 @@ std::pair<uint32, uint32> RenderSettings::ComputeGroupCount(uint32 width, uint32
     return { x, y };
 }
 
+TextureFormat RenderSettings::GetHdrFormat() const
+{
+    return fullPrecision ? TextureFormat::kRGBA32F : TextureFormat::kRGBA16F;
+}
+
+std::string_view RenderSettings::GetHdrFormatDefine() const
+{
+    return fullPrecision ? "HDR_FORMAT rgba32f" : "HDR_FORMAT rgba16f";
+}
+
 
 // Default mesh helpers:
 
@@ -10,6 +10,12 @@ struct RenderSettings
 public:
     std::pair<uint32, uint32> ComputeGroupCount(uint32 width, uint32 height) const;
 
+    //! Format of render targets holding HDR color, half floats unless full precision is forced
+    TextureFormat GetHdrFormat() const;
+
+    //! Defines HDR_FORMAT as the shader image format of GetHdrFormat, for compute shaders writing HDR color
+    std::string_view GetHdrFormatDefine() const;
+
     void InitializeDefaultResources(Device* device);
 
 public:
@@ -17,11 +23,39 @@ public:
     uint32 viewportHeight = 900;
     const char* viewportName = "Lucent";
 
+    // Frames recorded ahead of the GPU, more hide CPU spikes at the cost of input latency
     uint32 framesInFlight = 3;
 
+    SwapchainSettings swapchain;
+
+    // Render offscreen without a window, reading frames back with Renderer::RequestReadback
+    bool headless = false;
+
     uint32 defaultGroupSizeX = 8;
     uint32 defaultGroupSizeY = 8;
 
+    // Sample material textures by index from a global array where supported, instead of binding them per draw
+    bool bindlessTextures = true;
+
+    // Cull instances and write their draw commands on the GPU, drawing them indirectly in one batch per mesh
+    bool indirectDrawing = true;
+
+    // Skip indirect draws hidden behind the depth of the previous frame, then draw those uncovered by this frame's
+    bool occlusionCulling = true;
+
+    // Count the primitives and shader invocations of each pass, shown by the console's stats command
+    bool pipelineStatistics = false;
+
+    // Pack the GBuffer into 12 bytes per pixel, including depth: metalness is stored in the alpha of base color,
+    // roughness alongside octahedral normals, and emissive is written straight to the scene radiance
+    bool compactGBuffer = true;
+
+    // Keep render targets in 32-bit floats instead of half floats and packed formats, to compare quality against them
+    bool fullPrecision = false;
+
+    // Device memory for the mip levels of streamed textures, beyond which levels not needed by the view are evicted
+    uint64 textureStreamingBudget = 512 * 1024 * 1024;
+
     Texture* defaultBlackTexture;
     Texture* defaultWhiteTexture;
     Texture* defaultGrayTexture;
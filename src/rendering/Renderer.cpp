@@ -2,6 +2,8 @@
 
 #include "device/Context.hpp"
 
+#include <chrono>
+
 namespace lucent
 {
 
@@ -11,17 +13,39 @@ Renderer::Renderer(Device* device, RenderSettings settings)
     , m_FrameIndex(0)
 {
     m_TransferBuffer = m_Device->CreateBuffer(BufferType::kStaging, 200 * 1024 * 1024);
-    m_DebugShapesBuffer = m_Device->CreateBuffer(BufferType::kStorage, 64 * 1024);
 
-    for (int i = 0; i < settings.framesInFlight; ++i)
+    for (int i = 0; i < m_Settings.framesInFlight; ++i)
     {
         m_ContextsPerFrame.push_back(m_Device->CreateContext());
+
+        auto debugShapes = m_DebugShapesBuffers.emplace_back(
+            m_Device->CreateBuffer(BufferType::kStorage, 64 * 1024));
+        debugShapes->Clear(sizeof(uint32), 0);
+    }
+    m_Readbacks.resize(m_Settings.framesInFlight);
+}
+
+Renderer::~Renderer()
+{
+    // Resources owned by passes must not be destroyed while frames using them are in flight, and pending readbacks are
+    // completed before the targets they copied from are destroyed
+    Clear();
+
+    for (auto buffer: m_DebugShapesBuffers)
+        m_Device->DestroyBuffer(buffer);
+
+    for (auto& readback: m_Readbacks)
+    {
+        if (readback.buffer)
+            m_Device->DestroyBuffer(readback.buffer);
     }
 }
 
 Texture* Renderer::AddRenderTarget(const TextureSettings& settings)
 {
-    return m_RenderTargets.emplace_back(m_Device->CreateTexture(settings));
+    // Memory is bound before the first frame, once the lifetimes of all targets are known
+    LC_ASSERT(!m_RenderTargetsAllocated);
+    return m_RenderTargets.emplace_back(m_Device->CreateTransientTexture(settings));
 }
 
 Framebuffer* Renderer::AddFramebuffer(const FramebufferSettings& settings)
@@ -31,12 +55,18 @@ Framebuffer* Renderer::AddFramebuffer(const FramebufferSettings& settings)
 
 Pipeline* Renderer::AddPipeline(const PipelineSettings& settings)
 {
-    return m_Pipelines.emplace_back(m_Device->CreatePipeline(settings));
+    // Pipelines are built concurrently and waited on before the next frame is rendered
+    return m_Pipelines.emplace_back(m_Device->CreatePipelineAsync(settings));
 }
 
 void Renderer::AddPass(const char* label, RenderPass pass)
 {
-    m_RenderPasses.push_back(std::move(pass));
+    m_Graph.AddPass(label, std::move(pass));
+}
+
+void Renderer::AddPass(const char* label, PassResources resources, RenderPass pass)
+{
+    m_Graph.AddPass(label, std::move(resources), std::move(pass));
 }
 
 void Renderer::AddPresentPass(Texture* presentSrc)
@@ -54,15 +84,58 @@ RenderSettings& Renderer::GetSettings()
     return m_Settings;
 }
 
+Device* Renderer::GetDevice()
+{
+    return m_Device;
+}
+
+const TransientMemoryStats& Renderer::GetRenderTargetMemory() const
+{
+    return m_RenderTargetMemory;
+}
+
+const FrameGraph& Renderer::GetFrameGraph() const
+{
+    return m_Graph;
+}
+
+const FrameStats& Renderer::GetFrameStats() const
+{
+    return m_FrameStats;
+}
+
+const FrameTimings& Renderer::GetFrameTimings() const
+{
+    return m_FrameTimings;
+}
+
+const FrameTimings& Renderer::GetAverageFrameTimings() const
+{
+    return m_AverageFrameTimings;
+}
+
+const GpuProfiler& Renderer::GetGpuProfiler() const
+{
+    return m_GpuProfiler;
+}
+
+CullingStats& Renderer::GetCullingStats()
+{
+    return m_CullingStats;
+}
+
 void Renderer::Clear()
 {
-    m_Device->WaitIdle();
+    // Readbacks of frames in flight copy from render targets which are about to be destroyed
+    FlushReadbacks();
 
-    m_RenderPasses.clear();
+    m_Graph.Clear();
+    m_GpuProfiler.Clear();
 
     for (auto texture: m_RenderTargets)
         m_Device->DestroyTexture(texture);
     m_RenderTargets.clear();
+    m_RenderTargetsAllocated = false;
 
     for (auto framebuffer: m_Framebuffers)
         m_Device->DestroyFramebuffer(framebuffer);
@@ -75,34 +148,170 @@ void Renderer::Clear()
 
 bool Renderer::Render(Scene& scene)
 {
+    LC_PROFILE_ZONE("Renderer::Render");
+
+    using Clock = std::chrono::steady_clock;
+    auto frameStart = Clock::now();
+    auto lapStart = frameStart;
+    auto lap = [&lapStart]()
+    {
+        auto now = Clock::now();
+        auto ms = std::chrono::duration<double, std::milli>(now - lapStart).count();
+        lapStart = now;
+        return ms;
+    };
+
     auto& ctx = *m_ContextsPerFrame[m_FrameIndex % m_Settings.framesInFlight];
+    auto& readback = m_Readbacks[m_FrameIndex % m_Settings.framesInFlight];
     auto device = ctx.GetDevice();
+    auto headless = device->IsHeadless();
+
+    m_Device->WaitForPipelines();
+
+    if (!m_RenderTargetsAllocated)
+        AllocateRenderTargets();
 
     // Configure view
     m_View.SetScene(&scene);
 
-    // Begin rendering
-    auto target = device->AcquireSwapchainImage();
+    // Wait for the context before acquiring, so an image isn't held while blocking on an earlier frame
+    lap();
     ctx.Begin();
+    m_FrameTimings.fenceWait = lap();
 
-    for (auto& pass: m_RenderPasses)
+    // The last frame to use this context has completed, so its readback and pass timings are ready
+    CompleteReadback(readback);
+    if (m_FrameIndex >= m_Settings.framesInFlight)
     {
-        pass(ctx, m_View);
+        m_GpuProfiler.AddFrame(m_FrameIndex - m_Settings.framesInFlight, ctx.GetRegionTimings());
+        m_FrameStats.passes = ctx.GetRegionTimings();
     }
+    ctx.EnablePipelineStatistics(m_Settings.pipelineStatistics);
+
+    Texture* target = nullptr;
+    if (!headless)
+        target = device->AcquireSwapchainImage();
+    m_FrameTimings.acquire = lap();
+
+    m_Graph.Execute(ctx, m_View);
+
+    if (target)
+        ctx.BlitTexture(m_PresentSrc, 0, 0, target, 0, 0);
+
+    if (!m_RequestedReadbacks.empty())
+        RecordReadback(ctx, readback);
 
-    ctx.BlitTexture(m_PresentSrc, 0, 0, target, 0, 0);
     ctx.End();
+    m_FrameStats.commands = ctx.GetStats();
+    m_FrameTimings.record = lap();
 
     m_Device->Submit(&ctx);
-    auto success = m_Device->Present();
+    m_FrameTimings.submit = lap();
+
+    auto success = headless || m_Device->Present();
+    m_FrameTimings.present = lap();
+    m_FrameTimings.total = std::chrono::duration<double, std::milli>(Clock::now() - frameStart).count();
+
+    // Exponential moving average over roughly the last 30 frames
+    constexpr double kAverageWeight = 1.0 / 30.0;
+    auto average = [&](double& averaged, double latest)
+    {
+        averaged = m_FrameIndex == 0 ? latest : averaged + (latest - averaged) * kAverageWeight;
+    };
+    average(m_AverageFrameTimings.fenceWait, m_FrameTimings.fenceWait);
+    average(m_AverageFrameTimings.acquire, m_FrameTimings.acquire);
+    average(m_AverageFrameTimings.record, m_FrameTimings.record);
+    average(m_AverageFrameTimings.submit, m_FrameTimings.submit);
+    average(m_AverageFrameTimings.present, m_FrameTimings.present);
+    average(m_AverageFrameTimings.total, m_FrameTimings.total);
 
     ++m_FrameIndex;
     return success;
 }
 
+void Renderer::AllocateRenderTargets()
+{
+    m_Graph.Compile(m_RenderTargets, m_PresentSrc);
+
+    m_RenderTargetMemory = m_Device->AllocateTransientTextures(m_Graph.GetLifetimes());
+    m_RenderTargetsAllocated = true;
+
+    constexpr double kMegabyte = 1024.0 * 1024.0;
+    LC_INFO("Render targets: {} textures in {} blocks, {:.1f}MB allocated ({:.1f}MB without aliasing)",
+        m_RenderTargetMemory.numResources,
+        m_RenderTargetMemory.numBlocks,
+        (double)m_RenderTargetMemory.allocatedBytes / kMegabyte,
+        (double)m_RenderTargetMemory.requestedBytes / kMegabyte);
+}
+
+void Renderer::RequestReadback(ReadbackCallback callback)
+{
+    m_RequestedReadbacks.push_back(std::move(callback));
+}
+
+void Renderer::FlushReadbacks()
+{
+    m_Device->WaitIdle();
+
+    // Complete in submission order, starting from the oldest frame in flight
+    for (uint32 i = 0; i < m_Settings.framesInFlight; ++i)
+        CompleteReadback(m_Readbacks[(m_FrameIndex + i) % m_Settings.framesInFlight]);
+}
+
+void Renderer::RecordReadback(Context& ctx, PendingReadback& readback)
+{
+    auto[width, height] = m_PresentSrc->GetSize();
+    auto format = m_PresentSrc->GetSettings().format;
+    auto size = static_cast<size_t>(width) * height * GetTexelSize(format);
+
+    // The slot's last frame has completed, so its buffer can be replaced
+    if (readback.capacity < size)
+    {
+        if (readback.buffer)
+            m_Device->DestroyBuffer(readback.buffer);
+
+        readback.buffer = m_Device->CreateBuffer(BufferType::kReadback, size);
+        readback.capacity = size;
+    }
+
+    ctx.CopyTexture(m_PresentSrc, 0, 0, readback.buffer, 0, width, height);
+
+    readback.callbacks = std::move(m_RequestedReadbacks);
+    readback.frame = m_FrameIndex;
+    readback.width = width;
+    readback.height = height;
+    readback.format = format;
+    m_RequestedReadbacks.clear();
+}
+
+void Renderer::CompleteReadback(PendingReadback& readback)
+{
+    if (readback.callbacks.empty())
+        return;
+
+    auto size = static_cast<size_t>(readback.width) * readback.height * GetTexelSize(readback.format);
+    LC_ASSERT(size <= readback.capacity);
+
+    auto data = static_cast<const uint8*>(readback.buffer->Map());
+    readback.buffer->Invalidate(size, 0);
+
+    auto result = FrameReadback{
+        .frame = readback.frame,
+        .width = readback.width,
+        .height = readback.height,
+        .format = readback.format,
+        .pixels = std::vector<uint8>(data, data + size)
+    };
+
+    auto callbacks = std::move(readback.callbacks);
+    readback.callbacks.clear();
+    for (auto& callback: callbacks)
+        callback(result);
+}
+
 Buffer* Renderer::GetDebugShapesBuffer()
 {
-    return m_DebugShapesBuffer;
+    return m_DebugShapesBuffers[m_FrameIndex % m_Settings.framesInFlight];
 }
 
 }
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "device/Device.hpp"
+#include "rendering/FrameGraph.hpp"
+#include "rendering/GpuProfiler.hpp"
 #include "rendering/RenderSettings.hpp"
 #include "rendering/View.hpp"
 #include "scene/Scene.hpp"
@@ -8,7 +10,48 @@
 namespace lucent
 {
 
-using RenderPass = std::function<void(Context&, View&)>;
+//! Instance counts written by GPU culling, read back once the frame which culled them has finished
+struct CullingStats
+{
+    uint32 tested;
+    uint32 frustumCulled;
+    uint32 occlusionCulled;
+    uint32 drawnEarly;
+    uint32 drawnLate;
+};
+
+//! CPU time in milliseconds spent on each step of rendering a frame
+struct FrameTimings
+{
+    double fenceWait; // Waiting for the frame which last used this frame's context to complete
+    double acquire; // Waiting for a swapchain image
+    double record;
+    double submit;
+    double present;
+    double total;
+};
+
+//! Counters of the work done to render a frame
+struct FrameStats
+{
+    //! Commands recorded by the last rendered frame
+    ContextStats commands;
+
+    //! Device timings and pipeline statistics of the passes of the last frame completed by the device
+    std::vector<RegionTiming> passes;
+};
+
+//! Pixels of a rendered frame's final image copied to host memory
+struct FrameReadback
+{
+    uint64 frame;
+    uint32 width;
+    uint32 height;
+    TextureFormat format;
+    std::vector<uint8> pixels; // Tightly packed rows, starting from the top
+};
+
+using ReadbackCallback = std::function<void(FrameReadback& readback)>;
 
 //! Manages a set of render passes and render targets
 //! Allows for render passes to be expressed as stateless functions which
@@ -17,6 +60,7 @@ class Renderer
 {
 public:
     Renderer(Device* device, RenderSettings settings);
+    ~Renderer();
 
     Texture* AddRenderTarget(const TextureSettings& settings);
 
@@ -24,31 +68,94 @@ public:
 
     Pipeline* AddPipeline(const PipelineSettings& settings);
 
+    //! Adds a pass which does not declare its resources, disabling pass culling and render target aliasing
     void AddPass(const char* label, RenderPass pass);
 
+    //! Adds a pass to the frame graph, render targets with disjoint lifetimes across all passes may share memory
+    void AddPass(const char* label, PassResources resources, RenderPass pass);
+
     void AddPresentPass(Texture* presentSrc);
 
     Buffer* GetTransferBuffer();
+
+    //! Shapes written by shaders during the current frame, with one buffer per frame in flight
+    //! A frame's buffer can be read back once the frame's context has begun, as its last use has completed by then.
     Buffer* GetDebugShapesBuffer();
 
     RenderSettings& GetSettings();
 
+    Device* GetDevice();
+
+    const TransientMemoryStats& GetRenderTargetMemory() const;
+
+    const FrameGraph& GetFrameGraph() const;
+
+    const FrameStats& GetFrameStats() const;
+
+    //! Timings of the last rendered frame, and their average over recent frames
+    const FrameTimings& GetFrameTimings() const;
+    const FrameTimings& GetAverageFrameTimings() const;
+
+    //! Device timings of each pass over recent frames
+    const GpuProfiler& GetGpuProfiler() const;
+
+    //! Culling counters of the main view, published by the pass which culls it
+    CullingStats& GetCullingStats();
+
     void Clear();
 
+    //! Renders a frame and presents it, or only renders it offscreen if the device is headless
     bool Render(Scene& scene);
 
+    //! Copies the final image of the next rendered frame to host memory without stalling rendering
+    //! The callback is called by a later Render once the frame has completed on the device, or by FlushReadbacks.
+    void RequestReadback(ReadbackCallback callback);
+
+    //! Waits for frames with pending readbacks to complete, then calls their callbacks
+    void FlushReadbacks();
+
+private:
+    // Readback of a frame in flight, using the buffer of its context's slot
+    struct PendingReadback
+    {
+        Buffer* buffer{};
+        size_t capacity = 0;
+        std::vector<ReadbackCallback> callbacks;
+        uint64 frame = 0;
+
+        // Recorded with the copy, the render target may be destroyed or rebuilt before the readback completes
+        uint32 width = 0;
+        uint32 height = 0;
+        TextureFormat format{};
+    };
+
+private:
+    void AllocateRenderTargets();
+
+    void RecordReadback(Context& ctx, PendingReadback& readback);
+    void CompleteReadback(PendingReadback& readback);
+
 private:
     Device* m_Device;
     Buffer* m_TransferBuffer;
-    Buffer* m_DebugShapesBuffer;
+    std::vector<Buffer*> m_DebugShapesBuffers;
 
     RenderSettings m_Settings;
-    std::vector<RenderPass> m_RenderPasses;
+    FrameGraph m_Graph;
     std::vector<Texture*> m_RenderTargets;
+    bool m_RenderTargetsAllocated = false;
+    TransientMemoryStats m_RenderTargetMemory;
     std::vector<Framebuffer*> m_Framebuffers;
     std::vector<Pipeline*> m_Pipelines;
     std::vector<Context*> m_ContextsPerFrame;
+    std::vector<PendingReadback> m_Readbacks;
+    std::vector<ReadbackCallback> m_RequestedReadbacks;
     Texture* m_PresentSrc{};
+    FrameStats m_FrameStats;
+    FrameTimings m_FrameTimings{};
+    FrameTimings m_AverageFrameTimings{};
+    GpuProfiler m_GpuProfiler;
+    CullingStats m_CullingStats{};
     uint32_t m_FrameIndex;
 
     View m_View;
@@ -1,50 +1,87 @@
 #include "StaticMesh.hpp"
 
+#include "device/Context.hpp"
+
 namespace lucent
 {
 
 StaticMesh::StaticMesh(Device* dev, const Mesh& mesh)
     : device(dev)
 {
-    VkDeviceSize vertSize = mesh.vertices.size() * sizeof(Mesh::Vertex);
-    VkDeviceSize indexSize = mesh.indices.size() * sizeof(uint32);
+    auto allocation = device->GetGeometryArena()->Allocate(
+        mesh.vertices.data(), static_cast<uint32>(mesh.vertices.size()), sizeof(Mesh::Vertex),
+        mesh.indices.data(), static_cast<uint32>(mesh.indices.size()));
+
+    // Meshes which don't fit in the arena keep empty ranges, which draw nothing and free nothing
+    if (allocation)
+        geometry = *allocation;
 
-    vertexBuffer = device->CreateBuffer(BufferType::kVertex, vertSize);
-    indexBuffer = device->CreateBuffer(BufferType::kIndex, indexSize);
-    numIndices = mesh.indices.size();
+    // Sphere around the center of the bounding box, looser than the minimal sphere but cheap to find
+    auto minPos = Vector3::Infinity();
+    auto maxPos = Vector3::NegativeInfinity();
+    for (auto& vertex: mesh.vertices)
+    {
+        minPos = Min(minPos, vertex.position);
+        maxPos = Max(maxPos, vertex.position);
+    }
+    boundsCenter = mesh.vertices.empty() ? Vector3::Zero() : 0.5f * (minPos + maxPos);
 
-    vertexBuffer->Upload(mesh.vertices.data(), vertSize, 0);
-    indexBuffer->Upload(mesh.indices.data(), indexSize, 0);
+    boundsRadius = 0.0f;
+    for (auto& vertex: mesh.vertices)
+        boundsRadius = Max(boundsRadius, (vertex.position - boundsCenter).Length());
 }
 
 StaticMesh::StaticMesh(StaticMesh&& mesh) noexcept
     : device(mesh.device)
-    , vertexBuffer(mesh.vertexBuffer)
-    , indexBuffer(mesh.indexBuffer)
-    , numIndices(mesh.numIndices)
+    , geometry(mesh.geometry)
+    , boundsCenter(mesh.boundsCenter)
+    , boundsRadius(mesh.boundsRadius)
 {
     mesh.device = nullptr;
 }
 
 StaticMesh& StaticMesh::operator=(StaticMesh&& mesh) noexcept
 {
+    if (this == &mesh)
+        return *this;
+
+    Release();
+
     device = mesh.device;
-    vertexBuffer = mesh.vertexBuffer;
-    indexBuffer = mesh.indexBuffer;
-    numIndices = mesh.numIndices;
+    geometry = mesh.geometry;
+    boundsCenter = mesh.boundsCenter;
+    boundsRadius = mesh.boundsRadius;
 
     mesh.device = nullptr;
     return *this;
 }
 
 StaticMesh::~StaticMesh()
+{
+    Release();
+}
+
+void StaticMesh::Release()
 {
     if (device)
     {
-        device->WaitIdle();
-        device->DestroyBuffer(vertexBuffer);
-        device->DestroyBuffer(indexBuffer);
+        // The range is only reused once frames drawing the mesh have completed
+        device->DeferRelease([arena = device->GetGeometryArena(), geometry = geometry]()
+        {
+            arena->Free(geometry);
+        });
+        device = nullptr;
     }
 }
 
+void StaticMesh::Bind(Context& ctx) const
+{
+    device->GetGeometryArena()->Bind(ctx);
+}
+
+void StaticMesh::Draw(Context& ctx) const
+{
+    ctx.Draw(geometry.numIndices, geometry.firstIndex, static_cast<int32>(geometry.firstVertex));
+}
+
 }
@@ -6,7 +6,7 @@
 namespace lucent
 {
 
-//! Handle to a fixed size GPU-resident mesh
+//! Handle to a fixed size GPU-resident mesh, stored in the device's geometry arena
 class StaticMesh
 {
 public:
@@ -20,11 +20,23 @@ public:
 
     ~StaticMesh();
 
+    //! Binds the geometry arena, which is shared by every static mesh so only needs binding once for many draws
+    void Bind(Context& ctx) const;
+
+    //! Draws the mesh from the bound geometry arena
+    void Draw(Context& ctx) const;
+
+private:
+    // Frees the mesh's arena ranges once frames in flight are done with them
+    void Release();
+
 public:
     Device* device;
-    Buffer* vertexBuffer;
-    Buffer* indexBuffer;
-    uint32 numIndices;
+    GeometryAllocation geometry;
+
+    //! Bounding sphere of the vertices in model space
+    Vector3 boundsCenter;
+    float boundsRadius;
 };
 
 }
@@ -0,0 +1,380 @@
+#include "TextureStreamer.hpp"
+
+#include "stb_image.h"
+
+#include "rendering/Culling.hpp"
+#include "scene/Camera.hpp"
+#include "scene/ModelInstance.hpp"
+#include "scene/Transform.hpp"
+
+#include <numeric>
+
+namespace lucent
+{
+
+static std::pair<uint32, uint32> GetBiasedSize(uint32 width, uint32 height, uint32 bias)
+{
+    return { Max(width >> bias, 1u), Max(height >> bias, 1u) };
+}
+
+// Box filters an RGBA8 image to half its size, averaging in the space the texels are stored in
+static void HalveRGBA8(std::vector<uint8>& pixels, uint32& width, uint32& height)
+{
+    auto[newWidth, newHeight] = GetBiasedSize(width, height, 1);
+    std::vector<uint8> halved(newWidth * newHeight * 4);
+
+    for (uint32 y = 0; y < newHeight; ++y)
+    {
+        auto y0 = Min(2 * y, height - 1) * width;
+        auto y1 = Min(2 * y + 1, height - 1) * width;
+
+        for (uint32 x = 0; x < newWidth; ++x)
+        {
+            auto x0 = Min(2 * x, width - 1);
+            auto x1 = Min(2 * x + 1, width - 1);
+
+            for (uint32 c = 0; c < 4; ++c)
+            {
+                uint32 sum = pixels[(y0 + x0) * 4 + c] + pixels[(y0 + x1) * 4 + c] +
+                    pixels[(y1 + x0) * 4 + c] + pixels[(y1 + x1) * 4 + c];
+                halved[(y * newWidth + x) * 4 + c] = static_cast<uint8>((sum + 2) / 4);
+            }
+        }
+    }
+
+    pixels = std::move(halved);
+    width = newWidth;
+    height = newHeight;
+}
+
+uint64 GetStreamedTextureBytes(uint32 width, uint32 height, uint32 bias)
+{
+    uint64 bytes = 0;
+    auto[levelWidth, levelHeight] = GetBiasedSize(width, height, bias);
+    while (true)
+    {
+        bytes += uint64(levelWidth) * levelHeight * 4;
+        if (levelWidth == 1 && levelHeight == 1)
+            break;
+
+        levelWidth = Max(levelWidth / 2, 1u);
+        levelHeight = Max(levelHeight / 2, 1u);
+    }
+    return bytes;
+}
+
+std::vector<uint32> FitStreamingBudget(const std::vector<StreamingDemand>& demands, uint64 budget)
+{
+    std::vector<uint32> biases(demands.size());
+    uint64 total = 0;
+
+    auto setBias = [&](uint32 i, uint32 bias)
+    {
+        auto& demand = demands[i];
+        total -= GetStreamedTextureBytes(demand.width, demand.height, biases[i]);
+        biases[i] = bias;
+        total += GetStreamedTextureBytes(demand.width, demand.height, bias);
+    };
+
+    // Keep resident levels beyond those wanted until the budget is exceeded
+    for (uint32 i = 0; i < demands.size(); ++i)
+    {
+        auto& demand = demands[i];
+        biases[i] = Min(demand.wantedBias, demand.residentBias);
+        total += GetStreamedTextureBytes(demand.width, demand.height, biases[i]);
+    }
+
+    std::vector<uint32> leastRecentlyUsed(demands.size());
+    std::iota(leastRecentlyUsed.begin(), leastRecentlyUsed.end(), 0);
+    std::stable_sort(leastRecentlyUsed.begin(), leastRecentlyUsed.end(), [&](uint32 a, uint32 b)
+    {
+        return demands[a].lastUsedFrame < demands[b].lastUsedFrame;
+    });
+
+    for (auto i: leastRecentlyUsed)
+    {
+        if (total <= budget)
+            break;
+
+        if (biases[i] < demands[i].wantedBias)
+            setBias(i, demands[i].wantedBias);
+    }
+
+    // Then degrade wanted levels, dropping the largest resident level each time
+    while (total > budget)
+    {
+        uint32 largest = ~0u;
+        uint32 largestSize = 0;
+        for (auto i: leastRecentlyUsed)
+        {
+            auto& demand = demands[i];
+            if (biases[i] >= demand.maxBias)
+                continue;
+
+            auto[width, height] = GetBiasedSize(demand.width, demand.height, biases[i]);
+            if (Max(width, height) > largestSize)
+            {
+                largest = i;
+                largestSize = Max(width, height);
+            }
+        }
+
+        if (largest == ~0u)
+            break;
+
+        setBias(largest, biases[largest] + 1);
+    }
+
+    return biases;
+}
+
+TextureStreamer::TextureStreamer(Device* device, uint64 memoryBudget)
+    : m_Device(device)
+    , m_Budget(memoryBudget)
+{
+    m_Loader = std::thread([this]()
+    { RunLoader(); });
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    {
+        std::lock_guard lock(m_Mutex);
+        m_Stopping = true;
+    }
+    m_RequestReady.notify_all();
+    m_Loader.join();
+
+    m_Device->WaitIdle();
+    for (auto& streamed: m_Textures)
+        m_Device->DestroyTexture(streamed.texture);
+}
+
+Texture* TextureStreamer::Add(std::vector<uint8> encoded, uint32 width, uint32 height, TextureFormat format,
+    Color placeholder)
+{
+    auto texture = m_Device->CreateTexture(TextureSettings{
+        .format = format,
+        .generateMips = true
+    });
+    auto texel = placeholder.Pack();
+    texture->Upload(sizeof(texel), &texel);
+
+    uint32 maxBias = 0;
+    while (Max(width >> maxBias, height >> maxBias) > kMinResidentSize)
+        ++maxBias;
+
+    auto index = static_cast<uint32>(m_Textures.size());
+    m_Textures.push_back(StreamedTexture{
+        .texture = texture,
+        .encoded = std::make_shared<const std::vector<uint8>>(std::move(encoded)),
+        .width = width,
+        .height = height,
+        .maxBias = maxBias
+    });
+    m_Indices.emplace(texture, index);
+
+    // The smallest version is loaded first, so every texture has its colors as soon as possible
+    Request(index, maxBias);
+
+    return texture;
+}
+
+void TextureStreamer::Update(Scene& scene, uint32 viewportHeight)
+{
+    LC_PROFILE_ZONE("TextureStreamer::Update");
+
+    ++m_Frame;
+    ApplyResults();
+
+    if (m_Textures.empty())
+        return;
+
+    auto& camera = scene.mainCamera.Get<Camera>();
+    auto cameraPosition = scene.mainCamera.GetPosition();
+    auto projection = camera.GetProjectionMatrix();
+    auto frustum = Frustum(projection * camera.GetViewMatrix(cameraPosition));
+
+    // Screen height in pixels of an object one unit tall, one unit away from the camera
+    auto pixelsPerUnit = 0.5f * projection(1, 1) * static_cast<float>(viewportHeight);
+
+    std::vector<uint32> wantedBiases(m_Textures.size());
+    for (uint32 i = 0; i < m_Textures.size(); ++i)
+        wantedBiases[i] = m_Textures[i].maxBias;
+
+    // A texture is assumed to cover each mesh using it once, so needs about as many texels as the mesh's pixels
+    std::vector<Texture*> textures;
+    scene.Each<ModelInstance, Transform>([&](ModelInstance& instance, Transform& local)
+    {
+        for (auto& primitive: *instance.model)
+        {
+            auto& mesh = primitive.mesh;
+            auto center = Vector3(local.model * Vector4(mesh.boundsCenter, 1.0f));
+            auto scale = Max(Vector3(local.model.c1).Length(),
+                Max(Vector3(local.model.c2).Length(), Vector3(local.model.c3).Length()));
+            auto radius = mesh.boundsRadius * scale;
+
+            if (!frustum.Intersects(center, radius))
+                continue;
+
+            // Inside the sphere, the mesh may fill the screen at any size
+            auto distance = (center - cameraPosition).Length();
+            auto screenSize = distance > radius ? 2.0f * radius * pixelsPerUnit / distance
+                                                : std::numeric_limits<float>::max();
+
+            textures.clear();
+            auto material = instance.material ? instance.material : primitive.material;
+            material->GetTextures(textures);
+
+            for (auto texture: textures)
+            {
+                auto it = m_Indices.find(texture);
+                if (it == m_Indices.end())
+                    continue;
+
+                auto& streamed = m_Textures[it->second];
+                streamed.lastUsedFrame = m_Frame;
+
+                auto size = static_cast<float>(Max(streamed.width, streamed.height));
+                auto bias = screenSize >= size ? 0u
+                                               : static_cast<uint32>(Floor(Log2(size / Max(screenSize, 1.0f))));
+
+                auto& wanted = wantedBiases[it->second];
+                wanted = Min(wanted, Min(bias, streamed.maxBias));
+            }
+        }
+    });
+
+    // Textures showing their placeholder count as having only their smallest version, which is already loading
+    std::vector<StreamingDemand> demands;
+    demands.reserve(m_Textures.size());
+    for (uint32 i = 0; i < m_Textures.size(); ++i)
+    {
+        auto& streamed = m_Textures[i];
+        auto residentBias = streamed.loaded ? streamed.residentBias : streamed.maxBias;
+        demands.push_back(StreamingDemand{
+            .width = streamed.width,
+            .height = streamed.height,
+            .residentBias = residentBias,
+            .wantedBias = streamed.failed ? residentBias : wantedBiases[i],
+            .maxBias = streamed.maxBias,
+            .lastUsedFrame = streamed.lastUsedFrame
+        });
+    }
+
+    auto biases = FitStreamingBudget(demands, m_Budget);
+    for (uint32 i = 0; i < m_Textures.size(); ++i)
+    {
+        auto& streamed = m_Textures[i];
+        if (streamed.loaded && !streamed.loading && !streamed.failed && biases[i] != streamed.residentBias)
+            Request(i, biases[i]);
+    }
+}
+
+TextureStreamingStats TextureStreamer::GetStats() const
+{
+    auto stats = TextureStreamingStats{
+        .numTextures = static_cast<uint32>(m_Textures.size()),
+        .budget = m_Budget
+    };
+
+    for (auto& streamed: m_Textures)
+    {
+        if (streamed.loading)
+            ++stats.numLoading;
+        if (streamed.failed)
+            ++stats.numFailed;
+        if (streamed.loaded)
+            stats.residentBytes += GetStreamedTextureBytes(streamed.width, streamed.height, streamed.residentBias);
+    }
+    return stats;
+}
+
+void TextureStreamer::Request(uint32 index, uint32 bias)
+{
+    auto& streamed = m_Textures[index];
+    streamed.loading = true;
+    {
+        std::lock_guard lock(m_Mutex);
+        m_Requests.push_back(LoadRequest{ index, bias, streamed.encoded });
+    }
+    m_RequestReady.notify_one();
+}
+
+void TextureStreamer::ApplyResults()
+{
+    std::vector<LoadResult> results;
+    {
+        std::lock_guard lock(m_Mutex);
+        results.swap(m_Results);
+    }
+
+    if (results.empty())
+        return;
+
+    // Resized textures get new images, while commands in flight keep using the old ones until they complete
+    for (auto& result: results)
+    {
+        auto& streamed = m_Textures[result.index];
+        streamed.loading = false;
+
+        if (result.pixels.empty())
+        {
+            // Keep what is resident, and don't retry
+            LC_ERROR("Failed to decode streamed texture {}", result.index);
+            streamed.failed = true;
+            continue;
+        }
+
+        m_Device->ResizeTexture(streamed.texture, result.width, result.height);
+        streamed.texture->Upload(result.pixels.size(), result.pixels.data());
+
+        streamed.loaded = true;
+        streamed.residentBias = result.bias;
+    }
+}
+
+void TextureStreamer::RunLoader()
+{
+    LC_PROFILE_THREAD("Texture loader");
+
+    while (true)
+    {
+        LoadRequest request;
+        {
+            std::unique_lock lock(m_Mutex);
+            m_RequestReady.wait(lock, [this]()
+            { return m_Stopping || !m_Requests.empty(); });
+
+            if (m_Stopping)
+                return;
+
+            request = std::move(m_Requests.front());
+            m_Requests.pop_front();
+        }
+
+        LC_PROFILE_ZONE("TextureStreamer::Load");
+        auto result = LoadResult{ .index = request.index, .bias = request.bias };
+
+        int width, height, channels;
+        auto& encoded = *request.encoded;
+        auto data = stbi_load_from_memory(encoded.data(), static_cast<int>(encoded.size()),
+            &width, &height, &channels, 4);
+
+        if (data)
+        {
+            result.width = width;
+            result.height = height;
+            result.pixels.assign(data, data + width * height * 4);
+            stbi_image_free(data);
+
+            for (uint32 i = 0; i < request.bias; ++i)
+                HalveRGBA8(result.pixels, result.width, result.height);
+        }
+
+        std::lock_guard lock(m_Mutex);
+        m_Results.push_back(std::move(result));
+    }
+}
+
+}
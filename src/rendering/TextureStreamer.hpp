@@ -0,0 +1,121 @@
+#pragma once
+
+#include "device/Device.hpp"
+#include "scene/Scene.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace lucent
+{
+
+//! Level of detail wanted for a streamed texture, where a bias is the number of its most detailed levels dropped
+struct StreamingDemand
+{
+    uint32 width;
+    uint32 height;
+    uint32 residentBias;
+    uint32 wantedBias;
+    uint32 maxBias;
+    uint64 lastUsedFrame;
+};
+
+//! Bytes used by a texture with its most detailed levels dropped, including the rest of its mip chain
+uint64 GetStreamedTextureBytes(uint32 width, uint32 height, uint32 bias);
+
+//! Returns the bias to keep for each demand: levels already resident are kept while they fit in the budget, otherwise
+//! levels are dropped from the least recently used textures first, then from the most detailed textures
+std::vector<uint32> FitStreamingBudget(const std::vector<StreamingDemand>& demands, uint64 budget);
+
+struct TextureStreamingStats
+{
+    uint32 numTextures;
+    uint32 numLoading;
+    uint32 numFailed;
+    uint64 residentBytes;
+    uint64 budget;
+};
+
+//! Keeps the mip levels of imported textures in memory as they are needed to draw a scene
+//! Textures are created as a single placeholder texel and decoded on a background thread, first at a small size and
+//! then at the detail their screen size needs. Levels which are no longer needed are evicted once the memory budget
+//! is exceeded.
+class TextureStreamer
+{
+public:
+    // Smallest versions are at most this size, and are kept resident once loaded
+    static constexpr uint32 kMinResidentSize = 64;
+
+    TextureStreamer(Device* device, uint64 memoryBudget);
+    ~TextureStreamer();
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    //! Creates a streamed texture from an encoded RGBA8 image (e.g. PNG or JPEG) of the given size
+    Texture* Add(std::vector<uint8> encoded, uint32 width, uint32 height, TextureFormat format, Color placeholder);
+
+    //! Requests the levels needed to draw a scene from its main camera, and applies levels which finished loading
+    //! Applying levels replaces the images of textures, the old images are released once frames in flight complete.
+    void Update(Scene& scene, uint32 viewportHeight);
+
+    TextureStreamingStats GetStats() const;
+
+private:
+    struct StreamedTexture
+    {
+        Texture* texture;
+        std::shared_ptr<const std::vector<uint8>> encoded;
+        uint32 width;
+        uint32 height;
+        uint32 maxBias;
+
+        // The placeholder isn't part of the mip chain, so has no bias of its own
+        bool loaded = false;
+        uint32 residentBias = 0;
+        bool loading = false;
+        bool failed = false; // Decoding failed, so the texture keeps what it has and isn't requested again
+        uint64 lastUsedFrame = 0;
+    };
+
+    struct LoadRequest
+    {
+        uint32 index;
+        uint32 bias;
+        std::shared_ptr<const std::vector<uint8>> encoded;
+    };
+
+    struct LoadResult
+    {
+        uint32 index;
+        uint32 bias;
+        uint32 width;
+        uint32 height;
+        std::vector<uint8> pixels;
+    };
+
+private:
+    void Request(uint32 index, uint32 bias);
+    void ApplyResults();
+    void RunLoader();
+
+private:
+    Device* m_Device;
+    uint64 m_Budget;
+    uint64 m_Frame = 0;
+
+    std::vector<StreamedTexture> m_Textures;
+    std::unordered_map<Texture*, uint32> m_Indices;
+
+    // Shared with the loader thread
+    std::mutex m_Mutex;
+    std::condition_variable m_RequestReady;
+    std::deque<LoadRequest> m_Requests;
+    std::vector<LoadResult> m_Results;
+    bool m_Stopping = false;
+
+    std::thread m_Loader;
+};
+
+}
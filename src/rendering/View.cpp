@@ -1,6 +1,9 @@
 #include "View.hpp"
 
+#include "rendering/Model.hpp"
 #include "scene/Camera.hpp"
+#include "scene/ModelInstance.hpp"
+#include "scene/Transform.hpp"
 
 namespace lucent
 {
@@ -23,6 +26,8 @@ void View::SetScene(Scene* scene)
         m_Projection(2, 2), m_Projection(2, 3));
 
     m_AspectRatio = m_Projection(1, 1) / m_Projection(0, 0);
+
+    m_SceneDrawsGathered = false;
 }
 
 void View::BindUniforms(Context& ctx) const
@@ -59,4 +64,37 @@ const Matrix4& View::GetViewProjectionMatrix() const
     return m_ViewProjection;
 }
 
+const std::vector<SceneDraw>& View::GetSceneDraws()
+{
+    GatherSceneDraws();
+    return m_SceneDraws;
+}
+
+const BoundsList& View::GetSceneBounds()
+{
+    GatherSceneDraws();
+    return m_SceneBounds;
+}
+
+void View::GatherSceneDraws()
+{
+    if (m_SceneDrawsGathered)
+        return;
+
+    LC_PROFILE_ZONE("View::GatherSceneDraws");
+
+    m_SceneDraws.clear();
+    m_SceneBounds.Clear();
+    GetScene().Each<ModelInstance, Transform>([&](ModelInstance& instance, Transform& local)
+    {
+        for (auto& primitive: *instance.model)
+        {
+            auto material = instance.material ? instance.material : primitive.material;
+            m_SceneDraws.push_back({ &primitive.mesh, material, local.model });
+            m_SceneBounds.Add(primitive.mesh, local.model);
+        }
+    });
+    m_SceneDrawsGathered = true;
+}
+
 }
@@ -1,10 +1,21 @@
 #pragma once
 
+#include "rendering/Culling.hpp"
 #include "scene/Scene.hpp"
 
 namespace lucent
 {
 
+class Material;
+
+//! Mesh of a model instance placed in the world, as drawn by passes without a draw list
+struct SceneDraw
+{
+    const StaticMesh* mesh;
+    Material* material;
+    Matrix4 model;
+};
+
 class View
 {
 public:
@@ -22,9 +33,23 @@ public:
 
     void BindUniforms(Context& ctx) const;
 
+    //! Every mesh of the scene's model instances, gathered on first use each frame and shared by the passes drawing
+    //! them. Must be called while executing a pass rather than from a recording task, as the scene isn't thread safe.
+    const std::vector<SceneDraw>& GetSceneDraws();
+
+    //! World bounds of GetSceneDraws(), in the same order
+    const BoundsList& GetSceneBounds();
+
+private:
+    void GatherSceneDraws();
+
 private:
     Scene* m_Scene{};
 
+    std::vector<SceneDraw> m_SceneDraws;
+    BoundsList m_SceneBounds;
+    bool m_SceneDrawsGathered = false;
+
     Matrix4 m_View;
     Matrix4 m_ViewInverse;
     Matrix4 m_Projection;
@@ -19,6 +19,7 @@ static void ApplyTransform(Entity entity)
         auto& parent = entity.scene->Find(transform.parent).Get<Transform>();
         transform.model = parent.model * transform.model;
     }
+    entity.scene->RecordChange(entity.id);
 
     if (entity.Has<Parent>())
     {
@@ -17,13 +17,14 @@ constexpr int kBRDFSize = 512;
 
 HdrImporter::HdrImporter(Device* device)
     : m_Device(device)
+    , m_Format(Engine::Instance()->GetRenderSettings().GetHdrFormat())
 {
     m_Context = m_Device->CreateContext();
 
     m_OffscreenColor = m_Device->CreateTexture(TextureSettings{
         .width = kCubeSize,
         .height = kCubeSize,
-        .format = TextureFormat::kRGBA32F });
+        .format = m_Format });
 
     m_OffscreenDepth = m_Device->CreateTexture(TextureSettings{
         .width = kCubeSize,
@@ -37,25 +38,26 @@ HdrImporter::HdrImporter(Device* device)
         .depthTexture = m_OffscreenDepth
     });
 
-    m_RectToCube = m_Device->CreatePipeline(PipelineSettings{
+    m_RectToCube = m_Device->CreatePipelineAsync(PipelineSettings{
         .shaderName = "IBLRectToCube.shader",
         .framebuffer = m_Offscreen
     });
 
-    m_GenIrradiance = m_Device->CreatePipeline(PipelineSettings{
+    m_GenIrradiance = m_Device->CreatePipelineAsync(PipelineSettings{
         .shaderName = "IBLPrefilterIrradiance.shader",
         .framebuffer = m_Offscreen
     });
 
-    m_GenSpecular = m_Device->CreatePipeline(PipelineSettings{
+    m_GenSpecular = m_Device->CreatePipelineAsync(PipelineSettings{
         .shaderName = "IBLPrefilterRadiance.shader",
         .framebuffer = m_Offscreen
     });
 
-    m_GenBRDF = m_Device->CreatePipeline(PipelineSettings{
+    m_GenBRDF = m_Device->CreatePipelineAsync(PipelineSettings{
         .shaderName = "IBLGenerateBrdfLUT.shader",
         .framebuffer = m_Offscreen
     });
+    m_Device->WaitForPipelines();
 }
 
 void HdrImporter::RenderToCube(Pipeline* pipeline, Texture* src, Texture* dst, int dstLevel, uint32 size, float rough)
@@ -85,8 +87,7 @@ void HdrImporter::RenderToCube(Pipeline* pipeline, Texture* src, Texture* dst, i
 
         ctx.BindPipeline(pipeline);
 
-        ctx.BindBuffer(cube->indexBuffer);
-        ctx.BindBuffer(cube->vertexBuffer);
+        cube->Bind(ctx);
 
         ctx.Uniform("u_View"_id, view);
         ctx.Uniform("u_Proj"_id, proj);
@@ -95,7 +96,7 @@ void HdrImporter::RenderToCube(Pipeline* pipeline, Texture* src, Texture* dst, i
         Descriptor desc{.set = 0, .binding = 1};
         ctx.BindTexture(&desc, src);
 
-        ctx.Draw(cube->numIndices);
+        cube->Draw(ctx);
         ctx.EndRenderPass();
 
         ctx.CopyTexture(
@@ -120,10 +121,9 @@ void HdrImporter::RenderToQuad(Pipeline* pipeline, Texture* dst, uint32 size)
 
     ctx.BindPipeline(pipeline);
 
-    ctx.BindBuffer(quad->indexBuffer);
-    ctx.BindBuffer(quad->vertexBuffer);
+    quad->Bind(ctx);
 
-    ctx.Draw(quad->numIndices);
+    quad->Draw(ctx);
     ctx.EndRenderPass();
 
     ctx.CopyTexture(
@@ -159,7 +159,7 @@ Environment HdrImporter::Import(const std::string& hdrFile)
     env.cubeMap = m_Device->CreateTexture(TextureSettings{
         .width = kCubeSize,
         .height = kCubeSize,
-        .format = TextureFormat::kRGBA32F,
+        .format = m_Format,
         .shape = TextureShape::kCube
     });
 
@@ -169,7 +169,7 @@ Environment HdrImporter::Import(const std::string& hdrFile)
     env.irradianceMap = m_Device->CreateTexture(TextureSettings{
         .width = kIrradianceSize,
         .height = kIrradianceSize,
-        .format = TextureFormat::kRGBA32F,
+        .format = m_Format,
         .shape = TextureShape::kCube
     });
 
@@ -180,7 +180,7 @@ Environment HdrImporter::Import(const std::string& hdrFile)
         .width = kSpecularSize,
         .height = kSpecularSize,
         .levels = kSpecularLevels,
-        .format = TextureFormat::kRGBA32F,
+        .format = m_Format,
         .shape = TextureShape::kCube
     });
 
@@ -196,7 +196,7 @@ Environment HdrImporter::Import(const std::string& hdrFile)
     env.BRDF = m_Device->CreateTexture(TextureSettings{
         .width = kBRDFSize,
         .height = kBRDFSize,
-        .format = TextureFormat::kRGBA32F,
+        .format = m_Format,
         .addressMode = TextureAddressMode::kClampToEdge
     });
     RenderToQuad(m_GenBRDF, env.BRDF, kBRDFSize);
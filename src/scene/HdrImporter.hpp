@@ -23,6 +23,8 @@ private:
     Device* m_Device;
     Context* m_Context;
 
+    // Format of the offscreen target and the maps copied from it
+    TextureFormat m_Format;
     Texture* m_OffscreenColor;
     Texture* m_OffscreenDepth;
     Framebuffer* m_Offscreen;
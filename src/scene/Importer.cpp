@@ -20,8 +20,31 @@ Importer::Importer(Device* device)
 {
 }
 
+// Keeps images encoded so the texture streamer can decode them on demand, reading only their size here
+static bool KeepEncodedImage(gltf::Image* image, const int imageIndex, std::string* err, std::string* warn,
+    int requestedWidth, int requestedHeight, const unsigned char* bytes, int size, void* userData)
+{
+    int width, height, components;
+    if (!stbi_info_from_memory(bytes, size, &width, &height, &components))
+    {
+        if (err)
+            *err += fmt::format("Unknown format of image {}: {}\n", imageIndex, stbi_failure_reason());
+        return false;
+    }
+
+    image->width = width;
+    image->height = height;
+    image->component = 4;
+    image->bits = 8;
+    image->pixel_type = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+    image->image.assign(bytes, bytes + size);
+    return true;
+}
+
 Entity Importer::Import(Scene& scene, const std::string& modelFile)
 {
+    LC_PROFILE_ZONE("Importer::Import");
+
     Clear();
     m_ModelFile = modelFile;
 
@@ -29,17 +52,21 @@ Entity Importer::Import(Scene& scene, const std::string& modelFile)
 
     gltf::Model model;
     gltf::TinyGLTF loader;
+    loader.SetImageLoader(KeepEncodedImage, nullptr);
     std::string err;
     std::string warn;
 
     bool result = false;
-    if (modelFile.ends_with(".glb"))
     {
-        result = loader.LoadBinaryFromFile(&model, &err, &warn, modelFile);
-    }
-    else if (modelFile.ends_with(".gltf"))
-    {
-        result = loader.LoadASCIIFromFile(&model, &err, &warn, modelFile);
+        LC_PROFILE_ZONE("Importer::Load");
+        if (modelFile.ends_with(".glb"))
+        {
+            result = loader.LoadBinaryFromFile(&model, &err, &warn, modelFile);
+        }
+        else if (modelFile.ends_with(".gltf"))
+        {
+            result = loader.LoadASCIIFromFile(&model, &err, &warn, modelFile);
+        }
     }
     LC_ASSERT(result);
 
@@ -50,6 +77,8 @@ Entity Importer::Import(Scene& scene, const std::string& modelFile)
     std::vector<Entity> rootEntities;
     if (model.defaultScene >= 0)
     {
+        LC_PROFILE_ZONE("Importer::ImportEntities");
+
         auto& nodeIndices = model.scenes[model.defaultScene].nodes;
         rootEntities.reserve(nodeIndices.size());
         for (auto nodeIndex: nodeIndices)
@@ -68,8 +97,9 @@ Entity Importer::Import(Scene& scene, const std::string& modelFile)
     return rootEntities.empty() ? Entity{} : rootEntities.back();
 }
 
-static Texture* ImportTexture(Device* device, const gltf::Model& model, const gltf::TextureInfo& textureInfo,
-    Texture* defaultTexture, bool linear = true)
+// Textures show the placeholder color until their first levels are streamed in
+static Texture* ImportTexture(TextureStreamer& streamer, const gltf::Model& model,
+    const gltf::TextureInfo& textureInfo, Texture* defaultTexture, Color placeholder, bool linear = true)
 {
     if (textureInfo.index < 0)
         return defaultTexture;
@@ -77,41 +107,34 @@ static Texture* ImportTexture(Device* device, const gltf::Model& model, const gl
     auto& tex = model.textures[textureInfo.index];
     auto& img = model.images[tex.source];
 
-    LC_ASSERT(img.bits == 8);
-    LC_ASSERT(img.component == 4);
-
-    auto imported = device->CreateTexture(TextureSettings{
-        .width = uint32(img.width),
-        .height = uint32(img.height),
-        .format = linear ? TextureFormat::kRGBA8 : TextureFormat::kRGBA8_sRGB,
-        .generateMips = true
-    });
-    imported->Upload(img.image.size(), img.image.data());
-
-    return imported;
+    return streamer.Add(img.image, uint32(img.width), uint32(img.height),
+        linear ? TextureFormat::kRGBA8 : TextureFormat::kRGBA8_sRGB, placeholder);
 }
 
-static Texture* ImportTexture(Device* device, const gltf::Model& model, const gltf::NormalTextureInfo& textureInfo,
-    Texture* defaultTexture)
+static Texture* ImportTexture(TextureStreamer& streamer, const gltf::Model& model,
+    const gltf::NormalTextureInfo& textureInfo, Texture* defaultTexture, Color placeholder)
 {
     gltf::TextureInfo info;
     info.index = textureInfo.index;
     info.texCoord = textureInfo.texCoord;
-    return ImportTexture(device, model, info, defaultTexture, true);
+    return ImportTexture(streamer, model, info, defaultTexture, placeholder, true);
 }
 
-static Texture* ImportTexture(Device* device, const gltf::Model& model, const gltf::OcclusionTextureInfo& textureInfo,
-    Texture* defaultTexture)
+static Texture* ImportTexture(TextureStreamer& streamer, const gltf::Model& model,
+    const gltf::OcclusionTextureInfo& textureInfo, Texture* defaultTexture, Color placeholder)
 {
     gltf::TextureInfo info;
     info.index = textureInfo.index;
     info.texCoord = textureInfo.texCoord;
-    return ImportTexture(device, model, info, defaultTexture, true);
+    return ImportTexture(streamer, model, info, defaultTexture, placeholder, true);
 }
 
 void Importer::ImportMaterials(Scene& scene, const gltf::Model& model)
 {
+    LC_PROFILE_ZONE("Importer::ImportMaterials");
+
     auto& settings = Engine::Instance()->GetRenderSettings();
+    auto& streamer = *Engine::Instance()->GetTextureStreamer();
 
     for (auto& data: model.materials)
     {
@@ -120,11 +143,16 @@ void Importer::ImportMaterials(Scene& scene, const gltf::Model& model)
         auto& pbr = data.pbrMetallicRoughness;
 
         // Create textures
-        material->baseColorMap = ImportTexture(m_Device, model, pbr.baseColorTexture, settings.defaultBlackTexture, false);
-        material->metalRough = ImportTexture(m_Device, model, pbr.metallicRoughnessTexture, settings.defaultGreenTexture);
-        material->normalMap = ImportTexture(m_Device, model, data.normalTexture, settings.defaultNormalTexture);
-        material->aoMap = ImportTexture(m_Device, model, data.occlusionTexture, settings.defaultWhiteTexture);
-        material->emissive = ImportTexture(m_Device, model, data.emissiveTexture, settings.defaultBlackTexture, false);
+        material->baseColorMap = ImportTexture(streamer, model, pbr.baseColorTexture, settings.defaultBlackTexture,
+            Color::Gray(), false);
+        material->metalRough = ImportTexture(streamer, model, pbr.metallicRoughnessTexture,
+            settings.defaultGreenTexture, Color::Green());
+        material->normalMap = ImportTexture(streamer, model, data.normalTexture, settings.defaultNormalTexture,
+            Color(0.5f, 0.5f, 1.0f));
+        material->aoMap = ImportTexture(streamer, model, data.occlusionTexture, settings.defaultWhiteTexture,
+            Color::White());
+        material->emissive = ImportTexture(streamer, model, data.emissiveTexture, settings.defaultBlackTexture,
+            Color::Black(), false);
 
         // Material parameters
         auto& col = pbr.baseColorFactor;
@@ -185,6 +213,8 @@ public:
 // http://www.mikktspace.com/
 static void CalculateTangents(std::vector<Mesh::Vertex>& vertices, std::vector<uint32>& indices)
 {
+    LC_PROFILE_ZONE("CalculateTangents");
+
     std::vector<Mesh::Vertex> unindexed(indices.size());
 
     std::vector<Mesh::Vertex> newVertices(indices.size());
@@ -267,6 +297,8 @@ static void CalculateTangents(std::vector<Mesh::Vertex>& vertices, std::vector<u
 
 void Importer::ImportMeshes(Scene& scene, const gltf::Model& gltfModel)
 {
+    LC_PROFILE_ZONE("Importer::ImportMeshes");
+
     Mesh mesh;
     for (auto& data: gltfModel.meshes)
     {
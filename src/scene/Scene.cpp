@@ -12,6 +12,8 @@ Entity Scene::CreateEntity()
 
 void Scene::Destroy(Entity entity)
 {
+    RecordChange(entity.id);
+
     for (auto& pool: m_ComponentPoolsByIndex)
     {
         if (pool && pool->Contains(entity.id))
@@ -35,6 +37,30 @@ Material* Scene::AddMaterial(std::unique_ptr<Material> material)
     return m_Materials.emplace_back(std::move(material)).get();
 }
 
+uint64 Scene::GetVersion() const
+{
+    return m_FirstChangeVersion + m_Changes.size();
+}
+
+bool Scene::GetChangedEntities(uint64 sinceVersion, std::vector<EntityID>& changed) const
+{
+    if (sinceVersion < m_FirstChangeVersion || sinceVersion > GetVersion())
+        return false;
+
+    changed.insert(changed.end(), m_Changes.begin() + (sinceVersion - m_FirstChangeVersion), m_Changes.end());
+    return true;
+}
+
+void Scene::RecordChange(EntityID entity)
+{
+    if (m_Changes.size() == kMaxRecordedChanges)
+    {
+        m_FirstChangeVersion += m_Changes.size();
+        m_Changes.clear();
+    }
+    m_Changes.push_back(entity);
+}
+
 Material* Scene::GetDefaultMaterial()
 {
     auto& settings = Engine::Instance()->GetRenderSettings();
@@ -35,6 +35,16 @@ public:
 
     Material* GetDefaultMaterial();
 
+    //! Incremented whenever components are assigned to or removed from an entity, or its transform is set
+    uint64 GetVersion() const;
+
+    //! Appends the entities changed since the given version, in order and possibly repeated
+    //! Returns false if changes that old are no longer recorded, in which case every entity must be treated as changed.
+    bool GetChangedEntities(uint64 sinceVersion, std::vector<EntityID>& changed) const;
+
+    //! Records a change made to an entity's components in place rather than through Entity
+    void RecordChange(EntityID entity);
+
 public:
     Entity mainCamera;
     Entity mainDirectionalLight;
@@ -52,6 +62,11 @@ private:
 
     std::vector<std::unique_ptr<Model>> m_Models;
     std::vector<std::unique_ptr<Material>> m_Materials;
+
+    // Changed entities since m_FirstChangeVersion, dropped once too many are recorded
+    static constexpr size_t kMaxRecordedChanges = 64 * 1024;
+    std::vector<EntityID> m_Changes;
+    uint64 m_FirstChangeVersion = 0;
 };
 
 /* Scene implementation */
@@ -81,6 +96,8 @@ ComponentPool<std::decay_t<T>>& Scene::GetPool()
 template<typename... Cs, typename F>
 void Scene::Each(F&& func)
 {
+    LC_PROFILE_ZONE("Scene::Each");
+
     auto pools = std::tie(GetPool<Cs>()...);
 
     // Choose the smallest pool for iteration
@@ -123,12 +140,14 @@ template<typename T>
 void Entity::Assign(T&& component)
 {
     scene->GetPool<T>().Assign(id, std::forward<T>(component));
+    scene->RecordChange(id);
 }
 
 template<typename T>
 void Entity::Remove()
 {
     scene->GetPool<T>().Remove(id);
+    scene->RecordChange(id);
 }
 
 template<typename T>
@@ -4,7 +4,7 @@
 #endif
 
 layout(set=0, binding=0) uniform sampler2D u_Input;
-layout(set=0, binding=1, rgba32f) uniform image2D u_Output;
+layout(set=0, binding=1, HDR_FORMAT) uniform image2D u_Output;
 
 #ifdef BLOOM_UPSAMPLE
 layout(set=0, binding=2) uniform sampler2D u_InputHigh;
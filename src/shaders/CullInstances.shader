@@ -0,0 +1,262 @@
+#define CULL_INSTANCES
+#include "Instances.shader"
+
+layout(local_size_x=64) in;
+
+layout(set=0, binding=0) uniform Globals
+{
+    mat4 u_ViewProjection;
+    mat4 u_OcclusionViewProjection; // View projection the Hi-Z was rendered with
+    uint u_View;
+    uint u_NumInstances;
+    uint u_NumBatches;
+    uint u_CullDepth;
+    uint u_Step;
+    uint u_Phase;
+};
+
+// Each cull dispatches reset, instance and (with draw counts) compaction steps, must match IndirectDrawList
+const uint kStepReset = 0;
+const uint kStepInstances = 1;
+const uint kStepCompact = 2;
+
+// Frustum culling only, or the early and late phases of occlusion culling
+const uint kPhaseFrustum = 0;
+const uint kPhaseEarly = 1;
+const uint kPhaseLate = 2;
+
+// Counters read back by the host, must match IndirectDrawList
+const uint kCountTested = 0;
+const uint kCountFrustumCulled = 1;
+const uint kCountOcclusionCulled = 2;
+const uint kCountDrawnEarly = 3;
+const uint kCountDrawnLate = 4;
+const uint kNumCounts = 5;
+
+layout(set=0, binding=1, std430) readonly buffer Batches
+{
+    BatchData u_Batches[kMaxBatches];
+};
+
+layout(set=0, binding=2, std430) readonly buffer Instances
+{
+    InstanceData u_Instances[kMaxInstances];
+};
+
+layout(set=0, binding=3, std430) buffer Commands
+{
+    DrawCommand u_Commands[kMaxViews * kMaxBatches];
+};
+
+layout(set=0, binding=4, std430) buffer VisibleInstances
+{
+    uint u_VisibleInstances[kMaxViews * kMaxInstances];
+};
+
+// Instances which failed the early occlusion test, to be tested again in the late phase
+layout(set=0, binding=5, std430) buffer Occluded
+{
+    uint u_Occluded[kMaxInstances];
+};
+
+layout(set=0, binding=6, std430) buffer Stats
+{
+    uint u_Counts[kNumCounts];
+};
+
+#ifdef OCCLUSION
+// Farthest depth pyramid
+layout(set=0, binding=7) uniform sampler2D u_HiZ;
+#endif
+
+#ifdef DRAW_COUNT
+// Number of commands of each group of batches left after compaction, one group per workgroup
+const uint kMaxDrawGroups = kMaxBatches / 64;
+
+layout(set=0, binding=8, std430) buffer DrawCounts
+{
+    uint u_DrawCounts[kMaxViews * kMaxDrawGroups];
+};
+
+shared uint s_Drawn[64];
+#endif
+
+shared uint s_Counts[kNumCounts];
+
+bool IsVisible(vec4 sphere)
+{
+    // Frustum planes from the rows of the view projection matrix, with clip space depth in [0, 1]
+    mat4 m = transpose(u_ViewProjection);
+    vec4 planes[6] = vec4[](
+        m[3] + m[0], m[3] - m[0],
+        m[3] + m[1], m[3] - m[1],
+        m[2], m[3] - m[2]
+    );
+
+    // Depth clamped views keep instances in front of and behind the frustum
+    int numPlanes = u_CullDepth != 0 ? 6 : 4;
+    for (int i = 0; i < numPlanes; ++i)
+    {
+        if (dot(planes[i].xyz, sphere.xyz) + planes[i].w < -sphere.w * length(planes[i].xyz))
+            return false;
+    }
+    return true;
+}
+
+#ifdef OCCLUSION
+bool IsOccluded(vec4 sphere)
+{
+    // Screen space bounds and nearest depth of the box around the sphere
+    vec2 minUV = vec2(1.0);
+    vec2 maxUV = vec2(0.0);
+    float nearest = 1.0;
+    for (int i = 0; i < 8; ++i)
+    {
+        vec3 corner = sphere.xyz + sphere.w * (vec3(i & 1, (i >> 1) & 1, i >> 2) * 2.0 - 1.0);
+        vec4 clip = u_OcclusionViewProjection * vec4(corner, 1.0);
+
+        // Bounds crossing the near plane can't be projected, and are close enough to the camera to keep
+        if (clip.w <= 0.0 || clip.z < 0.0)
+            return false;
+
+        vec3 ndc = clip.xyz / clip.w;
+        vec2 uv = ndc.xy * 0.5 + 0.5;
+        minUV = min(minUV, uv);
+        maxUV = max(maxUV, uv);
+        nearest = min(nearest, ndc.z);
+    }
+
+    // Texel bounds at level 0. GenerateHiZ halves each level rounding down and folds the extra texel of an odd size into
+    // the last one, so a level 0 texel b lies in texel min(b >> level, size - 1) of every coarser level.
+    ivec2 baseSize = textureSize(u_HiZ, 0);
+    ivec2 minTexel = min(ivec2(clamp(minUV, 0.0, 1.0) * vec2(baseSize)), baseSize - 1);
+    ivec2 maxTexel = min(ivec2(clamp(maxUV, 0.0, 1.0) * vec2(baseSize)), baseSize - 1);
+
+    // Choose the level where the bounds cover at most 2x2 texels, so four samples find the farthest occluder
+    ivec2 extent = maxTexel - minTexel;
+    int maxExtent = max(extent.x, extent.y);
+    int level = maxExtent > 1 ? findMSB(maxExtent - 1) + 1 : 0;
+    level = min(level, textureQueryLevels(u_HiZ) - 1);
+
+    ivec2 levelMax = textureSize(u_HiZ, level) - 1;
+    ivec2 lo = min(minTexel >> level, levelMax);
+    ivec2 hi = min(maxTexel >> level, levelMax);
+
+    float farthest = max(
+        max(texelFetch(u_HiZ, lo, level).r, texelFetch(u_HiZ, ivec2(hi.x, lo.y), level).r),
+        max(texelFetch(u_HiZ, ivec2(lo.x, hi.y), level).r, texelFetch(u_HiZ, hi, level).r));
+
+    return nearest > farthest;
+}
+#endif
+
+#ifdef DRAW_COUNT
+// Moves the commands of a group's batches with visible instances to the front of the group's range, keeping their order
+void CompactCommands()
+{
+    uint index = gl_GlobalInvocationID.x;
+    uint command = u_View * kMaxBatches + index;
+
+    bool drawn = index < u_NumBatches && u_Commands[command].instanceCount != 0;
+    DrawCommand draw;
+    if (drawn)
+        draw = u_Commands[command];
+
+    s_Drawn[gl_LocalInvocationIndex] = uint(drawn);
+
+    // Every command of the group is read before any is overwritten
+    memoryBarrierBuffer();
+    barrier();
+
+    uint slot = 0;
+    for (uint i = 0; i < gl_LocalInvocationIndex; ++i)
+        slot += s_Drawn[i];
+
+    if (drawn)
+        u_Commands[u_View * kMaxBatches + gl_WorkGroupID.x * 64 + slot] = draw;
+
+    if (gl_LocalInvocationIndex == 63)
+        u_DrawCounts[u_View * kMaxDrawGroups + gl_WorkGroupID.x] = slot + uint(drawn);
+}
+#endif
+
+// Resets the view's draw commands, then appends each visible instance to the range of its batch
+// With occlusion culling, the early phase draws instances visible in last frame's Hi-Z and the late phase draws those
+// which were hidden there but are visible in the Hi-Z of the early phase. With draw counts, the commands of each group
+// of batches are then compacted so batches without visible instances aren't drawn.
+void Compute()
+{
+    uint index = gl_GlobalInvocationID.x;
+
+#ifdef DRAW_COUNT
+    if (u_Step == kStepCompact)
+    {
+        CompactCommands();
+        return;
+    }
+#endif
+
+    if (u_Step == kStepReset)
+    {
+        if (index < u_NumBatches)
+        {
+            BatchData batch = u_Batches[index];
+            u_Commands[u_View * kMaxBatches + index] = DrawCommand(batch.indexCount, 0, batch.firstIndex,
+                batch.vertexOffset, u_View * kMaxInstances + batch.firstInstance);
+        }
+        return;
+    }
+
+    if (gl_LocalInvocationIndex < kNumCounts)
+        s_Counts[gl_LocalInvocationIndex] = 0;
+    barrier();
+
+    // Every invocation must reach the barrier below, so results are only skipped rather than returned early
+    bool tested = index < u_NumInstances && (u_Phase != kPhaseLate || u_Occluded[index] != 0);
+    bool visible = false;
+
+    if (tested)
+    {
+        InstanceData instance = u_Instances[index];
+        vec4 bounds = u_Batches[instance.batch].bounds;
+
+        vec3 center = vec3(instance.model * vec4(bounds.xyz, 1.0));
+        mat3 axes = mat3(instance.model);
+        float scale = max(length(axes[0]), max(length(axes[1]), length(axes[2])));
+        vec4 sphere = vec4(center, bounds.w * scale);
+
+        // Instances tested in the late phase already passed the frustum test
+        bool inFrustum = u_Phase == kPhaseLate || IsVisible(sphere);
+        bool occluded = false;
+#ifdef OCCLUSION
+        occluded = inFrustum && u_Phase != kPhaseFrustum && IsOccluded(sphere);
+#endif
+        visible = inFrustum && !occluded;
+
+        if (u_Phase != kPhaseLate)
+            u_Occluded[index] = uint(occluded);
+
+        if (u_Phase != kPhaseLate)
+        {
+            atomicAdd(s_Counts[kCountTested], 1);
+            if (!inFrustum)
+                atomicAdd(s_Counts[kCountFrustumCulled], 1);
+        }
+        if (occluded && u_Phase != kPhaseEarly)
+            atomicAdd(s_Counts[kCountOcclusionCulled], 1);
+        if (visible)
+            atomicAdd(s_Counts[u_Phase == kPhaseLate ? kCountDrawnLate : kCountDrawnEarly], 1);
+
+        if (visible)
+        {
+            uint command = u_View * kMaxBatches + instance.batch;
+            uint slot = atomicAdd(u_Commands[command].instanceCount, 1);
+            u_VisibleInstances[u_Commands[command].firstInstance + slot] = index;
+        }
+    }
+
+    // One global atomic per counter and group
+    barrier();
+    if (gl_LocalInvocationIndex < kNumCounts && s_Counts[gl_LocalInvocationIndex] != 0)
+        atomicAdd(u_Counts[gl_LocalInvocationIndex], s_Counts[gl_LocalInvocationIndex]);
+}
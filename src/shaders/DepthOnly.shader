@@ -1,11 +1,25 @@
 #include "VertexInput.shader"
 
+#ifdef INDIRECT
+#include "Instances.shader"
+
+layout(set=0, binding=0) uniform Globals
+{
+    mat4 u_ViewProjection;
+};
+#else
 layout(set=0, binding=0) uniform Globals
 {
     mat4 u_MVP;
 };
+#endif
 
 void Vertex()
 {
-    gl_Position = u_MVP * vec4(a_Position.xyz, 1.0);
-}
\ No newline at end of file
+#ifdef INDIRECT
+    mat4 mvp = u_ViewProjection * GetInstance().model;
+#else
+    mat4 mvp = u_MVP;
+#endif
+    gl_Position = mvp * vec4(a_Position.xyz, 1.0);
+}
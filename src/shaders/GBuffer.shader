@@ -0,0 +1,42 @@
+// Encoding of the view space normals written by GeometryPass.shader
+
+#ifndef GBUFFER_H
+#define GBUFFER_H
+
+vec2 SignNotZero(vec2 v)
+{
+    return vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+// Octahedral encoding in [0,1]^2, spreading the precision of two channels evenly over the sphere as outlined in:
+// "A Survey of Efficient Representations for Independent Unit Vectors"
+// The view looks down +z, so z is negated to put the normals facing the camera in the unfolded half, where the
+// precision is best and there is no seam.
+vec2 EncodeOctahedral(vec3 N)
+{
+    N.z = -N.z;
+    vec2 p = N.xy / (abs(N.x) + abs(N.y) + abs(N.z));
+    p = N.z < 0.0 ? (1.0 - abs(p.yx)) * SignNotZero(p) : p;
+    return 0.5 * p + 0.5;
+}
+
+vec3 DecodeOctahedral(vec2 encoded)
+{
+    vec2 p = 2.0 * encoded - 1.0;
+    vec3 N = vec3(p, 1.0 - abs(p.x) - abs(p.y));
+    N.xy = N.z < 0.0 ? (1.0 - abs(N.yx)) * SignNotZero(N.xy) : N.xy;
+    N.z = -N.z;
+    return normalize(N);
+}
+
+// The compact layout stores roughness in the blue channel alongside the encoded normal
+vec3 DecodeNormal(vec4 normalSample)
+{
+#ifdef COMPACT_GBUFFER
+    return DecodeOctahedral(normalSample.xy);
+#else
+    return normalize(2.0 * normalSample.xyz - 1.0);
+#endif
+}
+
+#endif
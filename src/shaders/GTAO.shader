@@ -1,9 +1,10 @@
 #include "Core.shader"
 #include "View.shader"
+#include "GBuffer.shader"
 
 layout(set=1, binding=0) uniform sampler2D u_Depth;
 layout(set=1, binding=1) uniform sampler2D u_Normals;
-layout(set=1, binding=2, r32f) uniform image2D u_AO;
+layout(set=1, binding=2, AO_FORMAT) uniform image2D u_AO;
 layout(set=1, binding=3) uniform Globals
 {
     float u_ViewToScreenZ;
@@ -41,7 +42,9 @@ float GTAOVisibility(vec2 coord, ivec2 pixelCoord)
 {
     vec3 pos = ScreenToView(coord, GetDepth(coord));
     vec3 V = normalize(-pos);
-    vec3 N = normalize(2.0 * texture(u_Normals, coord).xyz - 1.0);
+    // Filtering encoded normals blends across the octahedral folds, so the full resolution texel is fetched instead
+    ivec2 normalCoord = ivec2(coord * vec2(textureSize(u_Normals, 0)));
+    vec3 N = DecodeNormal(texelFetch(u_Normals, normalCoord, 0));
 
     const float sampleStep = 1.0 / kNumSamples;
 
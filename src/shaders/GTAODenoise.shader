@@ -1,7 +1,7 @@
 #include "Core.shader"
 
 layout(set=0, binding=0) uniform sampler2D u_AORaw;
-layout(set=0, binding=1, r32f) uniform image2D u_AODenoised;
+layout(set=0, binding=1, AO_FORMAT) uniform image2D u_AODenoised;
 
 // Performs a manually unrolled box blur on values at the given screen coordinate
 // TODO: Use bilateral filtering with linear depth instead
@@ -10,12 +10,28 @@ layout(set=0, binding=2) uniform Parameters
     ivec2 u_Offset;
 };
 
-// Perform min filtering on input texture
+// Perform min filtering on input texture, or max filtering for a farthest depth pyramid used for occlusion culling
 void Compute()
 {
     ivec2 dstCoord = ivec2(gl_GlobalInvocationID.xy);
     ivec2 srcCoord = dstCoord * ivec2(2);
 
+#ifdef FARTHEST_DEPTH
+    // Each level is the source size halved and rounded down, so a destination texel covers source texels 2x and 2x+1,
+    // and the last column or row of an odd sized source also covers 2x+2. Every source texel then reaches the max, which
+    // keeps occlusion culling conservative.
+    ivec2 srcSize = textureSize(u_Input, 0);
+    ivec2 dstSize = imageSize(u_Output);
+    ivec2 srcLast = srcCoord + ivec2(1) + ivec2(equal(dstCoord, dstSize - 1)) * (srcSize & 1);
+    srcLast = min(srcLast, srcSize - 1);
+
+    float z = 0.0;
+    for (int y = srcCoord.y; y <= srcLast.y; ++y)
+    {
+        for (int x = srcCoord.x; x <= srcLast.x; ++x)
+            z = max(z, texelFetch(u_Input, ivec2(x, y), 0).r);
+    }
+#else
     // Offset to sample positions enables better filtering of NPOT textures
     vec4 depths;
     depths.x = texelFetch(u_Input, srcCoord, 0).r;
@@ -24,6 +40,7 @@ void Compute()
     depths.w = texelFetch(u_Input, srcCoord + u_Offset, 0).r;
 
     float z = min(min(depths.x, depths.y), min(depths.z, depths.w));
+#endif
 
     imageStore(u_Output, dstCoord, vec4(z, vec3(0.0)));
 }
\ No newline at end of file
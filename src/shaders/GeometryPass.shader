@@ -1,5 +1,6 @@
 #include "VertexInput.shader"
 #include "View.shader"
+#include "GBuffer.shader"
 
 layout(location=0) varying Vertex
 {
@@ -7,21 +8,64 @@ layout(location=0) varying Vertex
     vec3 v_Tangent;
     vec3 v_Bitangent;
     vec3 v_Normal;
+#ifdef INDIRECT
+    flat uint v_MaterialIndex;
+#endif
 };
 
 // GBuffer targets
 layout(location=0) out vec4 o_BaseColor;
+#ifdef COMPACT_GBUFFER
+// Metalness is stored in the alpha of base color and roughness alongside the encoded normal, while emissive is written
+// straight to the scene radiance which lighting is added to
+layout(location=1) out vec4 o_NormalRoughness;
+layout(location=2) out vec4 o_Emissive;
+#else
 layout(location=1) out vec3 o_Normal;
 layout(location=2) out vec2 o_MetalRoughness;
 layout(location=3) out vec4 o_Emissive;
+#endif
 
+#ifdef INDIRECT
+// Instances are batched by material, so the material index is still uniform within a draw
+#include "Instances.shader"
+#else
 // Per-draw uniforms
 layout(set=1, binding=0) uniform Globals
 {
     mat4 u_MVP;
     mat4 u_MV;
+#ifdef BINDLESS
+    uint u_MaterialIndex;
+#endif
 };
+#endif
 
+#ifdef BINDLESS
+// Must match MaterialTable and VulkanShader::kMaxBindlessTextures
+const int kMaxMaterials = 4096;
+const int kMaxBindlessTextures = 4096;
+
+struct MaterialData
+{
+    vec4 baseColorFactor;
+    float metallicFactor;
+    float roughnessFactor;
+    float emissiveFactor;
+    uint baseColorMap;
+    uint metalRoughMap;
+    uint normalMap;
+    uint emissiveMap;
+};
+
+layout(set=2, binding=0, std430) readonly buffer Materials
+{
+    MaterialData u_Materials[kMaxMaterials];
+};
+
+// Material indices are the same for every invocation in a draw, so textures can be selected without nonuniformEXT
+layout(set=3, binding=0) uniform sampler2D u_Textures[kMaxBindlessTextures];
+#else
 // Material properties
 layout(set=2, binding=0) uniform Material
 {
@@ -34,39 +78,81 @@ layout(set=2, binding=1) uniform sampler2D u_BaseColor;
 layout(set=2, binding=2) uniform sampler2D u_MetalRoughness;
 layout(set=2, binding=3) uniform sampler2D u_Normal;
 layout(set=2, binding=4) uniform sampler2D u_Emissive;
+#endif
 
 void Vertex()
 {
+#ifdef INDIRECT
+    InstanceData instance = GetInstance();
+    mat4 mv = u_WorldToView * instance.model;
+    mat4 mvp = u_ViewToScreen * mv;
+    v_MaterialIndex = instance.materialIndex;
+#else
+    mat4 mv = u_MV;
+    mat4 mvp = u_MVP;
+#endif
+
     vec3 bitangent = a_Tangent.w * cross(a_Normal, vec3(a_Tangent));
 
     v_UV = a_UV;
-    v_Tangent   = normalize(mat3(u_MV) * vec3(a_Tangent));
-    v_Bitangent = normalize(mat3(u_MV) * bitangent);
-    v_Normal    = normalize(mat3(u_MV) * a_Normal);
+    v_Tangent   = normalize(mat3(mv) * vec3(a_Tangent));
+    v_Bitangent = normalize(mat3(mv) * bitangent);
+    v_Normal    = normalize(mat3(mv) * a_Normal);
 
-    gl_Position = u_MVP * vec4(a_Position, 1.0);
+    gl_Position = mvp * vec4(a_Position, 1.0);
 }
 
 void Fragment()
 {
+#ifdef BINDLESS
+#ifdef INDIRECT
+    MaterialData material = u_Materials[v_MaterialIndex];
+#else
+    MaterialData material = u_Materials[u_MaterialIndex];
+#endif
+
+    vec4 baseColorSample = texture(u_Textures[material.baseColorMap], v_UV);
+    vec4 metallicRoughness = texture(u_Textures[material.metalRoughMap], v_UV);
+    vec3 normalSample = texture(u_Textures[material.normalMap], v_UV).rgb;
+    vec4 emissiveSample = texture(u_Textures[material.emissiveMap], v_UV);
+
+    vec4 baseColorFactor = material.baseColorFactor;
+    float metallicFactor = material.metallicFactor;
+    float roughnessFactor = material.roughnessFactor;
+    float emissiveFactor = material.emissiveFactor;
+#else
+    vec4 baseColorSample = texture(u_BaseColor, v_UV);
     vec4 metallicRoughness = texture(u_MetalRoughness, v_UV);
+    vec3 normalSample = texture(u_Normal, v_UV).rgb;
+    vec4 emissiveSample = texture(u_Emissive, v_UV);
+
+    vec4 baseColorFactor = u_BaseColorFactor;
+    float metallicFactor = u_MetallicFactor;
+    float roughnessFactor = u_RoughnessFactor;
+    float emissiveFactor = u_EmissiveFactor;
+#endif
 
     vec3 t = normalize(v_Tangent);
     vec3 b = normalize(v_Bitangent);
     vec3 n = normalize(v_Normal);
 
-    vec3 nTex = texture(u_Normal, v_UV).rgb * 2.0 - vec3(1.0);
+    vec3 nTex = normalSample * 2.0 - vec3(1.0);
     nTex.y = -nTex.y;
     vec3 N = mat3(t, b, n) * normalize(nTex);
 
-    vec4 baseColor = texture(u_BaseColor, v_UV) * u_BaseColorFactor;
-    float metal = metallicRoughness.b * u_MetallicFactor;
-    float rough = metallicRoughness.g * u_RoughnessFactor;
+    vec4 baseColor = baseColorSample * baseColorFactor;
+    float metal = metallicRoughness.b * metallicFactor;
+    float rough = metallicRoughness.g * roughnessFactor;
 
-    vec4 emissive = texture(u_Emissive, v_UV) * u_EmissiveFactor;
+    vec4 emissive = emissiveSample * emissiveFactor;
 
+#ifdef COMPACT_GBUFFER
+    o_BaseColor = vec4(baseColor.rgb, metal);
+    o_NormalRoughness = vec4(EncodeOctahedral(N), rough, 0.0);
+#else
     o_BaseColor = baseColor;
     o_Normal = 0.5 * N + 0.5;
     o_MetalRoughness = vec2(metal, rough);
+#endif
     o_Emissive = emissive;
 }
\ No newline at end of file
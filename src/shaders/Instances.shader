@@ -0,0 +1,54 @@
+// Instance data for indirect draws, must match IndirectDrawList
+
+#ifndef INSTANCES_H
+#define INSTANCES_H
+
+const int kMaxInstances = 131072;
+const int kMaxBatches = 4096;
+const int kMaxViews = 4;
+
+struct InstanceData
+{
+    mat4 model;
+    uint batch;
+    uint materialIndex;
+};
+
+// Instances of the same mesh, drawn by a single indirect command
+struct BatchData
+{
+    vec4 bounds; // Bounding sphere of the mesh in model space
+    uint indexCount;
+    uint firstInstance;
+    uint firstIndex; // Location of the mesh in the geometry arena
+    int vertexOffset;
+};
+
+// Matches VkDrawIndexedIndirectCommand
+struct DrawCommand
+{
+    uint indexCount;
+    uint instanceCount;
+    uint firstIndex;
+    int vertexOffset;
+    uint firstInstance;
+};
+
+#ifndef CULL_INSTANCES
+// Instances visible to a view, indexed by gl_InstanceIndex
+layout(set=1, binding=1, std430) readonly buffer Instances
+{
+    InstanceData u_Instances[kMaxInstances];
+};
+layout(set=1, binding=2, std430) readonly buffer VisibleInstances
+{
+    uint u_VisibleInstances[kMaxViews * kMaxInstances];
+};
+
+InstanceData GetInstance()
+{
+    return u_Instances[u_VisibleInstances[gl_InstanceIndex]];
+}
+#endif
+
+#endif
@@ -3,16 +3,19 @@
 #include "VertexInput.shader"
 #include "MomentShadow.shader"
 #include "PBR.shader"
+#include "GBuffer.shader"
 
 layout(location=0) varying vec2 v_TexCoord;
 layout(location=0) out vec4 o_Color;
 
-// GBuffer
+// GBuffer, the compact layout has no metal/roughness target and emissive is already in the target lighting is added to
 layout(set=1, binding=0) uniform sampler2D u_BaseColor;
 layout(set=1, binding=1) uniform sampler2D u_Normal;
-layout(set=1, binding=2) uniform sampler2D u_MetalRough;
 layout(set=1, binding=3) uniform sampler2D u_Depth;
+#ifndef COMPACT_GBUFFER
+layout(set=1, binding=2) uniform sampler2D u_MetalRough;
 layout(set=1, binding=4) uniform sampler2D u_Emissive;
+#endif
 
 // Analytical lights
 struct DirectionalLight
@@ -152,15 +155,22 @@ void Fragment()
     // Extract view space directions
     vec2 coord = gl_FragCoord.xy / vec2(textureSize(u_BaseColor, 0).xy);
     vec3 pos = ScreenToView(coord, textureLod(u_Depth, coord, 0).r);
-    vec3 N = 2.0 * texture(u_Normal, coord).rgb - 1.0;
+    vec4 normalSample = texture(u_Normal, coord);
+    vec3 N = DecodeNormal(normalSample);
     vec3 V = normalize(-pos);
     float NdotV = dot(N, V);
 
     // Extract material parameters
-    vec3 base = texture(u_BaseColor, coord).rgb;
+    vec4 baseSample = texture(u_BaseColor, coord);
+    vec3 base = baseSample.rgb;
+#ifdef COMPACT_GBUFFER
+    float metal = baseSample.a;
+    float rough = normalSample.b;
+#else
     vec2 metalRough = texture(u_MetalRough, coord).rg;
     float metal = metalRough.x;
     float rough = metalRough.y;
+#endif
     float a = rough * rough;
     float a2 = a * a;
 
@@ -173,8 +183,10 @@ void Fragment()
 
     shaded += GetEnvironmentLight(N, V, coord, rough, F0, albedo);
 
+#ifndef COMPACT_GBUFFER
     // Emissive
     shaded += texture(u_Emissive, coord).rgb;
+#endif
 
     o_Color = vec4(shaded, 1.0);
 }
@@ -1,7 +1,7 @@
 #include "Core.shader"
 
 layout(set=0, binding=0) uniform sampler2D u_Input;
-layout(set=0, binding=1, rgba32f) uniform image2D u_Output;
+layout(set=0, binding=1, HDR_FORMAT) uniform image2D u_Output;
 
 // 7x7 Gaussian blur kernels (manually unrolled):
 vec3 ConvolveHorizontal(vec2 coord)
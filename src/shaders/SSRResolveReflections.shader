@@ -4,9 +4,10 @@
 layout(set=1, binding=0) uniform sampler2D u_Rays;
 layout(set=1, binding=1) uniform sampler2D u_ConvolvedScene;
 layout(set=1, binding=2) uniform sampler2D u_Depth;
+// Bound to the normals in the compact GBuffer layout, which store roughness in their blue channel
 layout(set=1, binding=3) uniform sampler2D u_MetalRoughness;
 
-layout(set=1, binding=4, rgba32f) uniform image2D u_Result;
+layout(set=1, binding=4, HDR_FORMAT) uniform image2D u_Result;
 
 layout(local_size_x=8, local_size_y=8) in;
 
@@ -66,7 +67,11 @@ void Compute()
     coord /= imgSize;
 
     vec2 rayEnd = texture(u_Rays, coord).xy;
+#ifdef COMPACT_GBUFFER
+    float rough = texture(u_MetalRoughness, coord).b;
+#else
     float rough = texture(u_MetalRoughness, coord).g;
+#endif
     float angle = AlphaToConeAngle(rough * rough);
     float maxDim = max(sceneSize.x, sceneSize.y);
 
@@ -1,9 +1,10 @@
 #include "Core.shader"
 #include "View.shader"
+#include "GBuffer.shader"
 
 layout(set=1, binding=0) uniform sampler2D u_MinZ;
 layout(set=1, binding=1) uniform sampler2D u_Normals;
-layout(set=1, binding=3, rgba32f) uniform image2D u_Result;
+layout(set=1, binding=3, RAY_FORMAT) uniform image2D u_Result;
 
 const float kCrossingBias = 0.00001;
 const int kStopLevel = 0;
@@ -88,7 +89,8 @@ void Compute()
     float nonlinearDepth = textureLod(u_MinZ, coord, 0).r;
     vec3 pos = ScreenToView(coord, nonlinearDepth);
     vec3 V = normalize(-pos);
-    vec3 N = normalize(2.0 * texture(u_Normals, coord).xyz - 1.0);
+    ivec2 normalCoord = ivec2(coord * vec2(textureSize(u_Normals, 0)));
+    vec3 N = DecodeNormal(texelFetch(u_Normals, normalCoord, 0));
     vec3 R = (2.0 * dot(V, N) * N) - V;
 
     vec3 nextPos = pos + R;
@@ -0,0 +1,69 @@
+#include "catch2/catch_all.hpp"
+
+#include "core/Profiler.hpp"
+
+#include <thread>
+
+namespace lucent::tests
+{
+
+TEST_CASE("Profiler keeps the events of each thread")
+{
+    Profiler profiler;
+    profiler.Record("Main", 10, 20);
+
+    std::thread worker([&]()
+    {
+        profiler.SetThreadName("Worker");
+        profiler.Record("Job", 12, 18);
+    });
+    worker.join();
+
+    auto events = profiler.GetEvents(0, 100);
+    REQUIRE(events.size() == 2);
+    REQUIRE(std::string(events[0].name) == "Main");
+    REQUIRE(std::string(events[1].name) == "Job");
+
+    // Events overlapping the range are included
+    REQUIRE(profiler.GetEvents(19, 30).size() == 1);
+    REQUIRE(profiler.GetEvents(21, 30).empty());
+
+    auto trace = profiler.DumpChromeTrace();
+    REQUIRE(trace.find("\"args\":{\"name\":\"Worker\"}") != std::string::npos);
+    auto job = "\"name\":\"Job\",\"cat\":\"cpu\",\"ph\":\"X\",\"ts\":0.012,\"dur\":0.006";
+    REQUIRE(trace.find(job) != std::string::npos);
+}
+
+TEST_CASE("Profiler overwrites the oldest events once a thread's ring is full")
+{
+    Profiler profiler;
+    for (uint64 i = 0; i < Profiler::kEventsPerThread + 10; ++i)
+        profiler.Record("Zone", i, i);
+
+    auto events = profiler.GetEvents(0, ~0ull);
+    REQUIRE(events.size() < Profiler::kEventsPerThread);
+    REQUIRE(events.back().start == Profiler::kEventsPerThread + 9);
+    REQUIRE(events.front().start > 10);
+}
+
+TEST_CASE("Profiler frames span consecutive frame markers")
+{
+    Profiler profiler;
+    REQUIRE(profiler.GetFrames().empty());
+
+    for (uint32 i = 0; i < Profiler::kMaxFrames + 5; ++i)
+        profiler.MarkFrame();
+
+    auto frames = profiler.GetFrames();
+    REQUIRE(frames.size() == Profiler::kMaxFrames);
+    REQUIRE(frames.back().index == Profiler::kMaxFrames + 3);
+    for (uint32 i = 1; i < frames.size(); ++i)
+    {
+        REQUIRE(frames[i].index == frames[i - 1].index + 1);
+        REQUIRE(frames[i].start == frames[i - 1].end);
+    }
+
+    REQUIRE(profiler.GetFrames(2).size() == 2);
+}
+
+}
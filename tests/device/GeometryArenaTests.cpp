@@ -0,0 +1,72 @@
+#include "catch2/catch_all.hpp"
+
+#include "device/GeometryArena.hpp"
+
+namespace lucent::tests
+{
+
+TEST_CASE("Ranges are allocated from the lowest free offset")
+{
+    RangeAllocator allocator(100);
+
+    REQUIRE(allocator.Allocate(10) == 0);
+    REQUIRE(allocator.Allocate(20) == 10);
+    REQUIRE(allocator.Allocate(30) == 30);
+    REQUIRE(allocator.GetNumAllocated() == 60);
+    REQUIRE(allocator.GetNumFreeRanges() == 1);
+}
+
+TEST_CASE("Allocations larger than any free range fail")
+{
+    RangeAllocator allocator(100);
+
+    REQUIRE(allocator.Allocate(101) == RangeAllocator::kInvalidOffset);
+    REQUIRE(allocator.Allocate(100) == 0);
+    REQUIRE(allocator.Allocate(1) == RangeAllocator::kInvalidOffset);
+    REQUIRE(allocator.GetNumAllocated() == 100);
+}
+
+TEST_CASE("Freed ranges are reused")
+{
+    RangeAllocator allocator(100);
+
+    auto a = allocator.Allocate(40);
+    auto b = allocator.Allocate(40);
+    allocator.Free(a, 40);
+
+    REQUIRE(allocator.Allocate(50) == RangeAllocator::kInvalidOffset);
+    REQUIRE(allocator.Allocate(30) == a);
+    REQUIRE(allocator.Allocate(10) == 30);
+    REQUIRE(allocator.Allocate(20) == b + 40);
+}
+
+TEST_CASE("Adjacent free ranges are merged")
+{
+    RangeAllocator allocator(90);
+
+    auto a = allocator.Allocate(30);
+    auto b = allocator.Allocate(30);
+    auto c = allocator.Allocate(30);
+
+    allocator.Free(a, 30);
+    allocator.Free(c, 30);
+    REQUIRE(allocator.GetNumFreeRanges() == 2);
+
+    // Filling the gap between two free ranges leaves a single range covering everything
+    allocator.Free(b, 30);
+    REQUIRE(allocator.GetNumFreeRanges() == 1);
+    REQUIRE(allocator.GetNumAllocated() == 0);
+    REQUIRE(allocator.Allocate(90) == 0);
+}
+
+TEST_CASE("Empty ranges take no space")
+{
+    RangeAllocator allocator(10);
+
+    REQUIRE(allocator.Allocate(0) == 0);
+    allocator.Free(0, 0);
+    REQUIRE(allocator.GetNumAllocated() == 0);
+    REQUIRE(allocator.GetNumFreeRanges() == 1);
+}
+
+}
@@ -0,0 +1,86 @@
+#include "catch2/catch_all.hpp"
+
+#include "device/TransientMemory.hpp"
+
+namespace lucent::tests
+{
+
+static bool AddressesOverlap(const TransientMemoryPlan& plan, const std::vector<TransientResource>& resources,
+    uint32 a, uint32 b)
+{
+    auto& placeA = plan.placements[a];
+    auto& placeB = plan.placements[b];
+    if (placeA.block != placeB.block)
+        return false;
+
+    return placeA.offset < placeB.offset + resources[b].size && placeB.offset < placeA.offset + resources[a].size;
+}
+
+TEST_CASE("Empty transient plan")
+{
+    auto plan = PlanTransientMemory({});
+
+    REQUIRE(plan.blocks.empty());
+    REQUIRE(plan.stats.requestedBytes == 0);
+    REQUIRE(plan.stats.allocatedBytes == 0);
+}
+
+TEST_CASE("Resources with disjoint lifetimes share memory")
+{
+    std::vector<TransientResource> resources = {
+        { .size = 1024, .alignment = 256, .memoryTypeBits = 0x1, .firstPass = 0, .lastPass = 1 },
+        { .size = 512, .alignment = 256, .memoryTypeBits = 0x1, .firstPass = 2, .lastPass = 3 },
+        { .size = 1024, .alignment = 256, .memoryTypeBits = 0x1, .firstPass = 4, .lastPass = 4 },
+    };
+    auto plan = PlanTransientMemory(resources);
+
+    REQUIRE(plan.blocks.size() == 1);
+    REQUIRE(plan.stats.requestedBytes == 2560);
+    REQUIRE(plan.stats.allocatedBytes == 1024);
+
+    for (auto& placement: plan.placements)
+        REQUIRE(placement.offset == 0);
+}
+
+TEST_CASE("Resources alive at the same time never overlap")
+{
+    std::vector<TransientResource> resources = {
+        { .size = 1000, .alignment = 256, .memoryTypeBits = 0x3, .firstPass = 0, .lastPass = 5 },
+        { .size = 300, .alignment = 256, .memoryTypeBits = 0x3, .firstPass = 1, .lastPass = 2 },
+        { .size = 300, .alignment = 256, .memoryTypeBits = 0x3, .firstPass = 2, .lastPass = 4 },
+        { .size = 2000, .alignment = 1024, .memoryTypeBits = 0x3, .firstPass = 3, .lastPass = 3 },
+        { .size = 100, .alignment = 64, .memoryTypeBits = 0x3, .firstPass = 0, .lastPass = 0 },
+    };
+    auto plan = PlanTransientMemory(resources);
+
+    for (uint32 a = 0; a < resources.size(); ++a)
+    {
+        auto& placement = plan.placements[a];
+        REQUIRE(placement.offset % resources[a].alignment == 0);
+        REQUIRE(placement.offset + resources[a].size <= plan.blocks[placement.block].size);
+
+        for (uint32 b = a + 1; b < resources.size(); ++b)
+        {
+            bool alive = resources[a].firstPass <= resources[b].lastPass &&
+                resources[b].firstPass <= resources[a].lastPass;
+
+            if (alive)
+                REQUIRE_FALSE(AddressesOverlap(plan, resources, a, b));
+        }
+    }
+    REQUIRE(plan.stats.allocatedBytes < plan.stats.requestedBytes);
+}
+
+TEST_CASE("Incompatible memory types are not aliased")
+{
+    std::vector<TransientResource> resources = {
+        { .size = 1024, .alignment = 256, .memoryTypeBits = 0x1, .firstPass = 0, .lastPass = 0 },
+        { .size = 1024, .alignment = 256, .memoryTypeBits = 0x2, .firstPass = 1, .lastPass = 1 },
+    };
+    auto plan = PlanTransientMemory(resources);
+
+    REQUIRE(plan.blocks.size() == 2);
+    REQUIRE(plan.stats.allocatedBytes == plan.stats.requestedBytes);
+}
+
+}
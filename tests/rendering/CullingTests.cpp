@@ -0,0 +1,73 @@
+#include "catch2/catch_all.hpp"
+
+#include "rendering/Culling.hpp"
+
+namespace lucent::tests
+{
+
+// Camera at the origin looking down +z, seeing depths between 1 and 100
+static Matrix4 TestViewProjection()
+{
+    return Matrix4::Perspective(kPi / 2.0f, 1.0f, 1.0f, 100.0f);
+}
+
+TEST_CASE("Frustum keeps spheres inside or touching its planes")
+{
+    auto frustum = Frustum(TestViewProjection());
+
+    REQUIRE(frustum.Intersects(Vector3(0.0f, 0.0f, 10.0f), 1.0f));
+    REQUIRE(frustum.Intersects(Vector3(0.0f, 0.0f, 0.5f), 1.0f));
+    REQUIRE(frustum.Intersects(Vector3(0.0f, 0.0f, 100.5f), 1.0f));
+    REQUIRE(frustum.Intersects(Vector3(11.0f, 0.0f, 10.0f), 1.0f));
+}
+
+TEST_CASE("Frustum rejects spheres outside its planes")
+{
+    auto frustum = Frustum(TestViewProjection());
+
+    REQUIRE(!frustum.Intersects(Vector3(0.0f, 0.0f, -10.0f), 1.0f));
+    REQUIRE(!frustum.Intersects(Vector3(0.0f, 0.0f, 0.0f), 0.5f));
+    REQUIRE(!frustum.Intersects(Vector3(0.0f, 0.0f, 102.0f), 1.0f));
+    REQUIRE(!frustum.Intersects(Vector3(20.0f, 0.0f, 10.0f), 1.0f));
+    REQUIRE(!frustum.Intersects(Vector3(0.0f, -20.0f, 10.0f), 1.0f));
+}
+
+TEST_CASE("Frustum ignores depth when not culling by depth")
+{
+    auto frustum = Frustum(Matrix4::Orthographic(10.0f, 10.0f, 10.0f));
+
+    REQUIRE(!frustum.Intersects(Vector3(0.0f, 0.0f, -50.0f), 1.0f));
+    REQUIRE(frustum.Intersects(Vector3(0.0f, 0.0f, -50.0f), 1.0f, false));
+    REQUIRE(!frustum.Intersects(Vector3(20.0f, 0.0f, -50.0f), 1.0f, false));
+}
+
+TEST_CASE("Bounds list culling matches testing each sphere")
+{
+    auto frustum = Frustum(TestViewProjection());
+
+    // Enough spheres to fill several batches and leave a remainder
+    BoundsList bounds;
+    std::vector<uint32> expected;
+    for (uint32 i = 0; i < 103; ++i)
+    {
+        auto center = Vector3((float)(i % 7) * 6.0f - 18.0f, (float)(i % 5) * 8.0f - 16.0f, (float)i - 20.0f);
+        auto radius = (float)(i % 3) + 0.5f;
+        bounds.Add(center, radius);
+
+        if (frustum.Intersects(center, radius))
+            expected.push_back(i);
+    }
+    REQUIRE(bounds.Size() == 103);
+    REQUIRE(!expected.empty());
+    REQUIRE(expected.size() < 103);
+
+    std::vector<uint32> visible;
+    bounds.Cull(frustum, true, visible);
+    REQUIRE(visible == expected);
+
+    bounds.Clear();
+    bounds.Cull(frustum, true, visible);
+    REQUIRE(visible.empty());
+}
+
+}
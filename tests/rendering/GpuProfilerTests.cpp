@@ -0,0 +1,82 @@
+#include "catch2/catch_all.hpp"
+
+#include "rendering/GpuProfiler.hpp"
+
+namespace lucent::tests
+{
+
+static RegionTiming Region(const char* label, double startMs, float durationMs, uint32 depth = 0)
+{
+    return RegionTiming{
+        .label = label,
+        .depth = depth,
+        .startMs = startMs,
+        .durationMs = durationMs
+    };
+}
+
+TEST_CASE("GPU profiler keeps the min, average and max of each pass")
+{
+    GpuProfiler profiler;
+    profiler.AddFrame(0, { Region("Geometry", 100.0, 2.0f), Region("Lighting", 102.0, 1.0f) });
+    profiler.AddFrame(1, { Region("Geometry", 110.0, 4.0f), Region("Lighting", 114.0, 2.0f) });
+    profiler.AddFrame(2, { Region("Geometry", 120.0, 3.0f) });
+
+    auto stats = profiler.GetPassStats();
+    REQUIRE(stats.size() == 2);
+
+    REQUIRE(stats[0].label == "Geometry");
+    REQUIRE(stats[0].numFrames == 3);
+    REQUIRE(stats[0].minMs == 2.0f);
+    REQUIRE(stats[0].avgMs == 3.0f);
+    REQUIRE(stats[0].maxMs == 4.0f);
+
+    REQUIRE(stats[1].label == "Lighting");
+    REQUIRE(stats[1].numFrames == 2);
+    REQUIRE(stats[1].avgMs == 1.5f);
+
+    // Frames span from the start of their first pass to the end of their last
+    REQUIRE(profiler.GetAverageFrameMs() == 4.0f);
+}
+
+TEST_CASE("GPU profiler sums passes executed more than once in a frame")
+{
+    GpuProfiler profiler;
+    profiler.AddFrame(0, { Region("Blur", 0.0, 1.0f), Region("Blur", 1.0, 2.0f) });
+
+    auto stats = profiler.GetPassStats();
+    REQUIRE(stats.size() == 1);
+    REQUIRE(stats[0].maxMs == 3.0f);
+}
+
+TEST_CASE("GPU profiler discards the oldest frames once its history is full")
+{
+    GpuProfiler profiler(2);
+    profiler.AddFrame(0, { Region("Shadows", 0.0, 10.0f) });
+    profiler.AddFrame(1, { Region("Shadows", 20.0, 1.0f) });
+    profiler.AddFrame(2, { Region("Shadows", 40.0, 2.0f) });
+
+    // Frames whose regions weren't timed are ignored
+    profiler.AddFrame(3, {});
+
+    auto stats = profiler.GetPassStats();
+    REQUIRE(stats[0].numFrames == 2);
+    REQUIRE(stats[0].maxMs == 2.0f);
+}
+
+TEST_CASE("GPU profiler dumps timings relative to the start of each frame")
+{
+    GpuProfiler profiler;
+    profiler.AddFrame(7, { Region("Post \"FX\"", 50.0, 0.5f), Region("Bloom", 50.25, 0.25f, 1) });
+
+    auto csv = profiler.DumpCsv();
+    REQUIRE(csv == "frame,pass,depth,start_ms,duration_ms\n"
+                   "7,\"Post \"\"FX\"\"\",0,0.0000,0.5000\n"
+                   "7,\"Bloom\",1,0.2500,0.2500\n");
+
+    auto trace = profiler.DumpChromeTrace();
+    REQUIRE(trace.find("\"name\":\"Post \\\"FX\\\"\"") != std::string::npos);
+    REQUIRE(trace.find("\"ts\":250.000,\"dur\":250.000") != std::string::npos);
+}
+
+}
@@ -0,0 +1,81 @@
+#include "catch2/catch_all.hpp"
+
+#include <cstdlib>
+
+#include "rendering/Engine.hpp"
+#include "rendering/RenderSettings.hpp"
+#include "scene/Camera.hpp"
+#include "scene/Transform.hpp"
+
+namespace lucent::tests
+{
+
+// An empty scene with a camera, a light and a placeholder environment, which is enough for every pass to run
+static void InitEmptyScene(Engine& engine, Scene& scene)
+{
+    auto& settings = engine.GetRenderSettings();
+    auto environmentMap = engine.GetDevice()->CreateTexture(TextureSettings{ .shape = TextureShape::kCube });
+    scene.environment = Environment{
+        .cubeMap = environmentMap,
+        .irradianceMap = environmentMap,
+        .specularMap = environmentMap,
+        .BRDF = settings.defaultBlackTexture
+    };
+
+    scene.mainCamera = scene.CreateEntity();
+    scene.mainCamera.Assign(Camera{
+        .aspectRatio = (float)settings.viewportWidth / (float)settings.viewportHeight
+    });
+    scene.mainCamera.Assign(Transform{ .position = { 0.0f, 2.0f, 2.0f }});
+
+    auto lightPos = Vector3(-0.3, 1.0f, 0.3f);
+    auto light = scene.CreateEntity();
+    light.Assign(DirectionalLight{
+        .color = Color(1.0, 1.0, 1.0, 1.0),
+        .cascades = {
+            { .start = 0.0f, .end = 12.0f },
+            { .start = 10.0f, .end = 32.0f },
+            { .start = 30.0f, .end = 70.0f },
+            { .start = 65.0f, .end = 150.0f }
+        }
+    });
+    light.Assign(Transform{ .position = lightPos });
+    light.SetRotation(Matrix4::Rotation(Matrix4::LookAt(lightPos, Vector3::Zero())));
+    scene.mainDirectionalLight = light;
+}
+
+TEST_CASE("Headless engine renders a frame and reads it back")
+{
+    if (!Engine::IsHeadlessSupported())
+        SKIP("No Vulkan device with a graphics queue is present");
+
+    // Shaders are resolved from the source tree, wherever the tests are run from
+    setenv("LC_SHADER_ROOT", LC_TEST_SHADER_ROOT, 0);
+
+    RenderSettings settings;
+    settings.viewportWidth = 320;
+    settings.viewportHeight = 180;
+    settings.headless = true;
+
+    auto engine = Engine::Init(std::move(settings));
+    REQUIRE(engine->GetDevice()->IsHeadless());
+
+    auto scene = engine->CreateScene();
+    InitEmptyScene(*engine, *scene);
+
+    std::optional<FrameReadback> readback;
+    auto renderer = engine->GetSceneRenderer();
+    renderer->RequestReadback([&](FrameReadback& frame)
+    { readback = std::move(frame); });
+
+    REQUIRE(engine->Update());
+    renderer->FlushReadbacks();
+
+    REQUIRE(readback.has_value());
+    REQUIRE(readback->width == 320);
+    REQUIRE(readback->height == 180);
+    REQUIRE(readback->format == TextureFormat::kRGBA8);
+    REQUIRE(readback->pixels.size() == 320 * 180 * GetTexelSize(TextureFormat::kRGBA8));
+}
+
+}
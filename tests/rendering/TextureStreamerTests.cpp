@@ -0,0 +1,81 @@
+#include "catch2/catch_all.hpp"
+
+#include "rendering/TextureStreamer.hpp"
+
+namespace lucent::tests
+{
+
+static StreamingDemand Demand(uint32 size, uint32 residentBias, uint32 wantedBias, uint32 maxBias,
+    uint64 lastUsedFrame)
+{
+    return StreamingDemand{
+        .width = size,
+        .height = size,
+        .residentBias = residentBias,
+        .wantedBias = wantedBias,
+        .maxBias = maxBias,
+        .lastUsedFrame = lastUsedFrame
+    };
+}
+
+TEST_CASE("Streamed texture bytes include the rest of the mip chain")
+{
+    REQUIRE(GetStreamedTextureBytes(1, 1, 0) == 4);
+    REQUIRE(GetStreamedTextureBytes(4, 1, 0) == (4 + 2 + 1) * 4);
+    REQUIRE(GetStreamedTextureBytes(256, 256, 2) == GetStreamedTextureBytes(64, 64, 0));
+    REQUIRE(GetStreamedTextureBytes(64, 64, 0) == (4096 + 1024 + 256 + 64 + 16 + 4 + 1) * 4);
+}
+
+TEST_CASE("Streaming keeps resident levels while within budget")
+{
+    auto demands = std::vector<StreamingDemand>{
+        Demand(256, 0, 2, 2, 1),
+        Demand(256, 2, 0, 2, 1)
+    };
+
+    auto biases = FitStreamingBudget(demands, ~0ull);
+    REQUIRE(biases == std::vector<uint32>{ 0, 0 });
+}
+
+TEST_CASE("Streaming evicts unwanted levels of the least recently used textures first")
+{
+    auto demands = std::vector<StreamingDemand>{
+        Demand(256, 0, 2, 2, 5),
+        Demand(256, 0, 2, 2, 1),
+        Demand(256, 0, 2, 2, 3)
+    };
+
+    auto budget = 2 * GetStreamedTextureBytes(256, 256, 0) + GetStreamedTextureBytes(256, 256, 2);
+    auto biases = FitStreamingBudget(demands, budget);
+    REQUIRE(biases == std::vector<uint32>{ 0, 2, 0 });
+}
+
+TEST_CASE("Streaming drops the most detailed wanted levels once over budget")
+{
+    auto demands = std::vector<StreamingDemand>{
+        Demand(128, 1, 0, 1, 1),
+        Demand(256, 2, 0, 2, 2)
+    };
+
+    auto budget = 2 * GetStreamedTextureBytes(128, 128, 0);
+    auto biases = FitStreamingBudget(demands, budget);
+    REQUIRE(biases == std::vector<uint32>{ 0, 1 });
+
+    // Ties are broken by dropping from the least recently used texture
+    budget = GetStreamedTextureBytes(128, 128, 0) + GetStreamedTextureBytes(128, 128, 1);
+    biases = FitStreamingBudget(demands, budget);
+    REQUIRE(biases == std::vector<uint32>{ 1, 1 });
+}
+
+TEST_CASE("Streaming never drops the smallest versions")
+{
+    auto demands = std::vector<StreamingDemand>{
+        Demand(256, 0, 0, 2, 1),
+        Demand(64, 0, 0, 0, 1)
+    };
+
+    auto biases = FitStreamingBudget(demands, 0);
+    REQUIRE(biases == std::vector<uint32>{ 2, 0 });
+}
+
+}
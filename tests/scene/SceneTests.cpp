@@ -0,0 +1,62 @@
+#include "catch2/catch_all.hpp"
+
+#include "scene/Scene.hpp"
+#include "scene/Transform.hpp"
+
+namespace lucent::tests
+{
+
+TEST_CASE("Scene records changed entities")
+{
+    Scene scene;
+    auto entity = scene.CreateEntity();
+    auto version = scene.GetVersion();
+
+    SECTION("Creation alone is not a change")
+    {
+        std::vector<EntityID> changed;
+        REQUIRE(scene.GetChangedEntities(version, changed));
+        REQUIRE(changed.empty());
+    }
+
+    SECTION("Assigning, transforming and destroying are changes")
+    {
+        entity.Assign(Transform{});
+        entity.SetPosition(Vector3(1.0f, 2.0f, 3.0f));
+        scene.Destroy(entity);
+
+        std::vector<EntityID> changed;
+        REQUIRE(scene.GetChangedEntities(version, changed));
+        REQUIRE(changed.size() == 3);
+        for (auto id: changed)
+            REQUIRE(id == entity.id);
+        REQUIRE(scene.GetVersion() == version + 3);
+    }
+
+    SECTION("Changes since a later version exclude earlier ones")
+    {
+        auto other = scene.CreateEntity();
+        entity.Assign(Transform{});
+        auto later = scene.GetVersion();
+        other.Assign(Transform{});
+
+        std::vector<EntityID> changed;
+        REQUIRE(scene.GetChangedEntities(later, changed));
+        REQUIRE(changed.size() == 1);
+        REQUIRE(changed[0] == other.id);
+    }
+
+    SECTION("Old changes are eventually dropped")
+    {
+        entity.Assign(Transform{});
+        for (int i = 0; i < 64 * 1024; ++i)
+            entity.SetScale(2.0f);
+
+        std::vector<EntityID> changed;
+        REQUIRE_FALSE(scene.GetChangedEntities(version, changed));
+        REQUIRE(scene.GetChangedEntities(scene.GetVersion(), changed));
+        REQUIRE(changed.empty());
+    }
+}
+
+}